@@ -31,7 +31,16 @@
 /*!
  * @brief Instantiates a new STHS34PF80 class
  */
-Adafruit_STHS34PF80::Adafruit_STHS34PF80() {}
+Adafruit_STHS34PF80::Adafruit_STHS34PF80()
+    : i2c_dev(NULL),
+      generic_dev(NULL),
+      meter_dev(NULL),
+      _clock(Adafruit_STHS34PF80_Clock::system()),
+      _drdy_timeout_ms(STHS34PF80_DRDY_TIMEOUT_MS),
+      _embedded_dirty(0),
+      _embedded_valid(false) {
+  resetBusStats();
+}
 
 /*!
  * @brief Cleans up the STHS34PF80
@@ -40,6 +49,9 @@ Adafruit_STHS34PF80::~Adafruit_STHS34PF80() {
   if (i2c_dev) {
     delete i2c_dev;
   }
+  if (meter_dev) {
+    delete meter_dev;
+  }
 }
 
 /*!
@@ -49,20 +61,33 @@ Adafruit_STHS34PF80::~Adafruit_STHS34PF80() {
  * @return True if initialization was successful, otherwise false
  */
 bool Adafruit_STHS34PF80::begin(uint8_t i2c_addr, TwoWire* wire) {
-  if (i2c_dev) {
-    delete i2c_dev;
+  if (!initDevice(i2c_addr, wire)) {
+    return false;
   }
 
-  i2c_dev = new Adafruit_I2CDevice(i2c_addr, wire);
+  return applyDefaults();
+}
 
-  if (!i2c_dev->begin()) {
+/*!
+ * @brief Initializes the sensor on a caller-provided bus device, such as
+ * the register model of Adafruit_STHS34PF80_Sim
+ * @param device The device, which must outlive this object; its register
+ * callbacks get the STHS34PF80 register address and auto-increment
+ * @return True if initialization was successful, otherwise false
+ */
+bool Adafruit_STHS34PF80::begin(Adafruit_GenericDevice* device) {
+  if (!initDevice(device)) {
     return false;
   }
 
-  if (!isConnected()) {
-    return false;
-  }
+  return applyDefaults();
+}
 
+/*!
+ * @brief Reset the sensor and apply the recommended default settings
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::applyDefaults() {
   if (!reset()) {
     return false;
   }
@@ -87,17 +112,59 @@ bool Adafruit_STHS34PF80::begin(uint8_t i2c_addr, TwoWire* wire) {
   return true;
 }
 
+/*!
+ * @brief Create the I2C device and check the device ID, without touching
+ * the sensor configuration
+ * @param i2c_addr I2C address to use
+ * @param wire The Wire object to be used for I2C connections
+ * @return True if the STHS34PF80 was found, otherwise false
+ */
+bool Adafruit_STHS34PF80::initDevice(uint8_t i2c_addr, TwoWire* wire) {
+  if (i2c_dev) {
+    delete i2c_dev;
+  }
+
+  generic_dev = NULL;
+  i2c_dev = new Adafruit_I2CDevice(i2c_addr, wire);
+
+  if (!i2c_dev->begin()) {
+    return false;
+  }
+
+  return isConnected();
+}
+
+/*!
+ * @brief Use a caller-provided bus device and check the device ID, without
+ * touching the sensor configuration
+ * @param device The device, not owned
+ * @return True if the STHS34PF80 was found, otherwise false
+ */
+bool Adafruit_STHS34PF80::initDevice(Adafruit_GenericDevice* device) {
+  if (i2c_dev) {
+    delete i2c_dev;
+    i2c_dev = NULL;
+  }
+
+  generic_dev = device;
+
+  if (!generic_dev || !generic_dev->begin()) {
+    return false;
+  }
+
+  return isConnected();
+}
+
 /*!
  * @brief Check if the sensor is connected by reading device ID
  * @return True if device ID matches expected value (0xD3), false otherwise
  */
 bool Adafruit_STHS34PF80::isConnected() {
-  if (!i2c_dev) {
+  if (!hasDevice()) {
     return false;
   }
 
-  Adafruit_BusIO_Register chip_id =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_WHO_AM_I, 1);
+  Adafruit_BusIO_Register chip_id = busRegister(STHS34PF80_REG_WHO_AM_I, 1);
 
   return chip_id.read() == 0xD3;
 }
@@ -113,7 +180,7 @@ bool Adafruit_STHS34PF80::reset() {
   }
 
   // Wait for sensor reset to complete
-  delay(5);
+  _clock->delayMillis(STHS34PF80_BOOT_TIME_MS);
 
   // Reset the internal algorithm
   if (!algorithmReset()) {
@@ -123,6 +190,37 @@ bool Adafruit_STHS34PF80::reset() {
   return true;
 }
 
+/*!
+ * @brief Set the clock used for delays and timeouts
+ * @param clock The clock, e.g. an Adafruit_STHS34PF80_SimClock in host
+ * simulations, or NULL to restore the system clock
+ */
+void Adafruit_STHS34PF80::setClock(Adafruit_STHS34PF80_Clock* clock) {
+  _clock = clock ? clock : Adafruit_STHS34PF80_Clock::system();
+}
+
+/*!
+ * @brief Get the clock used for delays and timeouts
+ * @return The clock, never NULL
+ */
+Adafruit_STHS34PF80_Clock* Adafruit_STHS34PF80::getClock() { return _clock; }
+
+/*!
+ * @brief Set how long a safe power-down waits for DRDY before powering down
+ * anyway
+ * @param timeout_ms Timeout in milliseconds (default 1000); about two ODR
+ * periods is enough once the ODR is known
+ */
+void Adafruit_STHS34PF80::setDrdyTimeout(uint32_t timeout_ms) {
+  _drdy_timeout_ms = timeout_ms;
+}
+
+/*!
+ * @brief Get the safe power-down DRDY timeout
+ * @return Timeout in milliseconds
+ */
+uint32_t Adafruit_STHS34PF80::getDrdyTimeout() { return _drdy_timeout_ms; }
+
 /*!
  * @brief Set the motion detection low-pass filter configuration
  * @param config The LPF configuration value
@@ -130,8 +228,7 @@ bool Adafruit_STHS34PF80::reset() {
  */
 bool Adafruit_STHS34PF80::setMotionLowPassFilter(
     sths34pf80_lpf_config_t config) {
-  Adafruit_BusIO_Register lpf1_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_LPF1, 1);
+  Adafruit_BusIO_Register lpf1_reg = busRegister(STHS34PF80_REG_LPF1, 1);
 
   Adafruit_BusIO_RegisterBits lpf_m_bits =
       Adafruit_BusIO_RegisterBits(&lpf1_reg, 3, 0);
@@ -144,8 +241,7 @@ bool Adafruit_STHS34PF80::setMotionLowPassFilter(
  * @return The current LPF configuration value
  */
 sths34pf80_lpf_config_t Adafruit_STHS34PF80::getMotionLowPassFilter() {
-  Adafruit_BusIO_Register lpf1_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_LPF1, 1);
+  Adafruit_BusIO_Register lpf1_reg = busRegister(STHS34PF80_REG_LPF1, 1);
 
   Adafruit_BusIO_RegisterBits lpf_m_bits =
       Adafruit_BusIO_RegisterBits(&lpf1_reg, 3, 0);
@@ -160,8 +256,7 @@ sths34pf80_lpf_config_t Adafruit_STHS34PF80::getMotionLowPassFilter() {
  */
 bool Adafruit_STHS34PF80::setMotionPresenceLowPassFilter(
     sths34pf80_lpf_config_t config) {
-  Adafruit_BusIO_Register lpf1_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_LPF1, 1);
+  Adafruit_BusIO_Register lpf1_reg = busRegister(STHS34PF80_REG_LPF1, 1);
 
   Adafruit_BusIO_RegisterBits lpf_p_m_bits =
       Adafruit_BusIO_RegisterBits(&lpf1_reg, 3, 3);
@@ -174,8 +269,7 @@ bool Adafruit_STHS34PF80::setMotionPresenceLowPassFilter(
  * @return The current LPF configuration value
  */
 sths34pf80_lpf_config_t Adafruit_STHS34PF80::getMotionPresenceLowPassFilter() {
-  Adafruit_BusIO_Register lpf1_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_LPF1, 1);
+  Adafruit_BusIO_Register lpf1_reg = busRegister(STHS34PF80_REG_LPF1, 1);
 
   Adafruit_BusIO_RegisterBits lpf_p_m_bits =
       Adafruit_BusIO_RegisterBits(&lpf1_reg, 3, 3);
@@ -190,8 +284,7 @@ sths34pf80_lpf_config_t Adafruit_STHS34PF80::getMotionPresenceLowPassFilter() {
  */
 bool Adafruit_STHS34PF80::setPresenceLowPassFilter(
     sths34pf80_lpf_config_t config) {
-  Adafruit_BusIO_Register lpf2_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_LPF2, 1);
+  Adafruit_BusIO_Register lpf2_reg = busRegister(STHS34PF80_REG_LPF2, 1);
 
   Adafruit_BusIO_RegisterBits lpf_p_bits =
       Adafruit_BusIO_RegisterBits(&lpf2_reg, 3, 3);
@@ -204,8 +297,7 @@ bool Adafruit_STHS34PF80::setPresenceLowPassFilter(
  * @return The current LPF configuration value
  */
 sths34pf80_lpf_config_t Adafruit_STHS34PF80::getPresenceLowPassFilter() {
-  Adafruit_BusIO_Register lpf2_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_LPF2, 1);
+  Adafruit_BusIO_Register lpf2_reg = busRegister(STHS34PF80_REG_LPF2, 1);
 
   Adafruit_BusIO_RegisterBits lpf_p_bits =
       Adafruit_BusIO_RegisterBits(&lpf2_reg, 3, 3);
@@ -221,8 +313,7 @@ sths34pf80_lpf_config_t Adafruit_STHS34PF80::getPresenceLowPassFilter() {
  */
 bool Adafruit_STHS34PF80::setTemperatureLowPassFilter(
     sths34pf80_lpf_config_t config) {
-  Adafruit_BusIO_Register lpf2_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_LPF2, 1);
+  Adafruit_BusIO_Register lpf2_reg = busRegister(STHS34PF80_REG_LPF2, 1);
 
   Adafruit_BusIO_RegisterBits lpf_a_t_bits =
       Adafruit_BusIO_RegisterBits(&lpf2_reg, 3, 0);
@@ -236,8 +327,7 @@ bool Adafruit_STHS34PF80::setTemperatureLowPassFilter(
  * @return The current LPF configuration value
  */
 sths34pf80_lpf_config_t Adafruit_STHS34PF80::getTemperatureLowPassFilter() {
-  Adafruit_BusIO_Register lpf2_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_LPF2, 1);
+  Adafruit_BusIO_Register lpf2_reg = busRegister(STHS34PF80_REG_LPF2, 1);
 
   Adafruit_BusIO_RegisterBits lpf_a_t_bits =
       Adafruit_BusIO_RegisterBits(&lpf2_reg, 3, 0);
@@ -252,7 +342,7 @@ sths34pf80_lpf_config_t Adafruit_STHS34PF80::getTemperatureLowPassFilter() {
  */
 bool Adafruit_STHS34PF80::setAmbTempAveraging(sths34pf80_avg_t_t config) {
   Adafruit_BusIO_Register avg_trim_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_AVG_TRIM, 1);
+      busRegister(STHS34PF80_REG_AVG_TRIM, 1);
 
   Adafruit_BusIO_RegisterBits avg_t_bits =
       Adafruit_BusIO_RegisterBits(&avg_trim_reg, 2, 4);
@@ -266,7 +356,7 @@ bool Adafruit_STHS34PF80::setAmbTempAveraging(sths34pf80_avg_t_t config) {
  */
 sths34pf80_avg_t_t Adafruit_STHS34PF80::getAmbTempAveraging() {
   Adafruit_BusIO_Register avg_trim_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_AVG_TRIM, 1);
+      busRegister(STHS34PF80_REG_AVG_TRIM, 1);
 
   Adafruit_BusIO_RegisterBits avg_t_bits =
       Adafruit_BusIO_RegisterBits(&avg_trim_reg, 2, 4);
@@ -281,7 +371,7 @@ sths34pf80_avg_t_t Adafruit_STHS34PF80::getAmbTempAveraging() {
  */
 bool Adafruit_STHS34PF80::setObjAveraging(sths34pf80_avg_tmos_t config) {
   Adafruit_BusIO_Register avg_trim_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_AVG_TRIM, 1);
+      busRegister(STHS34PF80_REG_AVG_TRIM, 1);
 
   Adafruit_BusIO_RegisterBits avg_tmos_bits =
       Adafruit_BusIO_RegisterBits(&avg_trim_reg, 3, 0);
@@ -295,7 +385,7 @@ bool Adafruit_STHS34PF80::setObjAveraging(sths34pf80_avg_tmos_t config) {
  */
 sths34pf80_avg_tmos_t Adafruit_STHS34PF80::getObjAveraging() {
   Adafruit_BusIO_Register avg_trim_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_AVG_TRIM, 1);
+      busRegister(STHS34PF80_REG_AVG_TRIM, 1);
 
   Adafruit_BusIO_RegisterBits avg_tmos_bits =
       Adafruit_BusIO_RegisterBits(&avg_trim_reg, 3, 0);
@@ -309,8 +399,7 @@ sths34pf80_avg_tmos_t Adafruit_STHS34PF80::getObjAveraging() {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::setWideGainMode(bool wide_mode) {
-  Adafruit_BusIO_Register ctrl0_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL0, 1);
+  Adafruit_BusIO_Register ctrl0_reg = busRegister(STHS34PF80_REG_CTRL0, 1);
 
   Adafruit_BusIO_RegisterBits gain_bits =
       Adafruit_BusIO_RegisterBits(&ctrl0_reg, 3, 4);
@@ -323,8 +412,7 @@ bool Adafruit_STHS34PF80::setWideGainMode(bool wide_mode) {
  * @return True if in wide mode, false if in default gain mode
  */
 bool Adafruit_STHS34PF80::getWideGainMode() {
-  Adafruit_BusIO_Register ctrl0_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL0, 1);
+  Adafruit_BusIO_Register ctrl0_reg = busRegister(STHS34PF80_REG_CTRL0, 1);
 
   Adafruit_BusIO_RegisterBits gain_bits =
       Adafruit_BusIO_RegisterBits(&ctrl0_reg, 3, 4);
@@ -339,7 +427,7 @@ bool Adafruit_STHS34PF80::getWideGainMode() {
  */
 bool Adafruit_STHS34PF80::setSensitivity(int8_t sensitivity) {
   Adafruit_BusIO_Register sens_data_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_SENS_DATA, 1);
+      busRegister(STHS34PF80_REG_SENS_DATA, 1);
 
   return sens_data_reg.write((uint8_t)sensitivity);
 }
@@ -350,7 +438,7 @@ bool Adafruit_STHS34PF80::setSensitivity(int8_t sensitivity) {
  */
 int8_t Adafruit_STHS34PF80::getSensitivity() {
   Adafruit_BusIO_Register sens_data_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_SENS_DATA, 1);
+      busRegister(STHS34PF80_REG_SENS_DATA, 1);
 
   return (int8_t)sens_data_reg.read();
 }
@@ -361,8 +449,7 @@ int8_t Adafruit_STHS34PF80::getSensitivity() {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::setBlockDataUpdate(bool enable) {
-  Adafruit_BusIO_Register ctrl1_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL1, 1);
+  Adafruit_BusIO_Register ctrl1_reg = busRegister(STHS34PF80_REG_CTRL1, 1);
 
   Adafruit_BusIO_RegisterBits bdu_bit =
       Adafruit_BusIO_RegisterBits(&ctrl1_reg, 1, 4);
@@ -375,8 +462,7 @@ bool Adafruit_STHS34PF80::setBlockDataUpdate(bool enable) {
  * @return True if block data update is enabled, false if disabled
  */
 bool Adafruit_STHS34PF80::getBlockDataUpdate() {
-  Adafruit_BusIO_Register ctrl1_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL1, 1);
+  Adafruit_BusIO_Register ctrl1_reg = busRegister(STHS34PF80_REG_CTRL1, 1);
 
   Adafruit_BusIO_RegisterBits bdu_bit =
       Adafruit_BusIO_RegisterBits(&ctrl1_reg, 1, 4);
@@ -395,11 +481,10 @@ bool Adafruit_STHS34PF80::setOutputDataRate(sths34pf80_odr_t odr) {
   // sths34pf80_avg_trim_t avg_trim;
   // sths34pf80_tmos_odr_t max_odr = STHS34PF80_TMOS_ODR_AT_30Hz;
   // int32_t ret;
-  if (!i2c_dev) {
+  if (!hasDevice()) {
     return false;
   }
 
-  sths34pf80_odr_t max_odr = STHS34PF80_ODR_30_HZ;
   sths34pf80_odr_t current_odr = getOutputDataRate();
 
   // ret = sths34pf80_read_reg(ctx, STHS34PF80_CTRL1, (uint8_t *)&ctrl1, 1);
@@ -407,7 +492,31 @@ bool Adafruit_STHS34PF80::setOutputDataRate(sths34pf80_odr_t odr) {
   // {
   //   ret = sths34pf80_read_reg(ctx, STHS34PF80_AVG_TRIM, (uint8_t *)&avg_trim,
   //   1);
-  sths34pf80_avg_tmos_t avg_tmos = getObjAveraging();
+  sths34pf80_odr_t max_odr = maxOutputDataRate(getObjAveraging());
+
+  // if (ret == 0)
+  // {
+  //   if (val > max_odr)
+  //   {
+  //     return -1;
+  //   }
+  if (odr > max_odr) {
+    return false; // Requested ODR exceeds maximum for current averaging setting
+  }
+
+  //   ret = sths34pf80_tmos_odr_check_safe_set(ctx, ctrl1, (uint8_t)val);
+  // }
+  return safeSetOutputDataRate(current_odr, odr);
+}
+
+/*!
+ * @brief Highest output data rate allowed for an object averaging setting
+ * @param avg_tmos The object temperature averaging value
+ * @return The maximum output data rate for that averaging
+ */
+sths34pf80_odr_t Adafruit_STHS34PF80::maxOutputDataRate(
+    sths34pf80_avg_tmos_t avg_tmos) {
+  sths34pf80_odr_t max_odr = STHS34PF80_ODR_30_HZ;
 
   //   switch(avg_trim.avg_tmos)
   //   {
@@ -456,19 +565,79 @@ bool Adafruit_STHS34PF80::setOutputDataRate(sths34pf80_odr_t odr) {
       break;
   }
 
-  // if (ret == 0)
-  // {
-  //   if (val > max_odr)
-  //   {
-  //     return -1;
-  //   }
-  if (odr > max_odr) {
-    return false; // Requested ODR exceeds maximum for current averaging setting
+  return max_odr;
+}
+
+/*!
+ * @brief Check that a profile only holds in-range values and that its ODR is
+ * reachable with its object averaging
+ * @param profile The profile to validate
+ * @return True if applyProfile() would accept the profile, false otherwise
+ */
+bool Adafruit_STHS34PF80::isValidProfile(const sths34pf80_profile_t& profile) {
+  if (profile.odr > STHS34PF80_ODR_30_HZ ||
+      profile.avg_tmos > STHS34PF80_AVG_TMOS_2048 ||
+      profile.avg_t > STHS34PF80_AVG_T_1 ||
+      profile.int_signal > STHS34PF80_INT_OR || profile.int_mask > 0x07) {
+    return false;
   }
 
-  //   ret = sths34pf80_tmos_odr_check_safe_set(ctx, ctrl1, (uint8_t)val);
-  // }
-  return safeSetOutputDataRate(current_odr, odr);
+  return profile.odr <= maxOutputDataRate(profile.avg_tmos);
+}
+
+/*!
+ * @brief Apply averaging, interrupt routing and ODR in a single pass
+ *
+ * CTRL1..CTRL3 and AVG_TRIM are read once, only registers whose value
+ * actually changes are written back, and the safe power-down / algorithm
+ * reset sequence runs only when the ODR or the averaging changes.
+ * INT polarity and output type are left untouched.
+ * @param profile The profile to apply
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::applyProfile(const sths34pf80_profile_t& profile) {
+  if (!hasDevice() || !isValidProfile(profile)) {
+    return false;
+  }
+
+  uint8_t ctrl[3]; // CTRL1, CTRL2, CTRL3
+  uint8_t avg_trim;
+  if (!readRegisters(STHS34PF80_REG_CTRL1, ctrl, 3) ||
+      !readRegisters(STHS34PF80_REG_AVG_TRIM, &avg_trim, 1)) {
+    return false;
+  }
+
+  sths34pf80_odr_t current_odr = (sths34pf80_odr_t)(ctrl[0] & 0x0F);
+
+  uint8_t new_avg_trim = (avg_trim & ~0x37) | ((profile.avg_t & 0x03) << 4) |
+                         (profile.avg_tmos & 0x07);
+  uint8_t new_ctrl3 = (ctrl[2] & 0xC0) | ((profile.int_mask & 0x07) << 3) |
+                      (profile.int_latched ? 0x04 : 0x00) |
+                      (profile.int_signal & 0x03);
+
+  // Averaging is only changed while the sensor is powered down
+  if (new_avg_trim != avg_trim || current_odr != profile.odr) {
+    if (!safeSetOutputDataRate(current_odr, STHS34PF80_ODR_POWER_DOWN)) {
+      return false;
+    }
+    current_odr = STHS34PF80_ODR_POWER_DOWN;
+
+    if (new_avg_trim != avg_trim &&
+        !writeRegisters(STHS34PF80_REG_AVG_TRIM, &new_avg_trim, 1)) {
+      return false;
+    }
+  }
+
+  if (new_ctrl3 != ctrl[2] &&
+      !writeRegisters(STHS34PF80_REG_CTRL3, &new_ctrl3, 1)) {
+    return false;
+  }
+
+  if (current_odr != profile.odr) {
+    return safeSetOutputDataRate(current_odr, profile.odr);
+  }
+
+  return true;
 }
 
 /*!
@@ -476,8 +645,7 @@ bool Adafruit_STHS34PF80::setOutputDataRate(sths34pf80_odr_t odr) {
  * @return The current output data rate value
  */
 sths34pf80_odr_t Adafruit_STHS34PF80::getOutputDataRate() {
-  Adafruit_BusIO_Register ctrl1_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL1, 1);
+  Adafruit_BusIO_Register ctrl1_reg = busRegister(STHS34PF80_REG_CTRL1, 1);
 
   Adafruit_BusIO_RegisterBits odr_bits =
       Adafruit_BusIO_RegisterBits(&ctrl1_reg, 4, 0);
@@ -490,12 +658,13 @@ sths34pf80_odr_t Adafruit_STHS34PF80::getOutputDataRate() {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::rebootOTPmemory() {
-  Adafruit_BusIO_Register ctrl2_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL2, 1);
+  Adafruit_BusIO_Register ctrl2_reg = busRegister(STHS34PF80_REG_CTRL2, 1);
 
   Adafruit_BusIO_RegisterBits boot_bit =
       Adafruit_BusIO_RegisterBits(&ctrl2_reg, 1, 7);
 
+  // The reboot restores the embedded defaults behind the shadow's back
+  invalidateEmbeddedShadow();
   return boot_bit.write(1);
 }
 
@@ -505,8 +674,7 @@ bool Adafruit_STHS34PF80::rebootOTPmemory() {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::enableEmbeddedFuncPage(bool enable) {
-  Adafruit_BusIO_Register ctrl2_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL2, 1);
+  Adafruit_BusIO_Register ctrl2_reg = busRegister(STHS34PF80_REG_CTRL2, 1);
 
   Adafruit_BusIO_RegisterBits func_cfg_access_bit =
       Adafruit_BusIO_RegisterBits(&ctrl2_reg, 1, 4);
@@ -519,8 +687,7 @@ bool Adafruit_STHS34PF80::enableEmbeddedFuncPage(bool enable) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::triggerOneshot() {
-  Adafruit_BusIO_Register ctrl2_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL2, 1);
+  Adafruit_BusIO_Register ctrl2_reg = busRegister(STHS34PF80_REG_CTRL2, 1);
 
   Adafruit_BusIO_RegisterBits oneshot_bit =
       Adafruit_BusIO_RegisterBits(&ctrl2_reg, 1, 0);
@@ -534,8 +701,7 @@ bool Adafruit_STHS34PF80::triggerOneshot() {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::setIntPolarity(bool active_low) {
-  Adafruit_BusIO_Register ctrl3_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL3, 1);
+  Adafruit_BusIO_Register ctrl3_reg = busRegister(STHS34PF80_REG_CTRL3, 1);
 
   Adafruit_BusIO_RegisterBits int_h_l_bit =
       Adafruit_BusIO_RegisterBits(&ctrl3_reg, 1, 7);
@@ -549,8 +715,7 @@ bool Adafruit_STHS34PF80::setIntPolarity(bool active_low) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::setIntOpenDrain(bool open_drain) {
-  Adafruit_BusIO_Register ctrl3_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL3, 1);
+  Adafruit_BusIO_Register ctrl3_reg = busRegister(STHS34PF80_REG_CTRL3, 1);
 
   Adafruit_BusIO_RegisterBits pp_od_bit =
       Adafruit_BusIO_RegisterBits(&ctrl3_reg, 1, 6);
@@ -564,8 +729,7 @@ bool Adafruit_STHS34PF80::setIntOpenDrain(bool open_drain) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::setIntLatched(bool latched) {
-  Adafruit_BusIO_Register ctrl3_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL3, 1);
+  Adafruit_BusIO_Register ctrl3_reg = busRegister(STHS34PF80_REG_CTRL3, 1);
 
   Adafruit_BusIO_RegisterBits int_latched_bit =
       Adafruit_BusIO_RegisterBits(&ctrl3_reg, 1, 2);
@@ -580,8 +744,7 @@ bool Adafruit_STHS34PF80::setIntLatched(bool latched) {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::setIntMask(uint8_t mask) {
-  Adafruit_BusIO_Register ctrl3_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL3, 1);
+  Adafruit_BusIO_Register ctrl3_reg = busRegister(STHS34PF80_REG_CTRL3, 1);
 
   Adafruit_BusIO_RegisterBits int_mask_bits =
       Adafruit_BusIO_RegisterBits(&ctrl3_reg, 3, 3);
@@ -595,8 +758,7 @@ bool Adafruit_STHS34PF80::setIntMask(uint8_t mask) {
  * TAMB_SHOCK_FLAG)
  */
 uint8_t Adafruit_STHS34PF80::getIntMask() {
-  Adafruit_BusIO_Register ctrl3_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL3, 1);
+  Adafruit_BusIO_Register ctrl3_reg = busRegister(STHS34PF80_REG_CTRL3, 1);
 
   Adafruit_BusIO_RegisterBits int_mask_bits =
       Adafruit_BusIO_RegisterBits(&ctrl3_reg, 3, 3);
@@ -610,8 +772,7 @@ uint8_t Adafruit_STHS34PF80::getIntMask() {
  * @return True if successful, false otherwise
  */
 bool Adafruit_STHS34PF80::setIntSignal(sths34pf80_int_signal_t signal) {
-  Adafruit_BusIO_Register ctrl3_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL3, 1);
+  Adafruit_BusIO_Register ctrl3_reg = busRegister(STHS34PF80_REG_CTRL3, 1);
 
   Adafruit_BusIO_RegisterBits ien_bits =
       Adafruit_BusIO_RegisterBits(&ctrl3_reg, 2, 0);
@@ -624,8 +785,7 @@ bool Adafruit_STHS34PF80::setIntSignal(sths34pf80_int_signal_t signal) {
  * @return Current interrupt signal type
  */
 sths34pf80_int_signal_t Adafruit_STHS34PF80::getIntSignal() {
-  Adafruit_BusIO_Register ctrl3_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL3, 1);
+  Adafruit_BusIO_Register ctrl3_reg = busRegister(STHS34PF80_REG_CTRL3, 1);
 
   Adafruit_BusIO_RegisterBits ien_bits =
       Adafruit_BusIO_RegisterBits(&ctrl3_reg, 2, 0);
@@ -638,8 +798,7 @@ sths34pf80_int_signal_t Adafruit_STHS34PF80::getIntSignal() {
  * @return True if new data is available, false otherwise
  */
 bool Adafruit_STHS34PF80::isDataReady() {
-  Adafruit_BusIO_Register status_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_STATUS, 1);
+  Adafruit_BusIO_Register status_reg = busRegister(STHS34PF80_REG_STATUS, 1);
 
   Adafruit_BusIO_RegisterBits drdy_bit =
       Adafruit_BusIO_RegisterBits(&status_reg, 1, 2);
@@ -653,7 +812,7 @@ bool Adafruit_STHS34PF80::isDataReady() {
  */
 bool Adafruit_STHS34PF80::isPresence() {
   Adafruit_BusIO_Register func_status_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_FUNC_STATUS, 1);
+      busRegister(STHS34PF80_REG_FUNC_STATUS, 1);
 
   Adafruit_BusIO_RegisterBits pres_flag_bit =
       Adafruit_BusIO_RegisterBits(&func_status_reg, 1, 2);
@@ -667,7 +826,7 @@ bool Adafruit_STHS34PF80::isPresence() {
  */
 bool Adafruit_STHS34PF80::isMotion() {
   Adafruit_BusIO_Register func_status_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_FUNC_STATUS, 1);
+      busRegister(STHS34PF80_REG_FUNC_STATUS, 1);
 
   Adafruit_BusIO_RegisterBits mot_flag_bit =
       Adafruit_BusIO_RegisterBits(&func_status_reg, 1, 1);
@@ -681,7 +840,7 @@ bool Adafruit_STHS34PF80::isMotion() {
  */
 bool Adafruit_STHS34PF80::isTempShock() {
   Adafruit_BusIO_Register func_status_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_FUNC_STATUS, 1);
+      busRegister(STHS34PF80_REG_FUNC_STATUS, 1);
 
   Adafruit_BusIO_RegisterBits tamb_shock_flag_bit =
       Adafruit_BusIO_RegisterBits(&func_status_reg, 1, 0);
@@ -695,7 +854,7 @@ bool Adafruit_STHS34PF80::isTempShock() {
  */
 int16_t Adafruit_STHS34PF80::readObjectTemperature() {
   Adafruit_BusIO_Register tobj_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_TOBJECT_L, 2, LSBFIRST);
+      busRegister(STHS34PF80_REG_TOBJECT_L, 2, LSBFIRST);
 
   return (int16_t)tobj_reg.read();
 }
@@ -706,7 +865,7 @@ int16_t Adafruit_STHS34PF80::readObjectTemperature() {
  */
 float Adafruit_STHS34PF80::readAmbientTemperature() {
   Adafruit_BusIO_Register tamb_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_TAMBIENT_L, 2, LSBFIRST);
+      busRegister(STHS34PF80_REG_TAMBIENT_L, 2, LSBFIRST);
 
   int16_t raw_temp = (int16_t)tamb_reg.read();
   return raw_temp / 100.0f;
@@ -718,7 +877,7 @@ float Adafruit_STHS34PF80::readAmbientTemperature() {
  */
 int16_t Adafruit_STHS34PF80::readCompensatedObjectTemperature() {
   Adafruit_BusIO_Register tobj_comp_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_TOBJ_COMP_L, 2, LSBFIRST);
+      busRegister(STHS34PF80_REG_TOBJ_COMP_L, 2, LSBFIRST);
 
   return (int16_t)tobj_comp_reg.read();
 }
@@ -729,7 +888,7 @@ int16_t Adafruit_STHS34PF80::readCompensatedObjectTemperature() {
  */
 int16_t Adafruit_STHS34PF80::readPresence() {
   Adafruit_BusIO_Register tpres_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_TPRESENCE_L, 2, LSBFIRST);
+      busRegister(STHS34PF80_REG_TPRESENCE_L, 2, LSBFIRST);
 
   return (int16_t)tpres_reg.read();
 }
@@ -740,7 +899,7 @@ int16_t Adafruit_STHS34PF80::readPresence() {
  */
 int16_t Adafruit_STHS34PF80::readMotion() {
   Adafruit_BusIO_Register tmot_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_TMOTION_L, 2, LSBFIRST);
+      busRegister(STHS34PF80_REG_TMOTION_L, 2, LSBFIRST);
 
   return (int16_t)tmot_reg.read();
 }
@@ -750,12 +909,495 @@ int16_t Adafruit_STHS34PF80::readMotion() {
  * @return 16-bit signed ambient temperature shock detection value
  */
 int16_t Adafruit_STHS34PF80::readTempShock() {
-  Adafruit_BusIO_Register tamb_shock_reg = Adafruit_BusIO_Register(
-      i2c_dev, STHS34PF80_REG_TAMB_SHOCK_L, 2, LSBFIRST);
+  Adafruit_BusIO_Register tamb_shock_reg =
+      busRegister(STHS34PF80_REG_TAMB_SHOCK_L, 2, LSBFIRST);
 
   return (int16_t)tamb_shock_reg.read();
 }
 
+/*!
+ * @brief Read the function status flags in one transaction
+ * @note Reading FUNC_STATUS clears the flags, the DRDY bit and a latched INT
+ * @return Flag bits (STHS34PF80_PRES_FLAG, STHS34PF80_MOT_FLAG,
+ * STHS34PF80_TAMB_SHOCK_FLAG)
+ */
+uint8_t Adafruit_STHS34PF80::readFuncStatus() {
+  Adafruit_BusIO_Register func_status_reg =
+      busRegister(STHS34PF80_REG_FUNC_STATUS, 1);
+
+  return func_status_reg.read() & 0x07;
+}
+
+/*!
+ * @brief Read every output register in two auto-increment bursts
+ *
+ * FUNC_STATUS..TAMBIENT (0x25-0x29) and TOBJ_COMP..TAMB_SHOCK (0x38-0x3F)
+ * are read in one transaction each instead of one per value.
+ * @note Reading FUNC_STATUS clears the flags, the DRDY bit and a latched INT
+ * @param sample Destination for the sample
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::readSample(sths34pf80_sample_t* sample) {
+  uint8_t status[5];
+  uint8_t outputs[8];
+
+  if (!sample || !readRegisters(STHS34PF80_REG_FUNC_STATUS, status, 5) ||
+      !readRegisters(STHS34PF80_REG_TOBJ_COMP_L, outputs, 8)) {
+    return false;
+  }
+
+  sample->flags = status[0] & 0x07;
+  sample->object = (int16_t)(status[1] | (status[2] << 8));
+  sample->ambient = (int16_t)(status[3] | (status[4] << 8));
+  sample->obj_comp = (int16_t)(outputs[0] | (outputs[1] << 8));
+  sample->presence = (int16_t)(outputs[2] | (outputs[3] << 8));
+  sample->motion = (int16_t)(outputs[4] | (outputs[5] << 8));
+  sample->temp_shock = (int16_t)(outputs[6] | (outputs[7] << 8));
+
+  return true;
+}
+
+/*!
+ * @brief Check whether a bus device has been set up
+ * @return True after initDevice(), false before
+ */
+bool Adafruit_STHS34PF80::hasDevice() {
+  return i2c_dev || generic_dev;
+}
+
+/*!
+ * @brief Create a register on whichever bus device is in use
+ * @param reg Register address
+ * @param width Register width in bytes
+ * @param byteorder Byte order of multi-byte registers
+ * @return The register
+ */
+Adafruit_BusIO_Register Adafruit_STHS34PF80::busRegister(uint8_t reg,
+                                                         uint8_t width,
+                                                         uint8_t byteorder) {
+  if (meter_dev) {
+    return Adafruit_BusIO_Register(meter_dev, reg, width, byteorder);
+  }
+  if (generic_dev) {
+    return Adafruit_BusIO_Register(generic_dev, reg, width, byteorder);
+  }
+  return Adafruit_BusIO_Register(i2c_dev, reg, width, byteorder);
+}
+
+/*!
+ * @brief Count every bus transaction from now on, for energy accounting
+ *
+ * While enabled, register access goes through a counting device in front
+ * of the I2C or generic device, at the cost of one extra indirect call per
+ * transaction.
+ * @param enable True to count, false to go straight to the bus again
+ * @return True if successful, false if out of memory
+ */
+bool Adafruit_STHS34PF80::enableBusAccounting(bool enable) {
+  if (enable && !meter_dev) {
+    meter_dev = new Adafruit_GenericDevice(this, meterRead, meterWrite,
+                                           meterReadRegister,
+                                           meterWriteRegister);
+    return meter_dev != NULL;
+  }
+  if (!enable && meter_dev) {
+    delete meter_dev;
+    meter_dev = NULL;
+  }
+  return true;
+}
+
+/*!
+ * @brief Get the bus traffic counted since the last resetBusStats()
+ * @param stats Set to the counters
+ */
+void Adafruit_STHS34PF80::getBusStats(sths34pf80_bus_stats_t* stats) {
+  if (stats) {
+    *stats = _bus_stats;
+  }
+}
+
+/*!
+ * @brief Clear the bus traffic counters
+ */
+void Adafruit_STHS34PF80::resetBusStats() {
+  memset(&_bus_stats, 0, sizeof(_bus_stats));
+}
+
+/*!
+ * @brief Add one transaction to the bus counters
+ * @param len Data bytes
+ * @param prefix_len Register address bytes sent before the data
+ * @param read True for a read, which needs a repeated start
+ */
+void Adafruit_STHS34PF80::countTransfer(uint16_t len, uint8_t prefix_len,
+                                        bool read) {
+  _bus_stats.transactions++;
+  _bus_stats.bytes += len;
+  // 9 bits per byte with the ACK, one per start/stop; a register read adds
+  // the repeated start and the second device address byte
+  uint32_t bytes = 1 + prefix_len + len + (read && prefix_len ? 1 : 0);
+  _bus_stats.bits += bytes * 9 + (read && prefix_len ? 3 : 2);
+}
+
+/*!
+ * @brief Counting device raw read, forwarded to the real device
+ * @param obj The driver
+ * @param buffer Destination
+ * @param len Number of bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::meterRead(void* obj, uint8_t* buffer, size_t len) {
+  Adafruit_STHS34PF80* self = (Adafruit_STHS34PF80*)obj;
+  self->countTransfer(len, 0, true);
+  if (self->generic_dev) {
+    return self->generic_dev->read(buffer, len);
+  }
+  return self->i2c_dev && self->i2c_dev->read(buffer, len);
+}
+
+/*!
+ * @brief Counting device raw write, forwarded to the real device
+ * @param obj The driver
+ * @param buffer Bytes to write
+ * @param len Number of bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::meterWrite(void* obj, const uint8_t* buffer,
+                                     size_t len) {
+  Adafruit_STHS34PF80* self = (Adafruit_STHS34PF80*)obj;
+  self->countTransfer(len, 0, false);
+  if (self->generic_dev) {
+    return self->generic_dev->write(buffer, len);
+  }
+  return self->i2c_dev && self->i2c_dev->write(buffer, len);
+}
+
+/*!
+ * @brief Counting device register read, forwarded to the real device
+ * @param obj The driver
+ * @param addr_buf Register address
+ * @param addrsiz Register address length
+ * @param data Destination
+ * @param datalen Number of bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::meterReadRegister(void* obj, uint8_t* addr_buf,
+                                            uint8_t addrsiz, uint8_t* data,
+                                            uint16_t datalen) {
+  Adafruit_STHS34PF80* self = (Adafruit_STHS34PF80*)obj;
+  self->countTransfer(datalen, addrsiz, true);
+  if (self->generic_dev) {
+    return self->generic_dev->readRegister(addr_buf, addrsiz, data, datalen);
+  }
+  return self->i2c_dev &&
+         self->i2c_dev->write_then_read(addr_buf, addrsiz, data, datalen);
+}
+
+/*!
+ * @brief Counting device register write, forwarded to the real device
+ * @param obj The driver
+ * @param addr_buf Register address
+ * @param addrsiz Register address length
+ * @param data Bytes to write
+ * @param datalen Number of bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::meterWriteRegister(void* obj, uint8_t* addr_buf,
+                                             uint8_t addrsiz,
+                                             const uint8_t* data,
+                                             uint16_t datalen) {
+  Adafruit_STHS34PF80* self = (Adafruit_STHS34PF80*)obj;
+  self->countTransfer(datalen, addrsiz, false);
+  if (self->generic_dev) {
+    return self->generic_dev->writeRegister(addr_buf, addrsiz, data,
+                                            datalen);
+  }
+  return self->i2c_dev &&
+         self->i2c_dev->write(data, datalen, true, addr_buf, addrsiz);
+}
+
+/*!
+ * @brief Read consecutive main bank registers in one auto-increment burst
+ * @param reg First register address
+ * @param buffer Destination for the register values
+ * @param len Number of registers to read
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::readRegisters(uint8_t reg, uint8_t* buffer,
+                                        uint8_t len) {
+  if (!hasDevice()) {
+    return false;
+  }
+
+  Adafruit_BusIO_Register burst_regs = busRegister(reg, 1);
+
+  return burst_regs.read(buffer, len);
+}
+
+/*!
+ * @brief Write consecutive main bank registers in one auto-increment burst
+ * @param reg First register address
+ * @param buffer Register values to write
+ * @param len Number of registers to write
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::writeRegisters(uint8_t reg, uint8_t* buffer,
+                                         uint8_t len) {
+  if (!hasDevice()) {
+    return false;
+  }
+
+  Adafruit_BusIO_Register burst_regs = busRegister(reg, 1);
+
+  return burst_regs.write(buffer, len);
+}
+
+/*!
+ * @brief Read the main register bank, and optionally the embedded bank,
+ * in the fewest auto-increment bursts
+ *
+ * The main bank takes two bursts, 0x0C-0x24 and 0x26-0x3F, skipping
+ * FUNC_STATUS so the dump does not clear the flags or a latched INT. The
+ * embedded bank needs the page access sequence, which powers the sensor
+ * down briefly and resets the detection algorithm.
+ * @param dump Set to the register values
+ * @param embedded True to also read the embedded bank
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::dumpRegisters(sths34pf80_dump_t* dump,
+                                        bool embedded) {
+  if (!dump) {
+    return false;
+  }
+
+  const uint8_t status = STHS34PF80_REG_FUNC_STATUS - STHS34PF80_DUMP_FIRST_REG;
+  dump->main[status] = 0;
+  dump->has_embedded = false;
+  if (!readRegisters(STHS34PF80_DUMP_FIRST_REG, dump->main, status) ||
+      !readRegisters(STHS34PF80_REG_FUNC_STATUS + 1, &dump->main[status + 1],
+                     STHS34PF80_DUMP_LEN - status - 1)) {
+    return false;
+  }
+
+  if (embedded) {
+    if (!readEmbeddedFunction(STHS34PF80_EMBEDDED_PRESENCE_THS,
+                              dump->embedded, STHS34PF80_EMBEDDED_DUMP_LEN)) {
+      return false;
+    }
+    dump->has_embedded = true;
+  }
+  return true;
+}
+
+/*!
+ * @brief Read the configuration integrity hash in one burst (LPF1 through
+ * CTRL3), for comparing against configHash() of the expected configuration
+ * @param hash Set to the hash
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::readConfigHash(uint32_t* hash) {
+  sths34pf80_dump_t dump;
+  sths34pf80_device_config_t config;
+
+  if (!hash) {
+    return false;
+  }
+  memset(&dump, 0, sizeof(dump));
+  if (!readRegisters(STHS34PF80_DUMP_FIRST_REG, dump.main,
+                     STHS34PF80_REG_CTRL3 - STHS34PF80_DUMP_FIRST_REG + 1)) {
+    return false;
+  }
+
+  decodeDump(dump, &config);
+  *hash = configHash(config);
+  return true;
+}
+
+/*!
+ * @brief Get a main bank register value from a dump
+ * @param dump The dump
+ * @param reg Register address, 0x0C to 0x3F
+ * @return The register value
+ */
+static uint8_t dumpReg(const sths34pf80_dump_t& dump, uint8_t reg) {
+  return dump.main[reg - STHS34PF80_DUMP_FIRST_REG];
+}
+
+/*!
+ * @brief Decode a register dump into the device configuration
+ * @param dump The dump
+ * @param config Set to the configuration
+ * @return False if config is NULL
+ */
+bool Adafruit_STHS34PF80::decodeDump(const sths34pf80_dump_t& dump,
+                                     sths34pf80_device_config_t* config) {
+  if (!config) {
+    return false;
+  }
+
+  uint8_t lpf1 = dumpReg(dump, STHS34PF80_REG_LPF1);
+  uint8_t lpf2 = dumpReg(dump, STHS34PF80_REG_LPF2);
+  uint8_t avg_trim = dumpReg(dump, STHS34PF80_REG_AVG_TRIM);
+  uint8_t ctrl1 = dumpReg(dump, STHS34PF80_REG_CTRL1);
+  uint8_t ctrl3 = dumpReg(dump, STHS34PF80_REG_CTRL3);
+
+  config->acquisition.odr = (sths34pf80_odr_t)(ctrl1 & 0x0F);
+  config->acquisition.avg_tmos = (sths34pf80_avg_tmos_t)(avg_trim & 0x07);
+  config->acquisition.avg_t = (sths34pf80_avg_t_t)((avg_trim >> 4) & 0x03);
+  config->acquisition.lpf_m = (sths34pf80_lpf_config_t)(lpf1 & 0x07);
+  config->acquisition.lpf_p_m = (sths34pf80_lpf_config_t)((lpf1 >> 3) & 0x07);
+  config->acquisition.lpf_p = (sths34pf80_lpf_config_t)((lpf2 >> 3) & 0x07);
+  config->acquisition.lpf_a_t = (sths34pf80_lpf_config_t)(lpf2 & 0x07);
+  config->wide_gain = (dumpReg(dump, STHS34PF80_REG_CTRL0) & 0x70) == 0x00;
+  config->block_data_update = ctrl1 & 0x10;
+  config->sensitivity = (int8_t)dumpReg(dump, STHS34PF80_REG_SENS_DATA);
+  config->int_signal = (sths34pf80_int_signal_t)(ctrl3 & 0x03);
+  config->int_mask = (ctrl3 >> 3) & 0x07;
+  config->int_latched = ctrl3 & 0x04;
+  config->int_active_low = ctrl3 & 0x80;
+  config->int_open_drain = ctrl3 & 0x40;
+
+  const uint8_t* e = dump.embedded;
+  config->has_embedded = dump.has_embedded;
+  config->presence_threshold = dump.has_embedded ? e[0] | (e[1] << 8) : 0;
+  config->motion_threshold = dump.has_embedded ? e[2] | (e[3] << 8) : 0;
+  config->tamb_shock_threshold = dump.has_embedded ? e[4] | (e[5] << 8) : 0;
+  config->motion_hysteresis = dump.has_embedded ? e[6] : 0;
+  config->presence_hysteresis = dump.has_embedded ? e[7] : 0;
+  config->algo_config = dump.has_embedded ? e[8] : 0;
+  config->tamb_shock_hysteresis = dump.has_embedded ? e[9] : 0;
+  return true;
+}
+
+/*!
+ * @brief Compare a decoded configuration against the expected one
+ * @param actual Configuration read from the sensor
+ * @param expected Expected configuration; embedded fields are only compared
+ * if both have them
+ * @return STHS34PF80_DIFF_* bits of the fields that differ, 0 if none
+ */
+uint32_t Adafruit_STHS34PF80::diffConfig(
+    const sths34pf80_device_config_t& actual,
+    const sths34pf80_device_config_t& expected) {
+  const sths34pf80_config_t& a = actual.acquisition;
+  const sths34pf80_config_t& x = expected.acquisition;
+  uint32_t diff = 0;
+
+  diff |= a.odr != x.odr ? STHS34PF80_DIFF_ODR : 0;
+  diff |= a.avg_tmos != x.avg_tmos ? STHS34PF80_DIFF_AVG_TMOS : 0;
+  diff |= a.avg_t != x.avg_t ? STHS34PF80_DIFF_AVG_T : 0;
+  diff |= a.lpf_m != x.lpf_m ? STHS34PF80_DIFF_LPF_M : 0;
+  diff |= a.lpf_p_m != x.lpf_p_m ? STHS34PF80_DIFF_LPF_P_M : 0;
+  diff |= a.lpf_p != x.lpf_p ? STHS34PF80_DIFF_LPF_P : 0;
+  diff |= a.lpf_a_t != x.lpf_a_t ? STHS34PF80_DIFF_LPF_A_T : 0;
+  diff |= actual.wide_gain != expected.wide_gain ? STHS34PF80_DIFF_WIDE_GAIN
+                                                 : 0;
+  diff |= actual.block_data_update != expected.block_data_update
+              ? STHS34PF80_DIFF_BDU
+              : 0;
+  diff |= actual.sensitivity != expected.sensitivity
+              ? STHS34PF80_DIFF_SENSITIVITY
+              : 0;
+  diff |= actual.int_signal != expected.int_signal ? STHS34PF80_DIFF_INT_SIGNAL
+                                                   : 0;
+  diff |= actual.int_mask != expected.int_mask ? STHS34PF80_DIFF_INT_MASK : 0;
+  diff |= actual.int_latched != expected.int_latched
+              ? STHS34PF80_DIFF_INT_LATCHED
+              : 0;
+  diff |= actual.int_active_low != expected.int_active_low
+              ? STHS34PF80_DIFF_INT_POLARITY
+              : 0;
+  diff |= actual.int_open_drain != expected.int_open_drain
+              ? STHS34PF80_DIFF_INT_OPEN_DRAIN
+              : 0;
+
+  if (actual.has_embedded && expected.has_embedded) {
+    diff |= actual.presence_threshold != expected.presence_threshold
+                ? STHS34PF80_DIFF_PRESENCE_THS
+                : 0;
+    diff |= actual.motion_threshold != expected.motion_threshold
+                ? STHS34PF80_DIFF_MOTION_THS
+                : 0;
+    diff |= actual.tamb_shock_threshold != expected.tamb_shock_threshold
+                ? STHS34PF80_DIFF_TAMB_SHOCK_THS
+                : 0;
+    diff |= actual.motion_hysteresis != expected.motion_hysteresis
+                ? STHS34PF80_DIFF_HYST_MOTION
+                : 0;
+    diff |= actual.presence_hysteresis != expected.presence_hysteresis
+                ? STHS34PF80_DIFF_HYST_PRESENCE
+                : 0;
+    diff |= actual.algo_config != expected.algo_config
+                ? STHS34PF80_DIFF_ALGO_CONFIG
+                : 0;
+    diff |= actual.tamb_shock_hysteresis != expected.tamb_shock_hysteresis
+                ? STHS34PF80_DIFF_HYST_TAMB_SHOCK
+                : 0;
+  }
+  return diff;
+}
+
+/*!
+ * @brief Compare a decoded configuration against an acquisition profile
+ * @param actual Configuration read from the sensor
+ * @param expected The profile
+ * @return STHS34PF80_DIFF_* bits of the profile fields that differ
+ */
+uint32_t Adafruit_STHS34PF80::diffProfile(
+    const sths34pf80_device_config_t& actual,
+    const sths34pf80_profile_t& expected) {
+  uint32_t diff = 0;
+
+  diff |= actual.acquisition.odr != expected.odr ? STHS34PF80_DIFF_ODR : 0;
+  diff |= actual.acquisition.avg_tmos != expected.avg_tmos
+              ? STHS34PF80_DIFF_AVG_TMOS
+              : 0;
+  diff |= actual.acquisition.avg_t != expected.avg_t ? STHS34PF80_DIFF_AVG_T
+                                                     : 0;
+  diff |= actual.int_signal != expected.int_signal ? STHS34PF80_DIFF_INT_SIGNAL
+                                                   : 0;
+  diff |= actual.int_mask != (expected.int_mask & 0x07)
+              ? STHS34PF80_DIFF_INT_MASK
+              : 0;
+  diff |= actual.int_latched != expected.int_latched
+              ? STHS34PF80_DIFF_INT_LATCHED
+              : 0;
+  return diff;
+}
+
+/*!
+ * @brief Hash the configuration registers a fleet agent verifies
+ *
+ * FNV-1a over the canonical LPF1, LPF2, AVG_TRIM, CTRL0 gain, CTRL1 (ODR,
+ * BDU) and CTRL3 values. SENS_DATA (factory trimmed per unit) and the
+ * embedded bank (not readable in one transaction) are left out.
+ * @param config The configuration
+ * @return The hash, as readConfigHash() reads it from a matching sensor
+ */
+uint32_t Adafruit_STHS34PF80::configHash(
+    const sths34pf80_device_config_t& config) {
+  const sths34pf80_config_t& a = config.acquisition;
+  uint8_t image[6] = {
+      (uint8_t)(((a.lpf_p_m & 0x07) << 3) | (a.lpf_m & 0x07)),
+      (uint8_t)(((a.lpf_p & 0x07) << 3) | (a.lpf_a_t & 0x07)),
+      (uint8_t)(((a.avg_t & 0x03) << 4) | (a.avg_tmos & 0x07)),
+      (uint8_t)(config.wide_gain ? 0x00 : 0x70),
+      (uint8_t)((config.block_data_update ? 0x10 : 0x00) | (a.odr & 0x0F)),
+      (uint8_t)((config.int_active_low ? 0x80 : 0x00) |
+                (config.int_open_drain ? 0x40 : 0x00) |
+                ((config.int_mask & 0x07) << 3) |
+                (config.int_latched ? 0x04 : 0x00) |
+                (config.int_signal & 0x03))};
+
+  uint32_t hash = 0x811C9DC5UL;
+  for (uint8_t i = 0; i < sizeof(image); i++) {
+    hash ^= image[i];
+    hash *= 0x01000193UL;
+  }
+  return hash;
+}
+
 /*!
  * @brief Write data to embedded function registers
  * Ported from: sths34pf80_func_cfg_write
@@ -771,10 +1413,13 @@ bool Adafruit_STHS34PF80::writeEmbeddedFunction(uint8_t addr, uint8_t* data,
   // sths34pf80_page_rw_t page_rw = {0};
   // int32_t ret;
   // uint8_t i;
-  if (!i2c_dev) {
+  if (!hasDevice()) {
     return false;
   }
 
+  // Until the write completes the cached bytes are not known to match
+  shadowWritten(addr, data, len, false);
+
   // /* Save current odr and enter PD mode */
   // ret = sths34pf80_read_reg(ctx, STHS34PF80_CTRL1, (uint8_t *)&ctrl1, 1);
   // odr = ctrl1.odr;
@@ -794,8 +1439,7 @@ bool Adafruit_STHS34PF80::writeEmbeddedFunction(uint8_t addr, uint8_t* data,
   // page_rw.func_cfg_write = 1;
   // ret += sths34pf80_write_reg(ctx, STHS34PF80_PAGE_RW, (uint8_t *)&page_rw,
   // 1);
-  Adafruit_BusIO_Register page_rw_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_PAGE_RW, 1);
+  Adafruit_BusIO_Register page_rw_reg = busRegister(STHS34PF80_REG_PAGE_RW, 1);
   Adafruit_BusIO_RegisterBits func_cfg_write_bit =
       Adafruit_BusIO_RegisterBits(&page_rw_reg, 1, 6);
   if (!func_cfg_write_bit.write(1)) {
@@ -807,7 +1451,7 @@ bool Adafruit_STHS34PF80::writeEmbeddedFunction(uint8_t addr, uint8_t* data,
   // /* Select register address (it will autoincrement after each write) */
   // ret += sths34pf80_write_reg(ctx, STHS34PF80_FUNC_CFG_ADDR, &addr, 1);
   Adafruit_BusIO_Register func_cfg_addr_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_FUNC_CFG_ADDR, 1);
+      busRegister(STHS34PF80_REG_FUNC_CFG_ADDR, 1);
   if (!func_cfg_addr_reg.write(addr)) {
     func_cfg_write_bit.write(0);
     enableEmbeddedFuncPage(false);
@@ -820,7 +1464,7 @@ bool Adafruit_STHS34PF80::writeEmbeddedFunction(uint8_t addr, uint8_t* data,
   //   ret += sths34pf80_write_reg(ctx, STHS34PF80_FUNC_CFG_DATA, &data[i], 1);
   // }
   Adafruit_BusIO_Register func_cfg_data_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_FUNC_CFG_DATA, 1);
+      busRegister(STHS34PF80_REG_FUNC_CFG_DATA, 1);
   for (uint8_t i = 0; i < len; i++) {
     if (!func_cfg_data_reg.write(data[i])) {
       func_cfg_write_bit.write(0);
@@ -847,6 +1491,8 @@ bool Adafruit_STHS34PF80::writeEmbeddedFunction(uint8_t addr, uint8_t* data,
     return false;
   }
 
+  shadowWritten(addr, data, len, true);
+
   // /* Restore odr */
   // ret += sths34pf80_tmos_odr_check_safe_set(ctx, ctrl1, odr);
   if (!safeSetOutputDataRate(STHS34PF80_ODR_POWER_DOWN, current_odr)) {
@@ -857,6 +1503,318 @@ bool Adafruit_STHS34PF80::writeEmbeddedFunction(uint8_t addr, uint8_t* data,
   return true;
 }
 
+/*!
+ * @brief Read data from embedded function registers
+ * Ported from: sths34pf80_func_cfg_read
+ * @param addr Embedded function register address
+ * @param data Pointer to buffer receiving the data
+ * @param len Number of bytes to read
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::readEmbeddedFunction(uint8_t addr, uint8_t* data,
+                                               uint8_t len) {
+  if (!hasDevice()) {
+    return false;
+  }
+
+  // /* Save current odr and enter PD mode */
+  sths34pf80_odr_t current_odr = getOutputDataRate();
+  if (!safeSetOutputDataRate(current_odr, STHS34PF80_ODR_POWER_DOWN)) {
+    return false;
+  }
+
+  // /* Enable access to embedded functions register */
+  if (!enableEmbeddedFuncPage(true)) {
+    return false;
+  }
+
+  // /* Enable read mode */
+  // page_rw.func_cfg_read = 1;
+  Adafruit_BusIO_Register page_rw_reg = busRegister(STHS34PF80_REG_PAGE_RW, 1);
+  Adafruit_BusIO_RegisterBits func_cfg_read_bit =
+      Adafruit_BusIO_RegisterBits(&page_rw_reg, 1, 5);
+  if (!func_cfg_read_bit.write(1)) {
+    enableEmbeddedFuncPage(false);
+    safeSetOutputDataRate(STHS34PF80_ODR_POWER_DOWN, current_odr);
+    return false;
+  }
+
+  // for (i = 0; i < len; i++) {
+  //   /* Select register address */
+  //   reg_addr = addr + i;
+  //   ret += sths34pf80_write_reg(ctx, STHS34PF80_FUNC_CFG_ADDR, &reg_addr, 1);
+  //   /* Read data */
+  //   ret += sths34pf80_read_reg(ctx, STHS34PF80_FUNC_CFG_DATA, &data[i], 1);
+  // }
+  Adafruit_BusIO_Register func_cfg_addr_reg =
+      busRegister(STHS34PF80_REG_FUNC_CFG_ADDR, 1);
+  Adafruit_BusIO_Register func_cfg_data_reg =
+      busRegister(STHS34PF80_REG_FUNC_CFG_DATA, 1);
+  for (uint8_t i = 0; i < len; i++) {
+    if (!func_cfg_addr_reg.write(addr + i) ||
+        !func_cfg_data_reg.read(&data[i])) {
+      func_cfg_read_bit.write(0);
+      enableEmbeddedFuncPage(false);
+      safeSetOutputDataRate(STHS34PF80_ODR_POWER_DOWN, current_odr);
+      return false;
+    }
+  }
+  shadowRead(addr, data, len);
+
+  // /* Disable read mode */
+  if (!func_cfg_read_bit.write(0)) {
+    enableEmbeddedFuncPage(false);
+    safeSetOutputDataRate(STHS34PF80_ODR_POWER_DOWN, current_odr);
+    return false;
+  }
+
+  // /* Disable access to embedded functions register */
+  if (!enableEmbeddedFuncPage(false)) {
+    safeSetOutputDataRate(STHS34PF80_ODR_POWER_DOWN, current_odr);
+    return false;
+  }
+
+  // /* Restore odr */
+  return safeSetOutputDataRate(STHS34PF80_ODR_POWER_DOWN, current_odr);
+}
+
+/*!
+ * @brief Read the cached embedded registers (PRESENCE_THS through
+ * HYST_TAMB_SHOCK) into the shadow, dropping staged changes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80::loadEmbeddedShadow() {
+  uint8_t bank[STHS34PF80_EMBEDDED_SHADOW_LEN];
+
+  invalidateEmbeddedShadow();
+  if (!readEmbeddedFunction(STHS34PF80_EMBEDDED_PRESENCE_THS, bank,
+                            sizeof(bank))) {
+    return false;
+  }
+  memcpy(_embedded_shadow, bank, sizeof(bank));
+  _embedded_valid = true;
+  return true;
+}
+
+/*!
+ * @brief Forget the shadow and any staged changes, e.g. after the sensor
+ * was reset behind the driver's back; the next access reloads it
+ */
+void Adafruit_STHS34PF80::invalidateEmbeddedShadow() {
+  _embedded_valid = false;
+  _embedded_dirty = 0;
+}
+
+/*!
+ * @brief Stage embedded register values in the shadow, without bus access
+ *
+ * Only bytes that differ from the shadow are marked dirty, so staging the
+ * configuration already in place leaves nothing to flush. The first call
+ * loads the shadow. RESET_ALGO is a command, not cached: use
+ * writeEmbeddedFunction() for it.
+ * @param addr Embedded register address, 0x20-0x29
+ * @param data Values
+ * @param len Number of registers
+ * @return False if the range is outside the shadow or loading it failed
+ */
+bool Adafruit_STHS34PF80::setEmbeddedFunction(uint8_t addr,
+                                              const uint8_t* data,
+                                              uint8_t len) {
+  if (!data || addr < STHS34PF80_EMBEDDED_PRESENCE_THS ||
+      addr + len > STHS34PF80_EMBEDDED_PRESENCE_THS +
+                       STHS34PF80_EMBEDDED_SHADOW_LEN) {
+    return false;
+  }
+  if (!_embedded_valid && !loadEmbeddedShadow()) {
+    return false;
+  }
+
+  uint8_t first = addr - STHS34PF80_EMBEDDED_PRESENCE_THS;
+  for (uint8_t i = 0; i < len; i++) {
+    if (_embedded_shadow[first + i] != data[i]) {
+      _embedded_shadow[first + i] = data[i];
+      _embedded_dirty |= 1U << (first + i);
+    }
+  }
+  return true;
+}
+
+/*!
+ * @brief Get embedded register values from the shadow, staged changes
+ * included; the first call loads it
+ * @param addr Embedded register address, 0x20-0x29
+ * @param data Destination
+ * @param len Number of registers
+ * @return False if the range is outside the shadow or loading it failed
+ */
+bool Adafruit_STHS34PF80::getEmbeddedFunction(uint8_t addr, uint8_t* data,
+                                              uint8_t len) {
+  if (!data || addr < STHS34PF80_EMBEDDED_PRESENCE_THS ||
+      addr + len > STHS34PF80_EMBEDDED_PRESENCE_THS +
+                       STHS34PF80_EMBEDDED_SHADOW_LEN) {
+    return false;
+  }
+  if (!_embedded_valid && !loadEmbeddedShadow()) {
+    return false;
+  }
+
+  memcpy(data, &_embedded_shadow[addr - STHS34PF80_EMBEDDED_PRESENCE_THS],
+         len);
+  return true;
+}
+
+/*!
+ * @brief Write the dirty shadow bytes in one embedded page session
+ *
+ * Each contiguous dirty run costs one FUNC_CFG_ADDR write, the address
+ * auto-incrementing over its data writes. With the sensor running, the
+ * algorithm reset of the ODR restore is written in the same session (after
+ * HYST_TAMB_SHOCK it needs no address write of its own) instead of a
+ * second power-down cycle. With verify, the session then switches to read
+ * mode and reads the written bytes back. Nothing dirty, no bus access.
+ * @param verify Read the written bytes back before leaving the page
+ * @return True if everything was written (and read back equal), false
+ * otherwise; unwritten or mismatching bytes stay dirty
+ */
+bool Adafruit_STHS34PF80::flushEmbeddedFunctions(bool verify) {
+  if (!_embedded_dirty) {
+    return true;
+  }
+  if (!hasDevice()) {
+    return false;
+  }
+
+  sths34pf80_odr_t current_odr = getOutputDataRate();
+  if (!safeSetOutputDataRate(current_odr, STHS34PF80_ODR_POWER_DOWN)) {
+    return false;
+  }
+
+  Adafruit_BusIO_Register page_rw_reg = busRegister(STHS34PF80_REG_PAGE_RW, 1);
+  Adafruit_BusIO_RegisterBits func_cfg_write_bit =
+      Adafruit_BusIO_RegisterBits(&page_rw_reg, 1, 6);
+  Adafruit_BusIO_RegisterBits func_cfg_read_bit =
+      Adafruit_BusIO_RegisterBits(&page_rw_reg, 1, 5);
+  Adafruit_BusIO_Register func_cfg_addr_reg =
+      busRegister(STHS34PF80_REG_FUNC_CFG_ADDR, 1);
+  Adafruit_BusIO_Register func_cfg_data_reg =
+      busRegister(STHS34PF80_REG_FUNC_CFG_DATA, 1);
+
+  bool ok = enableEmbeddedFuncPage(true) && func_cfg_write_bit.write(1);
+  uint8_t next_addr = 0; // Where FUNC_CFG_ADDR points, 0 if not set
+  uint16_t written = 0;
+  for (uint8_t i = 0; ok && i < STHS34PF80_EMBEDDED_SHADOW_LEN; i++) {
+    if (!(_embedded_dirty & (1U << i))) {
+      continue;
+    }
+    uint8_t addr = STHS34PF80_EMBEDDED_PRESENCE_THS + i;
+    if (next_addr != addr) {
+      ok = func_cfg_addr_reg.write(addr);
+    }
+    ok = ok && func_cfg_data_reg.write(_embedded_shadow[i]);
+    if (ok) {
+      _embedded_dirty &= ~(1U << i);
+      written |= 1U << i;
+      next_addr = addr + 1;
+    }
+  }
+
+  bool running = current_odr != STHS34PF80_ODR_POWER_DOWN;
+  if (ok && running) {
+    if (next_addr != STHS34PF80_EMBEDDED_RESET_ALGO) {
+      ok = func_cfg_addr_reg.write(STHS34PF80_EMBEDDED_RESET_ALGO);
+    }
+    ok = ok && func_cfg_data_reg.write(1);
+  }
+
+  ok = func_cfg_write_bit.write(0) && ok;
+  if (ok && verify) {
+    ok = func_cfg_read_bit.write(1);
+    for (uint8_t i = 0; ok && i < STHS34PF80_EMBEDDED_SHADOW_LEN; i++) {
+      uint8_t value;
+      if (!(written & (1U << i))) {
+        continue;
+      }
+      ok = func_cfg_addr_reg.write(STHS34PF80_EMBEDDED_PRESENCE_THS + i) &&
+           func_cfg_data_reg.read(&value);
+      if (ok && value != _embedded_shadow[i]) {
+        _embedded_dirty |= 1U << i;
+        ok = false;
+      }
+    }
+    ok = func_cfg_read_bit.write(0) && ok;
+  }
+  ok = enableEmbeddedFuncPage(false) && ok;
+  if (!running) {
+    return ok;
+  }
+  if (!ok) {
+    safeSetOutputDataRate(STHS34PF80_ODR_POWER_DOWN, current_odr);
+    return false;
+  }
+
+  // The algorithm was reset above, so the rate goes straight back
+  Adafruit_BusIO_Register ctrl1_reg = busRegister(STHS34PF80_REG_CTRL1, 1);
+  Adafruit_BusIO_RegisterBits odr_bits =
+      Adafruit_BusIO_RegisterBits(&ctrl1_reg, 4, 0);
+  return odr_bits.write(current_odr);
+}
+
+/*!
+ * @brief Get the shadow bytes staged but not yet written
+ * @return Bit n set if register 0x20 + n is dirty
+ */
+uint16_t Adafruit_STHS34PF80::getEmbeddedDirtyMask() { return _embedded_dirty; }
+
+/*!
+ * @brief Keep the shadow in step with a direct embedded write
+ * @param addr First embedded register written
+ * @param data Values
+ * @param len Number of registers
+ * @param written True once the write completed, false before (or if it
+ * failed), leaving the bytes dirty
+ */
+void Adafruit_STHS34PF80::shadowWritten(uint8_t addr, const uint8_t* data,
+                                        uint8_t len, bool written) {
+  if (!_embedded_valid) {
+    return;
+  }
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t index = addr + i - STHS34PF80_EMBEDDED_PRESENCE_THS;
+    if (addr + i < STHS34PF80_EMBEDDED_PRESENCE_THS ||
+        index >= STHS34PF80_EMBEDDED_SHADOW_LEN) {
+      continue;
+    }
+    _embedded_shadow[index] = data[i];
+    if (written) {
+      _embedded_dirty &= ~(1U << index);
+    } else {
+      _embedded_dirty |= 1U << index;
+    }
+  }
+}
+
+/*!
+ * @brief Refresh the clean shadow bytes from a direct embedded read
+ * @param addr First embedded register read
+ * @param data Values
+ * @param len Number of registers
+ */
+void Adafruit_STHS34PF80::shadowRead(uint8_t addr, const uint8_t* data,
+                                     uint8_t len) {
+  if (!_embedded_valid) {
+    return;
+  }
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t index = addr + i - STHS34PF80_EMBEDDED_PRESENCE_THS;
+    if (addr + i < STHS34PF80_EMBEDDED_PRESENCE_THS ||
+        index >= STHS34PF80_EMBEDDED_SHADOW_LEN ||
+        (_embedded_dirty & (1U << index))) {
+      continue;
+    }
+    _embedded_shadow[index] = data[i];
+  }
+}
+
 /*!
  * @brief Algorithm reset procedure
  * Ported from: sths34pf80_algo_reset
@@ -881,12 +1839,11 @@ bool Adafruit_STHS34PF80::safeSetOutputDataRate(sths34pf80_odr_t current_odr,
   // sths34pf80_func_status_t func_status;
   // sths34pf80_tmos_drdy_status_t status;
   // int32_t ret = 0;
-  if (!i2c_dev) {
+  if (!hasDevice()) {
     return false;
   }
 
-  Adafruit_BusIO_Register ctrl1_reg =
-      Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_CTRL1, 1);
+  Adafruit_BusIO_Register ctrl1_reg = busRegister(STHS34PF80_REG_CTRL1, 1);
 
   Adafruit_BusIO_RegisterBits odr_bits =
       Adafruit_BusIO_RegisterBits(&ctrl1_reg, 4, 0);
@@ -918,7 +1875,7 @@ bool Adafruit_STHS34PF80::safeSetOutputDataRate(sths34pf80_odr_t current_odr,
       // ret = sths34pf80_read_reg(ctx, STHS34PF80_FUNC_STATUS, (uint8_t
       // *)&func_status, 1);
       Adafruit_BusIO_Register func_status_reg =
-          Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_FUNC_STATUS, 1);
+          busRegister(STHS34PF80_REG_FUNC_STATUS, 1);
       func_status_reg.read(); // Reading clears the DRDY bit
 
       /* wait DRDY bit go to '1' */
@@ -926,17 +1883,17 @@ bool Adafruit_STHS34PF80::safeSetOutputDataRate(sths34pf80_odr_t current_odr,
       //   ret += sths34pf80_tmos_drdy_status_get(ctx, &status);
       // } while (status.drdy != 0U);
       Adafruit_BusIO_Register status_reg =
-          Adafruit_BusIO_Register(i2c_dev, STHS34PF80_REG_STATUS, 1);
+          busRegister(STHS34PF80_REG_STATUS, 1);
 
       Adafruit_BusIO_RegisterBits drdy_bit =
           Adafruit_BusIO_RegisterBits(&status_reg, 1, 2);
 
-      uint32_t timeout = 1000; // 1 second timeout
-      while (timeout-- > 0) {
-        if (drdy_bit.read() == 1) {
+      uint32_t start = _clock->getMillis();
+      while (drdy_bit.read() != 1) {
+        if (_clock->getMillis() - start >= _drdy_timeout_ms) {
           break;
         }
-        delay(1);
+        _clock->delayMillis(1);
       }
 
       // Continue even if DRDY timeout occurs
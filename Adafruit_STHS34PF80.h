@@ -22,12 +22,16 @@
 #define __ADAFRUIT_STHS34PF80_H__
 
 #include <Adafruit_BusIO_Register.h>
+#include <Adafruit_GenericDevice.h>
 #include <Adafruit_I2CDevice.h>
 #include <Wire.h>
 
+#include "Adafruit_STHS34PF80_Clock.h"
 #include "Arduino.h"
 
 #define STHS34PF80_DEFAULT_ADDR 0x5A ///< Default I2C address for the STHS34PF80
+#define STHS34PF80_BOOT_TIME_MS 5 ///< Wait after the OTP memory reboot
+#define STHS34PF80_DRDY_TIMEOUT_MS 1000 ///< Default safe power-down DRDY wait
 
 #define STHS34PF80_REG_LPF1 0x0C ///< Low-pass filter configuration 1 register
 #define STHS34PF80_REG_LPF2 0x0D ///< Low-pass filter configuration 2 register
@@ -65,18 +69,41 @@
   0x09 ///< Embedded function configuration data register
 #define STHS34PF80_REG_PAGE_RW 0x11 ///< Page read/write control register
 
+#define STHS34PF80_EMBEDDED_PRESENCE_THS \
+  0x20 ///< Embedded function PRESENCE_THS (LSB) register address
+#define STHS34PF80_EMBEDDED_MOTION_THS \
+  0x22 ///< Embedded function MOTION_THS (LSB) register address
+#define STHS34PF80_EMBEDDED_TAMB_SHOCK_THS \
+  0x24 ///< Embedded function TAMB_SHOCK_THS (LSB) register address
+#define STHS34PF80_EMBEDDED_HYST_MOTION \
+  0x26 ///< Embedded function HYST_MOTION register address
+#define STHS34PF80_EMBEDDED_HYST_PRESENCE \
+  0x27 ///< Embedded function HYST_PRESENCE register address
+#define STHS34PF80_EMBEDDED_ALGO_CONFIG \
+  0x28 ///< Embedded function ALGO_CONFIG register address
+#define STHS34PF80_EMBEDDED_HYST_TAMB_SHOCK \
+  0x29 ///< Embedded function HYST_TAMB_SHOCK register address
 #define STHS34PF80_EMBEDDED_RESET_ALGO \
   0x2A ///< Embedded function RESET_ALGO register address
 
+#define STHS34PF80_DUMP_FIRST_REG 0x0C ///< First main bank register dumped
+#define STHS34PF80_DUMP_LEN 52        ///< Main bank dump length, 0x0C-0x3F
+#define STHS34PF80_EMBEDDED_DUMP_LEN \
+  11 ///< Embedded bank dump length, PRESENCE_THS (0x20)-RESET_ALGO (0x2A)
+#define STHS34PF80_EMBEDDED_SHADOW_LEN \
+  10 ///< Embedded registers cached, PRESENCE_THS (0x20)-HYST_TAMB_SHOCK (0x29)
+
 #define STHS34PF80_PRES_FLAG 0x04       ///< Presence detection flag
 #define STHS34PF80_MOT_FLAG 0x02        ///< Motion detection flag
 #define STHS34PF80_TAMB_SHOCK_FLAG 0x01 ///< Ambient temperature shock flag
 
 /*!
  * @brief Low-pass filter configuration options
+ *
+ * LPF1 and LPF2 reset to 0x00, which puts all four filters at ODR/9.
  */
 typedef enum {
-  STHS34PF80_LPF_ODR_DIV_9 = 0x00,   ///< ODR/9
+  STHS34PF80_LPF_ODR_DIV_9 = 0x00,   ///< ODR/9 (default)
   STHS34PF80_LPF_ODR_DIV_20 = 0x01,  ///< ODR/20
   STHS34PF80_LPF_ODR_DIV_50 = 0x02,  ///< ODR/50
   STHS34PF80_LPF_ODR_DIV_100 = 0x03, ///< ODR/100
@@ -133,6 +160,113 @@ typedef enum {
   STHS34PF80_INT_OR = 0x02,     ///< INT_OR (function flags)
 } sths34pf80_int_signal_t;
 
+/*!
+ * @brief Full acquisition and filter configuration
+ */
+typedef struct {
+  sths34pf80_odr_t odr;            ///< Output data rate
+  sths34pf80_avg_tmos_t avg_tmos;  ///< Object temperature averaging
+  sths34pf80_avg_t_t avg_t;        ///< Ambient temperature averaging
+  sths34pf80_lpf_config_t lpf_m;   ///< Motion low-pass filter
+  sths34pf80_lpf_config_t lpf_p_m; ///< Motion and presence low-pass filter
+  sths34pf80_lpf_config_t lpf_p;   ///< Presence low-pass filter
+  sths34pf80_lpf_config_t lpf_a_t; ///< Ambient shock low-pass filter
+} sths34pf80_config_t;
+
+/*!
+ * @brief One output sample fetched in two register bursts by readSample()
+ */
+typedef struct {
+  uint8_t flags;      ///< FUNC_STATUS flag bits
+  int16_t object;     ///< Raw object temperature (TOBJECT)
+  int16_t ambient;    ///< Raw ambient temperature, 0.01 degC/LSB (TAMBIENT)
+  int16_t obj_comp;   ///< Raw compensated object temperature (TOBJ_COMP)
+  int16_t presence;   ///< Raw presence signal (TPRESENCE)
+  int16_t motion;     ///< Raw motion signal (TMOTION)
+  int16_t temp_shock; ///< Raw ambient shock signal (TAMB_SHOCK)
+} sths34pf80_sample_t;
+
+/*!
+ * @brief Acquisition profile applied in one pass by applyProfile()
+ */
+typedef struct {
+  sths34pf80_odr_t odr;               ///< Output data rate
+  sths34pf80_avg_tmos_t avg_tmos;     ///< Object temperature averaging
+  sths34pf80_avg_t_t avg_t;           ///< Ambient temperature averaging
+  sths34pf80_int_signal_t int_signal; ///< Signal routed to the INT pin
+  uint8_t int_mask;                   ///< INT_OR function flag mask (bits 2:0)
+  bool int_latched;                   ///< Latch INT until FUNC_STATUS is read
+} sths34pf80_profile_t;
+
+/*!
+ * @brief Raw register dump read with dumpRegisters()
+ */
+typedef struct {
+  uint8_t main[STHS34PF80_DUMP_LEN]; ///< 0x0C-0x3F, FUNC_STATUS left 0
+  uint8_t embedded[STHS34PF80_EMBEDDED_DUMP_LEN]; ///< Embedded 0x20-0x2A
+  bool has_embedded; ///< True if the embedded bank was read
+} sths34pf80_dump_t;
+
+/*!
+ * @brief Complete device configuration decoded from a register dump
+ */
+typedef struct {
+  sths34pf80_config_t acquisition;    ///< ODR, averaging and filters
+  bool wide_gain;                     ///< Wide gain mode
+  bool block_data_update;             ///< Block data update
+  int8_t sensitivity;                 ///< SENS_DATA
+  sths34pf80_int_signal_t int_signal; ///< Signal routed to the INT pin
+  uint8_t int_mask;                   ///< INT_OR function flag mask
+  bool int_latched;                   ///< INT latched until FUNC_STATUS read
+  bool int_active_low;                ///< INT active low
+  bool int_open_drain;                ///< INT open drain
+  bool has_embedded;                  ///< True if the fields below are valid
+  uint16_t presence_threshold;        ///< PRESENCE_THS
+  uint16_t motion_threshold;          ///< MOTION_THS
+  uint16_t tamb_shock_threshold;      ///< TAMB_SHOCK_THS
+  uint8_t motion_hysteresis;          ///< HYST_MOTION
+  uint8_t presence_hysteresis;        ///< HYST_PRESENCE
+  uint8_t algo_config;                ///< ALGO_CONFIG
+  uint8_t tamb_shock_hysteresis;      ///< HYST_TAMB_SHOCK
+} sths34pf80_device_config_t;
+
+/*!
+ * @brief Bits returned by diffConfig() and diffProfile(), one per field
+ */
+typedef enum {
+  STHS34PF80_DIFF_ODR = 1UL << 0,              ///< Output data rate
+  STHS34PF80_DIFF_AVG_TMOS = 1UL << 1,         ///< Object averaging
+  STHS34PF80_DIFF_AVG_T = 1UL << 2,            ///< Ambient averaging
+  STHS34PF80_DIFF_LPF_M = 1UL << 3,            ///< Motion LPF
+  STHS34PF80_DIFF_LPF_P_M = 1UL << 4,          ///< Motion and presence LPF
+  STHS34PF80_DIFF_LPF_P = 1UL << 5,            ///< Presence LPF
+  STHS34PF80_DIFF_LPF_A_T = 1UL << 6,          ///< Ambient shock LPF
+  STHS34PF80_DIFF_WIDE_GAIN = 1UL << 7,        ///< Gain mode
+  STHS34PF80_DIFF_BDU = 1UL << 8,              ///< Block data update
+  STHS34PF80_DIFF_SENSITIVITY = 1UL << 9,      ///< SENS_DATA
+  STHS34PF80_DIFF_INT_SIGNAL = 1UL << 10,      ///< INT signal
+  STHS34PF80_DIFF_INT_MASK = 1UL << 11,        ///< INT mask
+  STHS34PF80_DIFF_INT_LATCHED = 1UL << 12,     ///< INT latching
+  STHS34PF80_DIFF_INT_POLARITY = 1UL << 13,    ///< INT polarity
+  STHS34PF80_DIFF_INT_OPEN_DRAIN = 1UL << 14,  ///< INT output type
+  STHS34PF80_DIFF_PRESENCE_THS = 1UL << 15,    ///< PRESENCE_THS
+  STHS34PF80_DIFF_MOTION_THS = 1UL << 16,      ///< MOTION_THS
+  STHS34PF80_DIFF_TAMB_SHOCK_THS = 1UL << 17,  ///< TAMB_SHOCK_THS
+  STHS34PF80_DIFF_HYST_MOTION = 1UL << 18,     ///< HYST_MOTION
+  STHS34PF80_DIFF_HYST_PRESENCE = 1UL << 19,   ///< HYST_PRESENCE
+  STHS34PF80_DIFF_ALGO_CONFIG = 1UL << 20,     ///< ALGO_CONFIG
+  STHS34PF80_DIFF_HYST_TAMB_SHOCK = 1UL << 21, ///< HYST_TAMB_SHOCK
+} sths34pf80_config_diff_t;
+
+/*!
+ * @brief Bus traffic counters
+ */
+typedef struct {
+  uint32_t transactions; ///< Register reads and writes
+  uint32_t bytes;        ///< Data bytes transferred, without addressing
+  uint32_t bits;         ///< Bits on the wire, including start/stop/ACK
+} sths34pf80_bus_stats_t;
+
 /*!
  * @brief Class that stores state and functions for interacting with the
  * STHS34PF80
@@ -143,9 +277,15 @@ class Adafruit_STHS34PF80 {
   ~Adafruit_STHS34PF80();
 
   bool begin(uint8_t i2c_addr = STHS34PF80_DEFAULT_ADDR, TwoWire* wire = &Wire);
+  bool begin(Adafruit_GenericDevice* device);
   bool isConnected();
   bool reset();
 
+  void setClock(Adafruit_STHS34PF80_Clock* clock);
+  Adafruit_STHS34PF80_Clock* getClock();
+  void setDrdyTimeout(uint32_t timeout_ms);
+  uint32_t getDrdyTimeout();
+
   bool setMotionLowPassFilter(sths34pf80_lpf_config_t config);
   sths34pf80_lpf_config_t getMotionLowPassFilter();
   bool setMotionPresenceLowPassFilter(sths34pf80_lpf_config_t config);
@@ -170,12 +310,23 @@ class Adafruit_STHS34PF80 {
   bool getBlockDataUpdate();
   bool setOutputDataRate(sths34pf80_odr_t odr);
   sths34pf80_odr_t getOutputDataRate();
+  static sths34pf80_odr_t maxOutputDataRate(sths34pf80_avg_tmos_t avg_tmos);
+  static bool isValidProfile(const sths34pf80_profile_t& profile);
+  bool applyProfile(const sths34pf80_profile_t& profile);
 
   bool rebootOTPmemory();
   bool enableEmbeddedFuncPage(bool enable);
   bool triggerOneshot();
 
   bool writeEmbeddedFunction(uint8_t addr, uint8_t* data, uint8_t len);
+  bool readEmbeddedFunction(uint8_t addr, uint8_t* data, uint8_t len);
+
+  bool loadEmbeddedShadow();
+  void invalidateEmbeddedShadow();
+  bool setEmbeddedFunction(uint8_t addr, const uint8_t* data, uint8_t len);
+  bool getEmbeddedFunction(uint8_t addr, uint8_t* data, uint8_t len);
+  bool flushEmbeddedFunctions(bool verify = false);
+  uint16_t getEmbeddedDirtyMask();
 
   bool setIntPolarity(bool active_low);
   bool setIntOpenDrain(bool open_drain);
@@ -196,12 +347,58 @@ class Adafruit_STHS34PF80 {
   int16_t readPresence();
   int16_t readMotion();
   int16_t readTempShock();
+  uint8_t readFuncStatus();
+  bool readSample(sths34pf80_sample_t* sample);
+
+  bool readRegisters(uint8_t reg, uint8_t* buffer, uint8_t len);
+  bool writeRegisters(uint8_t reg, uint8_t* buffer, uint8_t len);
+
+  bool dumpRegisters(sths34pf80_dump_t* dump, bool embedded = false);
+  bool readConfigHash(uint32_t* hash);
+  static bool decodeDump(const sths34pf80_dump_t& dump,
+                         sths34pf80_device_config_t* config);
+  static uint32_t diffConfig(const sths34pf80_device_config_t& actual,
+                             const sths34pf80_device_config_t& expected);
+  static uint32_t diffProfile(const sths34pf80_device_config_t& actual,
+                              const sths34pf80_profile_t& expected);
+  static uint32_t configHash(const sths34pf80_device_config_t& config);
+
+  bool enableBusAccounting(bool enable);
+  void getBusStats(sths34pf80_bus_stats_t* stats);
+  void resetBusStats();
+
+ protected:
+  bool initDevice(uint8_t i2c_addr, TwoWire* wire);
+  bool initDevice(Adafruit_GenericDevice* device);
 
  private:
   Adafruit_I2CDevice* i2c_dev;
+  Adafruit_GenericDevice* generic_dev;
+  Adafruit_GenericDevice* meter_dev;
+  sths34pf80_bus_stats_t _bus_stats;
+  Adafruit_STHS34PF80_Clock* _clock;
+  uint32_t _drdy_timeout_ms;
+  uint8_t _embedded_shadow[STHS34PF80_EMBEDDED_SHADOW_LEN];
+  uint16_t _embedded_dirty;
+  bool _embedded_valid;
   bool safeSetOutputDataRate(sths34pf80_odr_t current_odr,
                              sths34pf80_odr_t new_odr);
   bool algorithmReset(); // TODO: Implement algorithm reset procedure
+  bool applyDefaults();
+  bool hasDevice();
+  Adafruit_BusIO_Register busRegister(uint8_t reg, uint8_t width = 1,
+                                      uint8_t byteorder = LSBFIRST);
+  static bool meterRead(void* obj, uint8_t* buffer, size_t len);
+  static bool meterWrite(void* obj, const uint8_t* buffer, size_t len);
+  static bool meterReadRegister(void* obj, uint8_t* addr_buf, uint8_t addrsiz,
+                                uint8_t* data, uint16_t datalen);
+  static bool meterWriteRegister(void* obj, uint8_t* addr_buf,
+                                 uint8_t addrsiz, const uint8_t* data,
+                                 uint16_t datalen);
+  void countTransfer(uint16_t len, uint8_t prefix_len, bool read);
+  void shadowWritten(uint8_t addr, const uint8_t* data, uint8_t len,
+                     bool written);
+  void shadowRead(uint8_t addr, const uint8_t* data, uint8_t len);
 };
 
 #endif
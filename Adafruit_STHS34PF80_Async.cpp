@@ -0,0 +1,383 @@
+/*!
+ * @file Adafruit_STHS34PF80_Async.cpp
+ *
+ * C++20 coroutine API for driving many STHS34PF80 sensors from one thread
+ * on Linux hosts.
+ *
+ * The loop keeps a FIFO of runnable coroutines and a min-heap of timers.
+ * runOnce() resumes everything runnable, then moves due timers to the
+ * FIFO, sleeping (or advancing the simulated clock) until the earliest
+ * timer when nothing is runnable. A waiting session costs one heap entry
+ * and no thread; DRDY is polled at an eighth of the ODR period from just
+ * before the conversion is due, so the bus sees a few STATUS reads per
+ * sample.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_Async.h"
+
+#if defined(__linux__) && defined(__cpp_impl_coroutine)
+
+#include <time.h>
+
+#include "Adafruit_STHS34PF80_Model.h"
+
+/*!
+ * @brief Instantiates an empty loop
+ * @param sim_clock Simulated clock to run on, NULL for the monotonic system
+ * clock
+ */
+Adafruit_STHS34PF80_Loop::Adafruit_STHS34PF80_Loop(
+    Adafruit_STHS34PF80_SimClock* sim_clock)
+    : _sim_clock(sim_clock), _seq(0), _wakeups(0), _live(0) {}
+
+/*!
+ * @brief Run a task detached from the caller; the loop frees it when it
+ * finishes
+ * @param task The task
+ */
+void Adafruit_STHS34PF80_Loop::spawn(Adafruit_STHS34PF80_Task<void> task) {
+  std::coroutine_handle<Adafruit_STHS34PF80_Task<void>::promise_type> handle =
+      task.release();
+  if (!handle) {
+    return;
+  }
+  handle.promise().live = &_live;
+  _live++;
+  _ready.push_back(handle);
+}
+
+/*!
+ * @brief Run until every spawned task has finished
+ */
+void Adafruit_STHS34PF80_Loop::run() {
+  while (runOnce()) {
+  }
+}
+
+/*!
+ * @brief Resume every runnable coroutine, waiting for the next timer if
+ * there is none
+ * @return False once no task is left
+ */
+bool Adafruit_STHS34PF80_Loop::runOnce() {
+  if (_ready.empty()) {
+    if (_timers.empty()) {
+      return false; // Finished, or every task waits on something else
+    }
+    idle(_timers.top().wake_us);
+  }
+
+  // Only what is runnable now; coroutines scheduled meanwhile wait a turn
+  size_t count = _ready.size();
+  for (size_t i = 0; i < count; i++) {
+    std::coroutine_handle<> handle = _ready.front();
+    _ready.pop_front();
+    handle.resume();
+  }
+
+  uint64_t now = nowMicros();
+  while (!_timers.empty() && _timers.top().wake_us <= now) {
+    _ready.push_back(_timers.top().handle);
+    _timers.pop();
+    _wakeups++;
+  }
+  return _live > 0 || !_ready.empty() || !_timers.empty();
+}
+
+/*!
+ * @brief Get the number of spawned tasks that have not finished
+ * @return Live tasks
+ */
+uint32_t Adafruit_STHS34PF80_Loop::activeTasks() { return _live; }
+
+/*!
+ * @brief Get the loop time
+ * @return Microseconds on the simulated or monotonic clock
+ */
+uint64_t Adafruit_STHS34PF80_Loop::nowMicros() {
+  if (_sim_clock) {
+    return _sim_clock->now();
+  }
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*!
+ * @brief Suspend the awaiting coroutine for a time
+ * @param us Microseconds
+ * @return Awaitable
+ */
+Adafruit_STHS34PF80_Loop::Sleep Adafruit_STHS34PF80_Loop::sleepFor(
+    uint64_t us) {
+  return Sleep{this, nowMicros() + us};
+}
+
+/*!
+ * @brief Suspend the awaiting coroutine until a loop time
+ * @param wake_us Loop time from nowMicros()
+ * @return Awaitable
+ */
+Adafruit_STHS34PF80_Loop::Sleep Adafruit_STHS34PF80_Loop::sleepUntil(
+    uint64_t wake_us) {
+  return Sleep{this, wake_us};
+}
+
+/*!
+ * @brief Get the number of timer wakeups so far
+ * @return Wakeups
+ */
+uint64_t Adafruit_STHS34PF80_Loop::timerWakeups() { return _wakeups; }
+
+/*!
+ * @brief Add a timer
+ * @param wake_us Loop time to resume at
+ * @param handle Coroutine to resume
+ */
+void Adafruit_STHS34PF80_Loop::schedule(uint64_t wake_us,
+                                        std::coroutine_handle<> handle) {
+  _timers.push(Timer{wake_us, _seq++, handle});
+}
+
+/*!
+ * @brief Wait for a loop time with nothing to run
+ * @param until_us Loop time
+ */
+void Adafruit_STHS34PF80_Loop::idle(uint64_t until_us) {
+  uint64_t now = nowMicros();
+  if (until_us <= now) {
+    return;
+  }
+  if (_sim_clock) {
+    _sim_clock->set(until_us);
+    return;
+  }
+  struct timespec ts;
+  ts.tv_sec = until_us / 1000000;
+  ts.tv_nsec = (until_us % 1000000) * 1000;
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+/*!
+ * @brief Instantiates a session for a sensor already started with begin()
+ * @param loop The loop the session's waits run on
+ * @param sensor The sensor
+ */
+Adafruit_STHS34PF80_AsyncSensor::Adafruit_STHS34PF80_AsyncSensor(
+    Adafruit_STHS34PF80_Loop* loop, Adafruit_STHS34PF80* sensor)
+    : _loop(loop), _sensor(sensor), _period_us(0), _last_us(0) {}
+
+/*!
+ * @brief Reset the sensor completely, as Adafruit_STHS34PF80::reset()
+ * @return True if successful, false otherwise
+ */
+Adafruit_STHS34PF80_Task<bool> Adafruit_STHS34PF80_AsyncSensor::resetAsync() {
+  if (!_sensor->rebootOTPmemory()) {
+    co_return false;
+  }
+  co_await _loop->sleepFor(STHS34PF80_BOOT_TIME_MS * 1000UL);
+
+  // Powered down after the reboot, so this does not wait
+  setPeriod(STHS34PF80_ODR_POWER_DOWN);
+  co_return resetAlgorithm();
+}
+
+/*!
+ * @brief Set the output data rate, as
+ * Adafruit_STHS34PF80::setOutputDataRate()
+ * @param odr The output data rate value
+ * @return True if successful, false otherwise
+ */
+Adafruit_STHS34PF80_Task<bool>
+Adafruit_STHS34PF80_AsyncSensor::setOutputDataRateAsync(sths34pf80_odr_t odr) {
+  sths34pf80_odr_t current = _sensor->getOutputDataRate();
+  if (odr > Adafruit_STHS34PF80::maxOutputDataRate(
+                _sensor->getObjAveraging())) {
+    co_return false;
+  }
+
+  if (odr == STHS34PF80_ODR_POWER_DOWN) {
+    co_return co_await powerDownAsync(current);
+  }
+
+  // Clean algorithm reset on every change to an operative rate; with the
+  // ODR already 0 the embedded write does not wait
+  if (!writeOdr(STHS34PF80_ODR_POWER_DOWN) || !resetAlgorithm() ||
+      !writeOdr(odr)) {
+    co_return false;
+  }
+  setPeriod(odr);
+  co_return true;
+}
+
+/*!
+ * @brief Write embedded function registers, as
+ * Adafruit_STHS34PF80::writeEmbeddedFunction()
+ * @param addr Embedded function register address
+ * @param data Data to write, valid until the task finishes
+ * @param len Number of bytes to write
+ * @return True if successful, false otherwise
+ */
+Adafruit_STHS34PF80_Task<bool>
+Adafruit_STHS34PF80_AsyncSensor::writeEmbeddedFunctionAsync(uint8_t addr,
+                                                            uint8_t* data,
+                                                            uint8_t len) {
+  sths34pf80_odr_t current = _sensor->getOutputDataRate();
+  if (!co_await powerDownAsync(current)) {
+    co_return false;
+  }
+  bool ok = _sensor->writeEmbeddedFunction(addr, data, len);
+  if (current != STHS34PF80_ODR_POWER_DOWN) {
+    ok = co_await setOutputDataRateAsync(current) && ok;
+  }
+  co_return ok;
+}
+
+/*!
+ * @brief Read embedded function registers, as
+ * Adafruit_STHS34PF80::readEmbeddedFunction()
+ * @param addr Embedded function register address
+ * @param data Buffer receiving the data, valid until the task finishes
+ * @param len Number of bytes to read
+ * @return True if successful, false otherwise
+ */
+Adafruit_STHS34PF80_Task<bool>
+Adafruit_STHS34PF80_AsyncSensor::readEmbeddedFunctionAsync(uint8_t addr,
+                                                           uint8_t* data,
+                                                           uint8_t len) {
+  sths34pf80_odr_t current = _sensor->getOutputDataRate();
+  if (!co_await powerDownAsync(current)) {
+    co_return false;
+  }
+  bool ok = _sensor->readEmbeddedFunction(addr, data, len);
+  if (current != STHS34PF80_ODR_POWER_DOWN) {
+    ok = co_await setOutputDataRateAsync(current) && ok;
+  }
+  co_return ok;
+}
+
+/*!
+ * @brief Read the current outputs and flags without waiting for new data
+ * @param sample Filled with the sample
+ * @return True if successful, false otherwise
+ */
+Adafruit_STHS34PF80_Task<bool> Adafruit_STHS34PF80_AsyncSensor::readAllAsync(
+    sths34pf80_sample_t* sample) {
+  co_return _sensor->readSample(sample);
+}
+
+/*!
+ * @brief Wait for the next conversion and read it
+ * @param sample Filled with the sample
+ * @return False if powered down, on timeout or on a bus error
+ */
+Adafruit_STHS34PF80_Task<bool> Adafruit_STHS34PF80_AsyncSensor::nextSample(
+    sths34pf80_sample_t* sample) {
+  if (!_period_us) {
+    setPeriod(_sensor->getOutputDataRate());
+    if (!_period_us) {
+      co_return false;
+    }
+  }
+
+  // Sleep until just before the next conversion is due
+  if (_last_us) {
+    uint64_t due = _last_us + _period_us - _period_us / 8;
+    co_await _loop->sleepUntil(due);
+  }
+  if (!co_await waitDataReady() || !_sensor->readSample(sample)) {
+    co_return false;
+  }
+  _last_us = _loop->nowMicros();
+  co_return true;
+}
+
+/*!
+ * @brief Get the sensor this session drives
+ * @return The sensor
+ */
+Adafruit_STHS34PF80* Adafruit_STHS34PF80_AsyncSensor::sensor() {
+  return _sensor;
+}
+
+/*!
+ * @brief Safe power-down: let the running conversion finish, then stop
+ * @param current The current output data rate
+ * @return True if successful, false otherwise
+ */
+Adafruit_STHS34PF80_Task<bool> Adafruit_STHS34PF80_AsyncSensor::powerDownAsync(
+    sths34pf80_odr_t current) {
+  if (current != STHS34PF80_ODR_POWER_DOWN) {
+    setPeriod(current);
+    _sensor->readFuncStatus(); // Reading clears the DRDY bit
+    _last_us = 0;
+    co_await waitDataReady(); // Continue even if DRDY times out
+    if (!writeOdr(STHS34PF80_ODR_POWER_DOWN)) {
+      co_return false;
+    }
+    _sensor->readFuncStatus(); // Clear DRDY again
+  }
+  setPeriod(STHS34PF80_ODR_POWER_DOWN);
+  co_return true;
+}
+
+/*!
+ * @brief Poll DRDY with timer waits, up to the driver's DRDY timeout
+ * @return True once data is ready, false on timeout
+ */
+Adafruit_STHS34PF80_Task<bool>
+Adafruit_STHS34PF80_AsyncSensor::waitDataReady() {
+  uint64_t poll_us = _period_us / 8;
+  if (poll_us < STHS34PF80_ASYNC_MIN_POLL_US) {
+    poll_us = STHS34PF80_ASYNC_MIN_POLL_US;
+  }
+  uint64_t deadline =
+      _loop->nowMicros() + _sensor->getDrdyTimeout() * (uint64_t)1000;
+  while (!_sensor->isDataReady()) {
+    if (_loop->nowMicros() >= deadline) {
+      co_return false;
+    }
+    co_await _loop->sleepFor(poll_us);
+  }
+  co_return true;
+}
+
+/*!
+ * @brief Write the CTRL1 ODR field, keeping the other bits
+ * @param odr The output data rate value
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_AsyncSensor::writeOdr(sths34pf80_odr_t odr) {
+  uint8_t ctrl1;
+  if (!_sensor->readRegisters(STHS34PF80_REG_CTRL1, &ctrl1, 1)) {
+    return false;
+  }
+  ctrl1 = (ctrl1 & 0xF0) | (odr & 0x0F);
+  return _sensor->writeRegisters(STHS34PF80_REG_CTRL1, &ctrl1, 1);
+}
+
+/*!
+ * @brief Restart the detection algorithm (RESET_ALGO), which the driver
+ * keeps private
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_AsyncSensor::resetAlgorithm() {
+  uint8_t reset_value = 1;
+  return _sensor->writeEmbeddedFunction(STHS34PF80_EMBEDDED_RESET_ALGO,
+                                        &reset_value, 1);
+}
+
+/*!
+ * @brief Track the conversion period for sample waits
+ * @param odr The output data rate value
+ */
+void Adafruit_STHS34PF80_AsyncSensor::setPeriod(sths34pf80_odr_t odr) {
+  float hz = Adafruit_STHS34PF80_Model::odrHz(odr);
+  _period_us = hz > 0 ? (uint32_t)(1000000.0f / hz) : 0;
+  _last_us = 0;
+}
+
+#endif // __linux__ && __cpp_impl_coroutine
@@ -0,0 +1,339 @@
+/*!
+ * @file Adafruit_STHS34PF80_Async.h
+ *
+ * C++20 coroutine API for driving many STHS34PF80 sensors from one thread
+ * on Linux hosts.
+ *
+ * Every wait in the blocking driver (boot delay, the DRDY wait of a safe
+ * power-down, waiting for the next sample) becomes a timer suspension on a
+ * single-threaded event loop, so one thread multiplexes thousands of
+ * sensor sessions:
+ *
+ *   Adafruit_STHS34PF80_Loop loop;
+ *   Adafruit_STHS34PF80_AsyncSensor session(&loop, &sths);
+ *
+ *   Adafruit_STHS34PF80_Task<void> run(Adafruit_STHS34PF80_AsyncSensor* s) {
+ *     co_await s->setOutputDataRateAsync(STHS34PF80_ODR_8_HZ);
+ *     sths34pf80_sample_t sample;
+ *     while (co_await s->nextSample(&sample)) { ... }
+ *   }
+ *
+ *   loop.spawn(run(&session));
+ *   loop.run();
+ *
+ * Only available when compiling for Linux as C++20 or later.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_ASYNC_H__
+#define __ADAFRUIT_STHS34PF80_ASYNC_H__
+
+#if defined(__linux__) && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <queue>
+#include <vector>
+
+#include "Adafruit_STHS34PF80.h"
+
+#define STHS34PF80_ASYNC_MIN_POLL_US 1000 ///< Shortest DRDY polling interval
+
+/*!
+ * @brief Promise state shared by all task types
+ */
+struct Adafruit_STHS34PF80_TaskPromise {
+  std::coroutine_handle<> continuation; ///< Awaiting coroutine, if any
+  uint32_t* live; ///< Loop task counter of a detached task, else NULL
+
+  /*!
+   * @brief Resumes the awaiting coroutine, or frees a detached task
+   */
+  struct FinalAwaiter {
+    /*!
+     * @brief Always suspend at the end
+     * @return False
+     */
+    bool await_ready() noexcept { return false; }
+    /*!
+     * @brief Hand control to whoever waits for this task
+     * @param handle The finishing coroutine
+     * @return Coroutine to run next
+     */
+    template <typename P>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<P> handle) noexcept {
+      Adafruit_STHS34PF80_TaskPromise& promise = handle.promise();
+      if (promise.continuation) {
+        return promise.continuation;
+      }
+      if (promise.live) {
+        (*promise.live)--;
+        handle.destroy();
+      }
+      return std::noop_coroutine();
+    }
+    /*!
+     * @brief Nothing to resume with
+     */
+    void await_resume() noexcept {}
+  };
+
+  Adafruit_STHS34PF80_TaskPromise() : live(NULL) {}
+
+  /*!
+   * @brief Tasks start when awaited or spawned
+   * @return Suspend
+   */
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  /*!
+   * @brief Continue with the awaiting coroutine
+   * @return The final awaiter
+   */
+  FinalAwaiter final_suspend() noexcept { return {}; }
+  /*!
+   * @brief The driver does not throw; anything else is fatal
+   */
+  void unhandled_exception() { std::terminate(); }
+};
+
+/*!
+ * @brief Result storage of a task returning T
+ */
+template <typename T>
+struct Adafruit_STHS34PF80_TaskResult {
+  T value{}; ///< The returned value
+
+  /*!
+   * @brief Store the co_return value
+   * @param result The value
+   */
+  void return_value(T result) { value = result; }
+  /*!
+   * @brief Get the stored value
+   * @return The value
+   */
+  T result() { return value; }
+};
+
+/*!
+ * @brief Result storage of a task returning nothing
+ */
+template <>
+struct Adafruit_STHS34PF80_TaskResult<void> {
+  /*!
+   * @brief Accept a plain co_return
+   */
+  void return_void() {}
+  /*!
+   * @brief Nothing to return
+   */
+  void result() {}
+};
+
+/*!
+ * @brief Lazily started coroutine returning T, awaited with co_await or
+ * run detached with Adafruit_STHS34PF80_Loop::spawn()
+ */
+template <typename T>
+class Adafruit_STHS34PF80_Task {
+ public:
+  /*!
+   * @brief Coroutine promise
+   */
+  struct promise_type : Adafruit_STHS34PF80_TaskPromise,
+                        Adafruit_STHS34PF80_TaskResult<T> {
+    /*!
+     * @brief Create the task object for a new coroutine
+     * @return The task
+     */
+    Adafruit_STHS34PF80_Task get_return_object() {
+      return Adafruit_STHS34PF80_Task(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+  };
+
+  /*!
+   * @brief Takes ownership of a coroutine
+   * @param handle The coroutine
+   */
+  explicit Adafruit_STHS34PF80_Task(std::coroutine_handle<promise_type> handle)
+      : _handle(handle) {}
+  /*!
+   * @brief Moves a task
+   * @param other Task left empty
+   */
+  Adafruit_STHS34PF80_Task(Adafruit_STHS34PF80_Task&& other) noexcept
+      : _handle(other._handle) {
+    other._handle = nullptr;
+  }
+  Adafruit_STHS34PF80_Task(const Adafruit_STHS34PF80_Task&) = delete;
+  Adafruit_STHS34PF80_Task& operator=(const Adafruit_STHS34PF80_Task&) =
+      delete;
+  ~Adafruit_STHS34PF80_Task() {
+    if (_handle) {
+      _handle.destroy();
+    }
+  }
+
+  /*!
+   * @brief Check whether the task already finished
+   * @return True if there is nothing to wait for
+   */
+  bool await_ready() { return !_handle || _handle.done(); }
+  /*!
+   * @brief Start the task, resuming the caller when it finishes
+   * @param caller The awaiting coroutine
+   * @return The task, run next
+   */
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) {
+    _handle.promise().continuation = caller;
+    return _handle;
+  }
+  /*!
+   * @brief Get the task result
+   * @return The co_return value
+   */
+  T await_resume() { return _handle.promise().result(); }
+
+  /*!
+   * @brief Give up ownership of the coroutine
+   * @return The coroutine
+   */
+  std::coroutine_handle<promise_type> release() {
+    std::coroutine_handle<promise_type> handle = _handle;
+    _handle = nullptr;
+    return handle;
+  }
+
+ private:
+  std::coroutine_handle<promise_type> _handle;
+};
+
+/*!
+ * @brief Class that runs coroutines and their timers on the calling thread
+ *
+ * Time is the monotonic system clock, or an Adafruit_STHS34PF80_SimClock
+ * that the loop jumps forward to the next timer whenever every task is
+ * waiting, so simulations run as fast as the CPU allows. Keep the loop
+ * alive until run() returns: it does not free suspended tasks.
+ */
+class Adafruit_STHS34PF80_Loop {
+ public:
+  /*!
+   * @brief Suspends the awaiting coroutine until a loop time
+   */
+  struct Sleep {
+    Adafruit_STHS34PF80_Loop* loop; ///< The loop
+    uint64_t wake_us;               ///< Loop time to resume at
+
+    /*!
+     * @brief Skip the suspension if the time has passed
+     * @return True if already due
+     */
+    bool await_ready() { return wake_us <= loop->nowMicros(); }
+    /*!
+     * @brief Register the timer
+     * @param handle The sleeping coroutine
+     */
+    void await_suspend(std::coroutine_handle<> handle) {
+      loop->schedule(wake_us, handle);
+    }
+    /*!
+     * @brief Nothing to resume with
+     */
+    void await_resume() {}
+  };
+
+  explicit Adafruit_STHS34PF80_Loop(
+      Adafruit_STHS34PF80_SimClock* sim_clock = NULL);
+
+  void spawn(Adafruit_STHS34PF80_Task<void> task);
+  void run();
+  bool runOnce();
+  uint32_t activeTasks();
+
+  uint64_t nowMicros();
+  Sleep sleepFor(uint64_t us);
+  Sleep sleepUntil(uint64_t wake_us);
+
+  uint64_t timerWakeups();
+
+ private:
+  /// Pending wakeup, ordered by time then by arrival
+  struct Timer {
+    uint64_t wake_us;
+    uint64_t seq;
+    std::coroutine_handle<> handle;
+    bool operator>(const Timer& other) const {
+      return wake_us != other.wake_us ? wake_us > other.wake_us
+                                      : seq > other.seq;
+    }
+  };
+
+  void schedule(uint64_t wake_us, std::coroutine_handle<> handle);
+  void idle(uint64_t until_us);
+
+  Adafruit_STHS34PF80_SimClock* _sim_clock;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> >
+      _timers;
+  std::deque<std::coroutine_handle<> > _ready;
+  uint64_t _seq;
+  uint64_t _wakeups;
+  uint32_t _live;
+};
+
+/*!
+ * @brief Class that runs the STHS34PF80 operations with waits as
+ * coroutines on an Adafruit_STHS34PF80_Loop
+ *
+ * Register transactions still go through the driver and complete
+ * synchronously (Linux i2c-dev transfers do), so a session gives up the
+ * thread only where the blocking driver would sleep. The sequences match
+ * the driver's: an ODR change to an operative rate resets the algorithm,
+ * a power-down waits for the running conversion first, and embedded page
+ * access powers down around the transfer and restores the rate.
+ *
+ * Run one operation at a time per session, as with the driver itself.
+ */
+class Adafruit_STHS34PF80_AsyncSensor {
+ public:
+  Adafruit_STHS34PF80_AsyncSensor(Adafruit_STHS34PF80_Loop* loop,
+                                  Adafruit_STHS34PF80* sensor);
+
+  Adafruit_STHS34PF80_Task<bool> resetAsync();
+  Adafruit_STHS34PF80_Task<bool> setOutputDataRateAsync(sths34pf80_odr_t odr);
+  Adafruit_STHS34PF80_Task<bool> writeEmbeddedFunctionAsync(uint8_t addr,
+                                                            uint8_t* data,
+                                                            uint8_t len);
+  Adafruit_STHS34PF80_Task<bool> readEmbeddedFunctionAsync(uint8_t addr,
+                                                           uint8_t* data,
+                                                           uint8_t len);
+  Adafruit_STHS34PF80_Task<bool> readAllAsync(sths34pf80_sample_t* sample);
+  Adafruit_STHS34PF80_Task<bool> nextSample(sths34pf80_sample_t* sample);
+
+  Adafruit_STHS34PF80* sensor();
+
+ private:
+  Adafruit_STHS34PF80_Task<bool> powerDownAsync(sths34pf80_odr_t current);
+  Adafruit_STHS34PF80_Task<bool> waitDataReady();
+  bool writeOdr(sths34pf80_odr_t odr);
+  bool resetAlgorithm();
+  void setPeriod(sths34pf80_odr_t odr);
+
+  Adafruit_STHS34PF80_Loop* _loop;
+  Adafruit_STHS34PF80* _sensor;
+  uint32_t _period_us;
+  uint64_t _last_us;
+};
+
+#endif // __linux__ && __cpp_impl_coroutine
+
+#endif
@@ -0,0 +1,531 @@
+/*!
+ * @file Adafruit_STHS34PF80_BatchStats.cpp
+ *
+ * Vectorized rolling statistics over many STHS34PF80 sample streams.
+ *
+ * Kernels are written three times: SSE2 (x86-64 gateways), NEON (ARM
+ * gateways such as the Raspberry Pi) and a scalar loop that also runs on
+ * the MCU. The vector kernels process 8 sensors (push, min/max) or 8
+ * samples (reduce) per step and keep exact integer sums: int32 for values,
+ * int64 for squares. See the batch statistics benchmark example for the
+ * throughput against a naive per-sample loop.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_BatchStats.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define STHS34PF80_STATS_SSE2 ///< Use the SSE2 kernels
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define STHS34PF80_STATS_NEON ///< Use the NEON kernels
+#endif
+
+#define STHS34PF80_STATS_FLUSH 16384 ///< Vector blocks between int32 flushes
+
+/*!
+ * @brief Instantiates an empty window; call begin() before use
+ */
+Adafruit_STHS34PF80_BatchStats::Adafruit_STHS34PF80_BatchStats()
+    : _sum_sq(NULL),
+      _sum(NULL),
+      _min(NULL),
+      _max(NULL),
+      _rows(NULL),
+      _sensors(0),
+      _stride(0),
+      _window(0),
+      _head(0),
+      _count(0),
+      _minmax_stale(false) {}
+
+/*!
+ * @brief Get the storage begin() needs
+ * @param sensors Number of sensors (values per row)
+ * @param window Rows kept in the window
+ * @return Size in bytes
+ */
+size_t Adafruit_STHS34PF80_BatchStats::storageSize(uint16_t sensors,
+                                                   uint16_t window) {
+  size_t stride = (sensors + STHS34PF80_STATS_LANES - 1) /
+                  STHS34PF80_STATS_LANES * STHS34PF80_STATS_LANES;
+  return stride * (sizeof(int64_t) + sizeof(int32_t) + 2 * sizeof(int16_t) +
+                   (size_t)window * sizeof(int16_t));
+}
+
+/*!
+ * @brief Attach the storage and clear the window
+ * @param storage storageSize(sensors, window) bytes, 8-byte aligned
+ * @param sensors Number of sensors (values per row)
+ * @param window Rows kept in the window
+ * @return False on missing storage or a zero size
+ */
+bool Adafruit_STHS34PF80_BatchStats::begin(void* storage, uint16_t sensors,
+                                           uint16_t window) {
+  if (!storage || !sensors || !window) {
+    return false;
+  }
+
+  // Widest arrays first so every array stays naturally aligned
+  _stride = (sensors + STHS34PF80_STATS_LANES - 1) / STHS34PF80_STATS_LANES *
+            STHS34PF80_STATS_LANES;
+  _sum_sq = (int64_t*)storage;
+  _sum = (int32_t*)(_sum_sq + _stride);
+  _min = (int16_t*)(_sum + _stride);
+  _max = _min + _stride;
+  _rows = _max + _stride;
+  _sensors = sensors;
+  _window = window;
+  reset();
+  return true;
+}
+
+/*!
+ * @brief Empty the window
+ */
+void Adafruit_STHS34PF80_BatchStats::reset() {
+  if (!_rows) {
+    return;
+  }
+  memset(_sum_sq, 0, storageSize(_sensors, _window));
+  _head = 0;
+  _count = 0;
+  _minmax_stale = false;
+}
+
+/*!
+ * @brief Add one value per sensor, dropping the oldest row once the window
+ * is full
+ * @param row sensors() values, e.g. the TPRESENCE of every sensor
+ */
+void Adafruit_STHS34PF80_BatchStats::push(const int16_t* row) {
+  if (!_rows || !row) {
+    return;
+  }
+
+  int16_t* slot = _rows + (size_t)_head * _stride;
+  bool full = _count == _window;
+  uint16_t i = 0;
+
+#if defined(STHS34PF80_STATS_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + STHS34PF80_STATS_LANES <= _sensors; i += STHS34PF80_STATS_LANES) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+    __m128i o = full ? _mm_loadu_si128((const __m128i*)(slot + i)) : zero;
+    _mm_storeu_si128((__m128i*)(slot + i), x);
+
+    // Sums: sign-extend both rows to int32 and add the difference
+    __m128i xl = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+    __m128i xh = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+    __m128i ol = _mm_srai_epi32(_mm_unpacklo_epi16(o, o), 16);
+    __m128i oh = _mm_srai_epi32(_mm_unpackhi_epi16(o, o), 16);
+    __m128i* sum = (__m128i*)(_sum + i);
+    _mm_storeu_si128(sum, _mm_add_epi32(_mm_loadu_si128(sum),
+                                        _mm_sub_epi32(xl, ol)));
+    _mm_storeu_si128(sum + 1, _mm_add_epi32(_mm_loadu_si128(sum + 1),
+                                            _mm_sub_epi32(xh, oh)));
+
+    // Squares: 16x16 -> 32 bit products, difference widened to int64
+    __m128i xlo = _mm_mullo_epi16(x, x);
+    __m128i xhi = _mm_mulhi_epi16(x, x);
+    __m128i olo = _mm_mullo_epi16(o, o);
+    __m128i ohi = _mm_mulhi_epi16(o, o);
+    __m128i q[2] = {_mm_sub_epi32(_mm_unpacklo_epi16(xlo, xhi),
+                                  _mm_unpacklo_epi16(olo, ohi)),
+                    _mm_sub_epi32(_mm_unpackhi_epi16(xlo, xhi),
+                                  _mm_unpackhi_epi16(olo, ohi))};
+    __m128i* sq = (__m128i*)(_sum_sq + i);
+    for (uint8_t h = 0; h < 2; h++) {
+      __m128i sign = _mm_srai_epi32(q[h], 31);
+      __m128i a = _mm_unpacklo_epi32(q[h], sign);
+      __m128i b = _mm_unpackhi_epi32(q[h], sign);
+      _mm_storeu_si128(sq + 2 * h,
+                       _mm_add_epi64(_mm_loadu_si128(sq + 2 * h), a));
+      _mm_storeu_si128(sq + 2 * h + 1,
+                       _mm_add_epi64(_mm_loadu_si128(sq + 2 * h + 1), b));
+    }
+  }
+#elif defined(STHS34PF80_STATS_NEON)
+  const int16x8_t zero = vdupq_n_s16(0);
+  for (; i + STHS34PF80_STATS_LANES <= _sensors; i += STHS34PF80_STATS_LANES) {
+    int16x8_t x = vld1q_s16(row + i);
+    int16x8_t o = full ? vld1q_s16(slot + i) : zero;
+    vst1q_s16(slot + i, x);
+
+    int16x4_t xl = vget_low_s16(x);
+    int16x4_t xh = vget_high_s16(x);
+    int16x4_t ol = vget_low_s16(o);
+    int16x4_t oh = vget_high_s16(o);
+    vst1q_s32(_sum + i, vaddq_s32(vld1q_s32(_sum + i), vsubl_s16(xl, ol)));
+    vst1q_s32(_sum + i + 4,
+              vaddq_s32(vld1q_s32(_sum + i + 4), vsubl_s16(xh, oh)));
+
+    int32x4_t ql = vsubq_s32(vmull_s16(xl, xl), vmull_s16(ol, ol));
+    int32x4_t qh = vsubq_s32(vmull_s16(xh, xh), vmull_s16(oh, oh));
+    int64_t* sq = _sum_sq + i;
+    vst1q_s64(sq, vaddw_s32(vld1q_s64(sq), vget_low_s32(ql)));
+    vst1q_s64(sq + 2, vaddw_s32(vld1q_s64(sq + 2), vget_high_s32(ql)));
+    vst1q_s64(sq + 4, vaddw_s32(vld1q_s64(sq + 4), vget_low_s32(qh)));
+    vst1q_s64(sq + 6, vaddw_s32(vld1q_s64(sq + 6), vget_high_s32(qh)));
+  }
+#endif
+
+  for (; i < _sensors; i++) {
+    int32_t x = row[i];
+    int32_t o = full ? slot[i] : 0;
+    slot[i] = row[i];
+    _sum[i] += x - o;
+    _sum_sq[i] += x * x - o * o;
+  }
+
+  _head = (_head + 1) % _window;
+  if (!full) {
+    _count++;
+  }
+  _minmax_stale = true;
+}
+
+/*!
+ * @brief Get the number of rows in the window
+ * @return Rows, up to the window length
+ */
+uint16_t Adafruit_STHS34PF80_BatchStats::count() { return _count; }
+
+/*!
+ * @brief Get the number of sensors per row
+ * @return Sensors
+ */
+uint16_t Adafruit_STHS34PF80_BatchStats::sensors() { return _sensors; }
+
+/*!
+ * @brief Get one sensor's window statistics
+ * @param sensor Sensor index
+ * @param stats Set to the statistics
+ * @return False on a bad index or an empty window
+ */
+bool Adafruit_STHS34PF80_BatchStats::stats(uint16_t sensor,
+                                           sths34pf80_stats_t* stats) {
+  if (!stats || sensor >= _sensors || !_count) {
+    return false;
+  }
+  refreshMinMax();
+  stats->count = _count;
+  stats->min = _min[sensor];
+  stats->max = _max[sensor];
+  stats->sum = _sum[sensor];
+  stats->sum_sq = (uint64_t)_sum_sq[sensor];
+  return true;
+}
+
+/*!
+ * @brief Get every sensor's window minimum
+ * @return sensors() minimums, valid until the next push()
+ */
+const int16_t* Adafruit_STHS34PF80_BatchStats::minimums() {
+  refreshMinMax();
+  return _min;
+}
+
+/*!
+ * @brief Get every sensor's window maximum
+ * @return sensors() maximums, valid until the next push()
+ */
+const int16_t* Adafruit_STHS34PF80_BatchStats::maximums() {
+  refreshMinMax();
+  return _max;
+}
+
+/*!
+ * @brief Move the k-th smallest value to data[k] (quickselect)
+ * @param data Values, reordered
+ * @param n Number of values
+ * @param k Rank
+ * @return The k-th smallest value
+ */
+static int16_t selectRank(int16_t* data, size_t n, size_t k) {
+  size_t lo = 0;
+  size_t hi = n - 1;
+  while (lo < hi) {
+    int16_t pivot = data[lo + (hi - lo) / 2];
+    size_t i = lo;
+    size_t j = hi;
+    while (i <= j) {
+      while (data[i] < pivot) {
+        i++;
+      }
+      while (data[j] > pivot) {
+        j--;
+      }
+      if (i <= j) {
+        int16_t t = data[i];
+        data[i] = data[j];
+        data[j] = t;
+        i++;
+        if (j == 0) {
+          break;
+        }
+        j--;
+      }
+    }
+    if (k <= j) {
+      hi = j;
+    } else if (k >= i) {
+      lo = i;
+    } else {
+      break;
+    }
+  }
+  return data[k];
+}
+
+/*!
+ * @brief Nearest-rank percentile of a value array
+ * @param n Number of values
+ * @param pct Percentile, 0 to 100
+ * @return Rank of the percentile
+ */
+static size_t percentileRank(size_t n, uint8_t pct) {
+  if (pct > 100) {
+    pct = 100;
+  }
+  return ((n - 1) * pct + 50) / 100;
+}
+
+/*!
+ * @brief Get a percentile of one sensor's window
+ * @param sensor Sensor index
+ * @param pct Percentile, 0 to 100
+ * @param scratch count() values of scratch space
+ * @return The percentile, 0 on a bad index or an empty window
+ */
+int16_t Adafruit_STHS34PF80_BatchStats::percentile(uint16_t sensor,
+                                                   uint8_t pct,
+                                                   int16_t* scratch) {
+  if (!scratch || sensor >= _sensors || !_count) {
+    return 0;
+  }
+  for (uint16_t r = 0; r < _count; r++) {
+    scratch[r] = _rows[(size_t)r * _stride + sensor];
+  }
+  return selectRank(scratch, _count, percentileRank(_count, pct));
+}
+
+/*!
+ * @brief Summarize one contiguous stream, vectorized where available
+ * @param data Values
+ * @param n Number of values
+ * @param stats Set to the statistics
+ */
+void Adafruit_STHS34PF80_BatchStats::reduce(const int16_t* data, size_t n,
+                                            sths34pf80_stats_t* stats) {
+  size_t i = 0;
+  int16_t lo = 32767;
+  int16_t hi = -32768;
+  int64_t sum = 0;
+  uint64_t sum_sq = 0;
+
+#if defined(STHS34PF80_STATS_SSE2)
+  __m128i vmin = _mm_set1_epi16(32767);
+  __m128i vmax = _mm_set1_epi16(-32768);
+  __m128i vsq = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+  const __m128i zero = _mm_setzero_si128();
+  while (i + STHS34PF80_STATS_LANES <= n) {
+    __m128i vsum = _mm_setzero_si128();
+    for (uint16_t b = 0; b < STHS34PF80_STATS_FLUSH &&
+                         i + STHS34PF80_STATS_LANES <= n;
+         b++, i += STHS34PF80_STATS_LANES) {
+      __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+      vmin = _mm_min_epi16(vmin, x);
+      vmax = _mm_max_epi16(vmax, x);
+      vsum = _mm_add_epi32(vsum, _mm_madd_epi16(x, ones));
+      // Pairs of squares are at most 2^31, so they fit unsigned 32 bit
+      __m128i sq = _mm_madd_epi16(x, x);
+      vsq = _mm_add_epi64(vsq, _mm_unpacklo_epi32(sq, zero));
+      vsq = _mm_add_epi64(vsq, _mm_unpackhi_epi32(sq, zero));
+    }
+    int32_t s[4];
+    _mm_storeu_si128((__m128i*)s, vsum);
+    sum += (int64_t)s[0] + s[1] + s[2] + s[3];
+  }
+  int16_t m[2][STHS34PF80_STATS_LANES];
+  uint64_t q[2];
+  _mm_storeu_si128((__m128i*)m[0], vmin);
+  _mm_storeu_si128((__m128i*)m[1], vmax);
+  _mm_storeu_si128((__m128i*)q, vsq);
+  sum_sq = q[0] + q[1];
+  for (uint8_t l = 0; l < STHS34PF80_STATS_LANES; l++) {
+    lo = m[0][l] < lo ? m[0][l] : lo;
+    hi = m[1][l] > hi ? m[1][l] : hi;
+  }
+#elif defined(STHS34PF80_STATS_NEON)
+  int16x8_t vmin = vdupq_n_s16(32767);
+  int16x8_t vmax = vdupq_n_s16(-32768);
+  uint64x2_t vsq = vdupq_n_u64(0);
+  while (i + STHS34PF80_STATS_LANES <= n) {
+    int32x4_t vsum = vdupq_n_s32(0);
+    for (uint16_t b = 0; b < STHS34PF80_STATS_FLUSH &&
+                         i + STHS34PF80_STATS_LANES <= n;
+         b++, i += STHS34PF80_STATS_LANES) {
+      int16x8_t x = vld1q_s16(data + i);
+      vmin = vminq_s16(vmin, x);
+      vmax = vmaxq_s16(vmax, x);
+      vsum = vpadalq_s16(vsum, x);
+      int32x4_t sl = vmull_s16(vget_low_s16(x), vget_low_s16(x));
+      int32x4_t sh = vmull_s16(vget_high_s16(x), vget_high_s16(x));
+      vsq = vpadalq_u32(vsq, vreinterpretq_u32_s32(sl));
+      vsq = vpadalq_u32(vsq, vreinterpretq_u32_s32(sh));
+    }
+    int32_t s[4];
+    vst1q_s32(s, vsum);
+    sum += (int64_t)s[0] + s[1] + s[2] + s[3];
+  }
+  int16_t m[2][STHS34PF80_STATS_LANES];
+  uint64_t q[2];
+  vst1q_s16(m[0], vmin);
+  vst1q_s16(m[1], vmax);
+  vst1q_u64(q, vsq);
+  sum_sq = q[0] + q[1];
+  for (uint8_t l = 0; l < STHS34PF80_STATS_LANES; l++) {
+    lo = m[0][l] < lo ? m[0][l] : lo;
+    hi = m[1][l] > hi ? m[1][l] : hi;
+  }
+#endif
+
+  for (; i < n; i++) {
+    int32_t x = data[i];
+    lo = x < lo ? x : lo;
+    hi = x > hi ? x : hi;
+    sum += x;
+    sum_sq += (uint32_t)(x * x);
+  }
+
+  stats->count = n;
+  stats->min = n ? lo : 0;
+  stats->max = n ? hi : 0;
+  stats->sum = sum;
+  stats->sum_sq = sum_sq;
+}
+
+/*!
+ * @brief Summarize one contiguous stream with the plain scalar loop, the
+ * reference reduce() is checked and benchmarked against
+ * @param data Values
+ * @param n Number of values
+ * @param stats Set to the statistics
+ */
+void Adafruit_STHS34PF80_BatchStats::reduceScalar(const int16_t* data,
+                                                  size_t n,
+                                                  sths34pf80_stats_t* stats) {
+  int16_t lo = 32767;
+  int16_t hi = -32768;
+  int64_t sum = 0;
+  uint64_t sum_sq = 0;
+  for (size_t i = 0; i < n; i++) {
+    int32_t x = data[i];
+    lo = x < lo ? x : lo;
+    hi = x > hi ? x : hi;
+    sum += x;
+    sum_sq += (uint32_t)(x * x);
+  }
+  stats->count = n;
+  stats->min = n ? lo : 0;
+  stats->max = n ? hi : 0;
+  stats->sum = sum;
+  stats->sum_sq = sum_sq;
+}
+
+/*!
+ * @brief Nearest-rank percentile of one contiguous stream
+ * @param data Values, left untouched
+ * @param n Number of values
+ * @param pct Percentile, 0 to 100
+ * @param scratch n values of scratch space
+ * @return The percentile, 0 if n is 0
+ */
+int16_t Adafruit_STHS34PF80_BatchStats::percentileOf(const int16_t* data,
+                                                     size_t n, uint8_t pct,
+                                                     int16_t* scratch) {
+  if (!data || !scratch || !n) {
+    return 0;
+  }
+  memcpy(scratch, data, n * sizeof(int16_t));
+  return selectRank(scratch, n, percentileRank(n, pct));
+}
+
+/*!
+ * @brief Mean of summarized values
+ * @param stats The statistics
+ * @return The mean, 0 if empty
+ */
+float Adafruit_STHS34PF80_BatchStats::mean(const sths34pf80_stats_t& stats) {
+  return stats.count ? (float)stats.sum / stats.count : 0;
+}
+
+/*!
+ * @brief Population variance of summarized values
+ * @param stats The statistics
+ * @return The variance, 0 if empty
+ */
+float Adafruit_STHS34PF80_BatchStats::variance(
+    const sths34pf80_stats_t& stats) {
+  if (!stats.count) {
+    return 0;
+  }
+  double mean = (double)stats.sum / stats.count;
+  double var = (double)stats.sum_sq / stats.count - mean * mean;
+  return var > 0 ? (float)var : 0;
+}
+
+/*!
+ * @brief Check which kernels were compiled in
+ * @return True if SSE2 or NEON kernels are used
+ */
+bool Adafruit_STHS34PF80_BatchStats::vectorized() {
+#if defined(STHS34PF80_STATS_SSE2) || defined(STHS34PF80_STATS_NEON)
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+ * @brief Recompute every sensor's min/max if rows changed since last time
+ */
+void Adafruit_STHS34PF80_BatchStats::refreshMinMax() {
+  if (!_minmax_stale || !_count) {
+    return;
+  }
+
+  memcpy(_min, _rows, _stride * sizeof(int16_t));
+  memcpy(_max, _rows, _stride * sizeof(int16_t));
+  for (uint16_t r = 1; r < _count; r++) {
+    const int16_t* row = _rows + (size_t)r * _stride;
+    uint16_t i = 0;
+#if defined(STHS34PF80_STATS_SSE2)
+    for (; i < _stride; i += STHS34PF80_STATS_LANES) {
+      __m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+      __m128i* lo = (__m128i*)(_min + i);
+      __m128i* hi = (__m128i*)(_max + i);
+      _mm_storeu_si128(lo, _mm_min_epi16(_mm_loadu_si128(lo), x));
+      _mm_storeu_si128(hi, _mm_max_epi16(_mm_loadu_si128(hi), x));
+    }
+#elif defined(STHS34PF80_STATS_NEON)
+    for (; i < _stride; i += STHS34PF80_STATS_LANES) {
+      int16x8_t x = vld1q_s16(row + i);
+      vst1q_s16(_min + i, vminq_s16(vld1q_s16(_min + i), x));
+      vst1q_s16(_max + i, vmaxq_s16(vld1q_s16(_max + i), x));
+    }
+#endif
+    for (; i < _stride; i++) {
+      _min[i] = row[i] < _min[i] ? row[i] : _min[i];
+      _max[i] = row[i] > _max[i] ? row[i] : _max[i];
+    }
+  }
+  _minmax_stale = false;
+}
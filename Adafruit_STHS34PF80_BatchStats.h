@@ -0,0 +1,88 @@
+/*!
+ * @file Adafruit_STHS34PF80_BatchStats.h
+ *
+ * Vectorized rolling statistics over many STHS34PF80 sample streams.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_BATCHSTATS_H__
+#define __ADAFRUIT_STHS34PF80_BATCHSTATS_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+#define STHS34PF80_STATS_LANES 8 ///< int16 lanes per vector, rows pad to it
+
+/*!
+ * @brief Summary of a window of int16 values
+ */
+typedef struct {
+  uint32_t count;  ///< Number of values
+  int16_t min;     ///< Smallest value
+  int16_t max;     ///< Largest value
+  int64_t sum;     ///< Sum of the values
+  uint64_t sum_sq; ///< Sum of the squared values
+} sths34pf80_stats_t;
+
+/*!
+ * @brief Class that keeps rolling statistics of one channel (e.g. TOBJECT,
+ * TPRESENCE or TMOTION) for many sensors at once
+ *
+ * Samples are stored row by row: one row holds the newest value of every
+ * sensor, so each update and each reduction is a run of vertical vector
+ * operations over contiguous int16 data (SSE2 or NEON when the compiler
+ * targets them, a portable scalar loop otherwise). Sums and sums of
+ * squares are updated incrementally as rows enter and leave the window;
+ * min/max are recomputed lazily, only when asked for after a change.
+ *
+ * The caller provides the storage, storageSize() bytes, so nothing is
+ * allocated.
+ */
+class Adafruit_STHS34PF80_BatchStats {
+ public:
+  Adafruit_STHS34PF80_BatchStats();
+
+  static size_t storageSize(uint16_t sensors, uint16_t window);
+  bool begin(void* storage, uint16_t sensors, uint16_t window);
+  void reset();
+
+  void push(const int16_t* row);
+  uint16_t count();
+  uint16_t sensors();
+
+  bool stats(uint16_t sensor, sths34pf80_stats_t* stats);
+  const int16_t* minimums();
+  const int16_t* maximums();
+  int16_t percentile(uint16_t sensor, uint8_t pct, int16_t* scratch);
+
+  static void reduce(const int16_t* data, size_t n, sths34pf80_stats_t* stats);
+  static void reduceScalar(const int16_t* data, size_t n,
+                           sths34pf80_stats_t* stats);
+  static int16_t percentileOf(const int16_t* data, size_t n, uint8_t pct,
+                              int16_t* scratch);
+  static float mean(const sths34pf80_stats_t& stats);
+  static float variance(const sths34pf80_stats_t& stats);
+  static bool vectorized();
+
+ private:
+  void refreshMinMax();
+
+  int64_t* _sum_sq; // Stored signed: rows add and remove squares
+  int32_t* _sum;
+  int16_t* _min;
+  int16_t* _max;
+  int16_t* _rows;
+  uint16_t _sensors;
+  uint16_t _stride;
+  uint16_t _window;
+  uint16_t _head;
+  uint16_t _count;
+  bool _minmax_stale;
+};
+
+#endif
@@ -0,0 +1,181 @@
+/*!
+ * @file Adafruit_STHS34PF80_Calibration.h
+ *
+ * Empty-room threshold calibration for the STHS34PF80 presence and motion
+ * detection algorithms, and SENS_DATA sensitivity calibration against a
+ * reference target.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_CALIBRATION_H__
+#define __ADAFRUIT_STHS34PF80_CALIBRATION_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+#define STHS34PF80_THRESHOLD_MAX 0x7FFF ///< Largest 15-bit algorithm threshold
+#define STHS34PF80_SENS_CAL_MIN_CONTRAST \
+  5.0f ///< Default least reference-ambient difference, degC
+#define STHS34PF80_SENS_CAL_TOLERANCE \
+  0.5f ///< Default largest verified object temperature error, degC
+
+/*!
+ * @brief Robust noise statistics for one signal
+ */
+typedef struct {
+  float median; ///< Median of the samples
+  float mad;    ///< Median absolute deviation from the median
+  float p99;    ///< 99th percentile of the absolute deviation from the median
+  float sigma;  ///< Robust standard deviation estimate (1.4826 * MAD)
+} sths34pf80_noise_stats_t;
+
+/*!
+ * @brief Presence and motion detection thresholds and hysteresis
+ */
+typedef struct {
+  uint16_t presence_threshold; ///< PRESENCE_THS value (15 bits)
+  uint16_t motion_threshold;   ///< MOTION_THS value (15 bits)
+  uint8_t presence_hysteresis; ///< HYST_PRESENCE value
+  uint8_t motion_hysteresis;   ///< HYST_MOTION value
+} sths34pf80_thresholds_t;
+
+/*!
+ * @brief Outcome of a sensitivity calibration
+ */
+typedef enum {
+  STHS34PF80_SENS_CAL_OK = 0x00,           ///< Programmed and verified
+  STHS34PF80_SENS_CAL_TIMEOUT = 0x01,      ///< Too few samples in the window
+  STHS34PF80_SENS_CAL_LOW_CONTRAST = 0x02, ///< Reference too close to ambient
+  STHS34PF80_SENS_CAL_OUT_OF_RANGE = 0x03, ///< Outside the SENS_DATA range
+  STHS34PF80_SENS_CAL_WRITE_FAILED = 0x04, ///< Write or read-back failed
+  STHS34PF80_SENS_CAL_RESIDUAL = 0x05,     ///< Verified error above tolerance
+  STHS34PF80_SENS_CAL_SATURATED = 0x06,    ///< TOBJECT hit its limits
+} sths34pf80_sens_cal_status_t;
+
+/*!
+ * @brief Measurements and result of a sensitivity calibration
+ */
+typedef struct {
+  sths34pf80_sens_cal_status_t status; ///< Outcome
+  uint16_t samples;                    ///< Samples averaged per window
+  float reference_c;                   ///< Reference temperature, degC
+  float ambient_c;                     ///< Mean ambient temperature, degC
+  float object_lsb;                    ///< Mean TOBJECT, LSB
+  float noise_lsb;                     ///< TOBJECT standard deviation
+  float sensitivity;                   ///< Effective sensitivity, LSB/degC
+  int8_t previous;                     ///< SENS_DATA before calibration
+  int8_t sens_data;                    ///< SENS_DATA programmed
+  float error_c;                       ///< Error with the previous value, degC
+  float residual_c;                    ///< Error after programming, degC
+} sths34pf80_sens_cal_t;
+
+/*!
+ * @brief Streaming quantile estimator (P-square algorithm) in constant memory
+ */
+class Adafruit_STHS34PF80_Quantile {
+ public:
+  Adafruit_STHS34PF80_Quantile(float quantile = 0.5f);
+
+  void reset();
+  void add(float x);
+  float value();
+  uint32_t count();
+
+ private:
+  float _p;
+  float _q[5];
+  int32_t _n[5];
+  uint32_t _count;
+};
+
+/*!
+ * @brief Class that derives detection thresholds from empty-room samples
+ */
+class Adafruit_STHS34PF80_Calibration {
+ public:
+  Adafruit_STHS34PF80_Calibration(Adafruit_STHS34PF80* sensor);
+
+  void setSigmaMultiplier(float multiplier);
+  void setHysteresisRatio(float ratio);
+
+  void reset();
+  void addSample(int16_t presence, int16_t motion);
+  uint16_t collect(uint16_t num_samples, uint32_t timeout_ms);
+  uint32_t sampleCount();
+
+  void getPresenceStats(sths34pf80_noise_stats_t* stats);
+  void getMotionStats(sths34pf80_noise_stats_t* stats);
+
+  bool computeThresholds(sths34pf80_thresholds_t* thresholds);
+  bool readThresholds(sths34pf80_thresholds_t* thresholds);
+  bool writeThresholds(const sths34pf80_thresholds_t& thresholds);
+  bool run(uint16_t num_samples, uint32_t timeout_ms,
+           sths34pf80_thresholds_t* thresholds = NULL);
+
+ private:
+  /*!
+   * @brief Median, MAD and tail estimators for one signal
+   */
+  struct Channel {
+    Adafruit_STHS34PF80_Quantile median; ///< Median of the raw samples
+    Adafruit_STHS34PF80_Quantile mad;    ///< Median of |x - median|
+    Adafruit_STHS34PF80_Quantile tail;   ///< 99th percentile of |x - median|
+    Channel();
+    void reset();
+    void add(int16_t x);
+    void stats(sths34pf80_noise_stats_t* stats);
+  };
+
+  uint16_t deriveThreshold(Channel& channel);
+  uint8_t deriveHysteresis(Channel& channel, uint16_t threshold);
+
+  Adafruit_STHS34PF80* _sensor;
+  Channel _presence;
+  Channel _motion;
+  float _sigma_multiplier;
+  float _hysteresis_ratio;
+};
+
+/*!
+ * @brief Class that fits SENS_DATA to the sensitivity seen through the
+ * optics in use, from a reference target of known temperature
+ *
+ * Windows and lenses attenuate the object signal, so the factory trim no
+ * longer matches and the object temperature and ambient compensation are
+ * off. With the reference filling the field of view, the mean TOBJECT over
+ * the window divided by the reference-ambient difference is the effective
+ * sensitivity. Calibrate in the gain mode used in operation.
+ */
+class Adafruit_STHS34PF80_SensitivityCalibration {
+ public:
+  Adafruit_STHS34PF80_SensitivityCalibration(Adafruit_STHS34PF80* sensor);
+
+  void setMinContrast(float min_contrast_c);
+  void setTolerance(float tolerance_c);
+
+  uint16_t measure(uint16_t num_samples, uint32_t timeout_ms,
+                   float* object_lsb, float* ambient_c,
+                   float* noise_lsb = NULL);
+  bool saturated();
+  bool program(int8_t sens_data);
+  sths34pf80_sens_cal_status_t verify(float reference_c, uint16_t num_samples,
+                                      uint32_t timeout_ms, float* residual_c);
+  bool run(float reference_c, uint16_t num_samples, uint32_t timeout_ms,
+           sths34pf80_sens_cal_t* result = NULL);
+
+  static float objectTemperature(float object_lsb, float ambient_c,
+                                 int8_t sens_data);
+
+ private:
+  Adafruit_STHS34PF80* _sensor;
+  float _min_contrast_c;
+  float _tolerance_c;
+  bool _saturated;
+};
+
+#endif
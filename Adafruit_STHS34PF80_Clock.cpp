@@ -0,0 +1,97 @@
+/*!
+ * @file Adafruit_STHS34PF80_Clock.cpp
+ *
+ * Injectable time source for the STHS34PF80 driver.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_Clock.h"
+
+/*!
+ * @brief Get the milliseconds since startup
+ * @return Arduino millis()
+ */
+uint32_t Adafruit_STHS34PF80_Clock::getMillis() { return millis(); }
+
+/*!
+ * @brief Get the microseconds since startup
+ * @return Arduino micros()
+ */
+uint32_t Adafruit_STHS34PF80_Clock::getMicros() { return micros(); }
+
+/*!
+ * @brief Wait for a number of milliseconds
+ * @param ms Milliseconds to wait
+ */
+void Adafruit_STHS34PF80_Clock::delayMillis(uint32_t ms) { delay(ms); }
+
+/*!
+ * @brief Get the shared clock backed by the Arduino timing calls
+ * @return The system clock, used by every driver until setClock() is called
+ */
+Adafruit_STHS34PF80_Clock* Adafruit_STHS34PF80_Clock::system() {
+  static Adafruit_STHS34PF80_Clock clock;
+  return &clock;
+}
+
+/*!
+ * @brief Instantiates a simulated clock
+ * @param start_us Initial simulated time in microseconds
+ */
+Adafruit_STHS34PF80_SimClock::Adafruit_STHS34PF80_SimClock(uint64_t start_us)
+    : _now_us(start_us), _read_step_us(0) {}
+
+/*!
+ * @brief Get the simulated milliseconds, advancing by the read step
+ * @return Simulated time in milliseconds, wrapping like millis()
+ */
+uint32_t Adafruit_STHS34PF80_SimClock::getMillis() {
+  _now_us += _read_step_us;
+  return (uint32_t)(_now_us / 1000);
+}
+
+/*!
+ * @brief Get the simulated microseconds, advancing by the read step
+ * @return Simulated time in microseconds, wrapping like micros()
+ */
+uint32_t Adafruit_STHS34PF80_SimClock::getMicros() {
+  _now_us += _read_step_us;
+  return (uint32_t)_now_us;
+}
+
+/*!
+ * @brief Advance the simulated time without waiting
+ * @param ms Milliseconds to advance
+ */
+void Adafruit_STHS34PF80_SimClock::delayMillis(uint32_t ms) {
+  _now_us += (uint64_t)ms * 1000;
+}
+
+/*!
+ * @brief Advance the simulated time
+ * @param us Microseconds to advance
+ */
+void Adafruit_STHS34PF80_SimClock::advance(uint64_t us) { _now_us += us; }
+
+/*!
+ * @brief Set the simulated time
+ * @param now_us New time in microseconds
+ */
+void Adafruit_STHS34PF80_SimClock::set(uint64_t now_us) { _now_us = now_us; }
+
+/*!
+ * @brief Get the full-width simulated time
+ * @return Simulated time in microseconds, without wrapping
+ */
+uint64_t Adafruit_STHS34PF80_SimClock::now() { return _now_us; }
+
+/*!
+ * @brief Set how far each getMillis()/getMicros() call moves the clock,
+ * so loops that poll for a timeout terminate without any delay
+ * @param us Microseconds per read, 0 (default) to only move on delays
+ */
+void Adafruit_STHS34PF80_SimClock::setReadStep(uint32_t us) {
+  _read_step_us = us;
+}
@@ -0,0 +1,62 @@
+/*!
+ * @file Adafruit_STHS34PF80_Clock.h
+ *
+ * Injectable time source for the STHS34PF80 driver, so host simulations
+ * and tests can run faster than real time.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_CLOCK_H__
+#define __ADAFRUIT_STHS34PF80_CLOCK_H__
+
+#include "Arduino.h"
+
+/*!
+ * @brief Clock the driver uses for delays, timestamps and timeouts
+ *
+ * The base class is backed by the Arduino millis(), micros() and delay()
+ * calls. Subclass it to run the driver on another time base.
+ */
+class Adafruit_STHS34PF80_Clock {
+ public:
+  virtual ~Adafruit_STHS34PF80_Clock() {}
+
+  virtual uint32_t getMillis();
+  virtual uint32_t getMicros();
+  virtual void delayMillis(uint32_t ms);
+
+  static Adafruit_STHS34PF80_Clock* system();
+};
+
+/*!
+ * @brief Simulated clock that only moves when told to
+ *
+ * delayMillis() returns immediately after advancing the simulated time, so
+ * every wait in the driver costs no wall-clock time. An optional per-read
+ * step makes polling loops progress too.
+ */
+class Adafruit_STHS34PF80_SimClock : public Adafruit_STHS34PF80_Clock {
+ public:
+  Adafruit_STHS34PF80_SimClock(uint64_t start_us = 0);
+
+  uint32_t getMillis();
+  uint32_t getMicros();
+  void delayMillis(uint32_t ms);
+
+  void advance(uint64_t us);
+  void set(uint64_t now_us);
+  uint64_t now();
+  void setReadStep(uint32_t us);
+
+ private:
+  uint64_t _now_us;
+  uint32_t _read_step_us;
+};
+
+#endif
@@ -0,0 +1,258 @@
+/*!
+ * @file Adafruit_STHS34PF80_DriftTracker.cpp
+ *
+ * Host-side ambient drift tracking for the STHS34PF80.
+ *
+ * The object baseline is an exponential average that learns quickly right
+ * after an ambient shock and slowly otherwise; while the residual is above
+ * the quiet gate (someone is present) it learns 16x slower still, so a
+ * person is not absorbed into the baseline but a permanent offset is. What
+ * is left of the ambient coupling (HVAC cycles, sunlight on the package)
+ * is tracked with a normalized LMS gain against the deviation of the
+ * ambient temperature from its own average. That average runs at the
+ * baseline's rate, so both deviations see the same filter and an ambient
+ * ramp shows up in them alike; the baseline averages the object signal
+ * itself, not the residual, so it does not soak up the coupled drift the
+ * gain is learning.
+ *
+ * All state is fixed-size integers (Q8 fixed point, the coupling Q16 so
+ * small gradient steps are not truncated away, one 64-bit product per
+ * sample) and every update is O(1).
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_DriftTracker.h"
+
+#define STHS34PF80_DRIFT_Q 8              ///< Fractional bits of the state
+#define STHS34PF80_DRIFT_AMB_CLAMP 2048   ///< Largest ambient deviation used
+#define STHS34PF80_DRIFT_K_Q 16           ///< Fractional bits of the coupling
+#define STHS34PF80_DRIFT_K_MAX (8L << 16) ///< Coupling limit (8 LSB/LSB)
+#define STHS34PF80_DRIFT_LMS_SHIFT 6      ///< Coupling adaptation step 2^-6
+#define STHS34PF80_DRIFT_LMS_EPS 64       ///< Regularizes small deviations
+#define STHS34PF80_DRIFT_NOISE_SHIFT 4    ///< Noise average step 2^-4
+#define STHS34PF80_DRIFT_PRESENT_SHIFT 4  ///< Extra slowdown while present
+
+/*!
+ * @brief Instantiates a tracker with defaults suited to 1 Hz data
+ */
+Adafruit_STHS34PF80_DriftTracker::Adafruit_STHS34PF80_DriftTracker()
+    : _gate(100),
+      _recovery(32),
+      _warmup(64),
+      _noise_ref(0),
+      _slow_shift(10),
+      _fast_shift(3) {
+  reset();
+}
+
+/*!
+ * @brief Set the learning rates of the baseline and the ambient average as
+ * power-of-two shifts
+ * @param slow_shift Normal rate 2^-slow_shift per sample (default 10)
+ * @param fast_shift Rate after an ambient shock (default 3)
+ */
+void Adafruit_STHS34PF80_DriftTracker::setTimeConstants(uint8_t slow_shift,
+                                                        uint8_t fast_shift) {
+  _slow_shift = slow_shift;
+  _fast_shift = fast_shift;
+}
+
+/*!
+ * @brief Set the residual below which the scene is considered empty
+ * @param gate Quiet gate in TOBJ_COMP LSB (default 100)
+ */
+void Adafruit_STHS34PF80_DriftTracker::setQuietGate(uint16_t gate) {
+  _gate = gate;
+}
+
+/*!
+ * @brief Set how long the fast learning rate is kept after a shock
+ * @param samples Recovery length in samples (default 32)
+ */
+void Adafruit_STHS34PF80_DriftTracker::setRecoverySamples(uint16_t samples) {
+  _recovery = samples;
+}
+
+/*!
+ * @brief Set how many samples it takes to reach full confidence
+ * @param samples Warm-up length in samples (default 64)
+ */
+void Adafruit_STHS34PF80_DriftTracker::setWarmupSamples(uint16_t samples) {
+  _warmup = samples;
+}
+
+/*!
+ * @brief Set the quiet residual noise expected from the configured
+ * averaging; confidence drops when the measured noise exceeds it
+ * @param noise Expected mean absolute residual in LSB, 0 to disable
+ */
+void Adafruit_STHS34PF80_DriftTracker::setNoiseReference(uint16_t noise) {
+  _noise_ref = noise;
+}
+
+/*!
+ * @brief Forget the baseline, the coupling and the noise estimate
+ */
+void Adafruit_STHS34PF80_DriftTracker::reset() {
+  _base = 0;
+  _amb = 0;
+  _amb_var = 0;
+  _k = 0;
+  _noise = 0;
+  _corrected = 0;
+  _count = 0;
+  _since_shock = 0xFFFF;
+}
+
+/*!
+ * @brief Feed one sample, O(1)
+ * @param ambient Raw ambient temperature (0.01 degC/LSB)
+ * @param obj_comp Raw compensated object temperature
+ * @param temp_shock True if the ambient shock flag is set
+ * @return The drift-corrected object signal
+ */
+int16_t Adafruit_STHS34PF80_DriftTracker::update(int16_t ambient,
+                                                 int16_t obj_comp,
+                                                 bool temp_shock) {
+  int32_t obj_q = (int32_t)obj_comp << STHS34PF80_DRIFT_Q;
+  int32_t amb_q = (int32_t)ambient << STHS34PF80_DRIFT_Q;
+
+  if (_count == 0) {
+    _base = obj_q;
+    _amb = amb_q;
+    _count = 1;
+    _corrected = 0;
+    return _corrected;
+  }
+
+  if (temp_shock) {
+    _since_shock = 0;
+  }
+  bool recovering = _since_shock < _recovery;
+
+  int32_t d_amb = (amb_q - _amb) >> STHS34PF80_DRIFT_Q;
+  if (d_amb > STHS34PF80_DRIFT_AMB_CLAMP) {
+    d_amb = STHS34PF80_DRIFT_AMB_CLAMP;
+  } else if (d_amb < -STHS34PF80_DRIFT_AMB_CLAMP) {
+    d_amb = -STHS34PF80_DRIFT_AMB_CLAMP;
+  }
+
+  // Q8 residual after removing the baseline and the ambient coupling
+  int32_t resid =
+      obj_q - _base -
+      ((_k * d_amb) >> (STHS34PF80_DRIFT_K_Q - STHS34PF80_DRIFT_Q));
+  int32_t abs_resid = resid < 0 ? -resid : resid;
+  bool quiet = abs_resid <= ((int32_t)_gate << STHS34PF80_DRIFT_Q);
+
+  uint8_t shift = recovering ? _fast_shift : _slow_shift;
+  if (!quiet && !recovering) {
+    shift += STHS34PF80_DRIFT_PRESENT_SHIFT;
+  }
+  _base += (obj_q - _base) >> shift;
+  _amb += (amb_q - _amb) >> shift;
+  _amb_var += (d_amb * d_amb - _amb_var) >> _slow_shift;
+
+  if (quiet && !recovering) {
+    // Normalized LMS: k += mu * e * x / (x^2 + E[x^2] + eps)
+    int64_t step = (((int64_t)resid << (STHS34PF80_DRIFT_K_Q -
+                                        STHS34PF80_DRIFT_Q)) *
+                    d_amb) /
+                   (d_amb * d_amb + _amb_var + STHS34PF80_DRIFT_LMS_EPS);
+    _k += (int32_t)(step >> STHS34PF80_DRIFT_LMS_SHIFT);
+    if (_k > STHS34PF80_DRIFT_K_MAX) {
+      _k = STHS34PF80_DRIFT_K_MAX;
+    } else if (_k < -STHS34PF80_DRIFT_K_MAX) {
+      _k = -STHS34PF80_DRIFT_K_MAX;
+    }
+    _noise += (abs_resid - _noise) >> STHS34PF80_DRIFT_NOISE_SHIFT;
+  }
+
+  if (_count < 0xFFFF) {
+    _count++;
+  }
+  if (_since_shock < 0xFFFF) {
+    _since_shock++;
+  }
+
+  resid >>= STHS34PF80_DRIFT_Q;
+  if (resid > 32767) {
+    resid = 32767;
+  } else if (resid < -32768) {
+    resid = -32768;
+  }
+  _corrected = (int16_t)resid;
+  return _corrected;
+}
+
+/*!
+ * @brief Feed one sample read with Adafruit_STHS34PF80::readSample()
+ * @param sample The sample
+ * @return The drift-corrected object signal
+ */
+int16_t Adafruit_STHS34PF80_DriftTracker::update(
+    const sths34pf80_sample_t& sample) {
+  return update(sample.ambient, sample.obj_comp,
+                sample.flags & STHS34PF80_TAMB_SHOCK_FLAG);
+}
+
+/*!
+ * @brief Get the last drift-corrected object signal
+ * @return TOBJ_COMP minus baseline and ambient coupling, in LSB
+ */
+int16_t Adafruit_STHS34PF80_DriftTracker::corrected() {
+  return _corrected;
+}
+
+/*!
+ * @brief Get the tracked object baseline
+ * @return Baseline in TOBJ_COMP LSB
+ */
+int16_t Adafruit_STHS34PF80_DriftTracker::baseline() {
+  return (int16_t)(_base >> STHS34PF80_DRIFT_Q);
+}
+
+/*!
+ * @brief Get the learned ambient coupling
+ * @return TOBJ_COMP LSB per ambient LSB, Q8 fixed point
+ */
+int16_t Adafruit_STHS34PF80_DriftTracker::coupling() {
+  return (int16_t)(_k >> (STHS34PF80_DRIFT_K_Q - STHS34PF80_DRIFT_Q));
+}
+
+/*!
+ * @brief Get the mean absolute residual while the scene is quiet
+ * @return Noise in TOBJ_COMP LSB
+ */
+uint16_t Adafruit_STHS34PF80_DriftTracker::noise() {
+  return (uint16_t)(_noise >> STHS34PF80_DRIFT_Q);
+}
+
+/*!
+ * @brief Get how far the corrected signal can be trusted
+ *
+ * Limited by warm-up, by the time since the last ambient shock and, if a
+ * noise reference is set, by excess residual noise.
+ * @return Confidence from 0 (none) to 255 (full)
+ */
+uint8_t Adafruit_STHS34PF80_DriftTracker::confidence() {
+  uint32_t conf = 255;
+
+  if (_count < _warmup) {
+    conf = (uint32_t)_count * 255 / _warmup;
+  }
+  if (_since_shock < _recovery) {
+    uint32_t rec = (uint32_t)_since_shock * 255 / _recovery;
+    if (rec < conf) {
+      conf = rec;
+    }
+  }
+
+  uint16_t measured = noise();
+  if (_noise_ref && measured > _noise_ref) {
+    conf = conf * _noise_ref / measured;
+  }
+
+  return (uint8_t)conf;
+}
@@ -0,0 +1,60 @@
+/*!
+ * @file Adafruit_STHS34PF80_DriftTracker.h
+ *
+ * Host-side ambient drift tracking and baseline compensation for the
+ * STHS34PF80 compensated object temperature.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_DRIFTTRACKER_H__
+#define __ADAFRUIT_STHS34PF80_DRIFTTRACKER_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+/*!
+ * @brief Class that removes slow ambient drift from TOBJ_COMP
+ */
+class Adafruit_STHS34PF80_DriftTracker {
+ public:
+  Adafruit_STHS34PF80_DriftTracker();
+
+  void setTimeConstants(uint8_t slow_shift, uint8_t fast_shift);
+  void setQuietGate(uint16_t gate);
+  void setRecoverySamples(uint16_t samples);
+  void setWarmupSamples(uint16_t samples);
+  void setNoiseReference(uint16_t noise);
+
+  void reset();
+  int16_t update(int16_t ambient, int16_t obj_comp, bool temp_shock);
+  int16_t update(const sths34pf80_sample_t& sample);
+
+  int16_t corrected();
+  int16_t baseline();
+  int16_t coupling();
+  uint16_t noise();
+  uint8_t confidence();
+
+ private:
+  int32_t _base;
+  int32_t _amb;
+  int32_t _amb_var;
+  int32_t _k;
+  int32_t _noise;
+  int16_t _corrected;
+  uint16_t _count;
+  uint16_t _since_shock;
+  uint16_t _gate;
+  uint16_t _recovery;
+  uint16_t _warmup;
+  uint16_t _noise_ref;
+  uint8_t _slow_shift;
+  uint8_t _fast_shift;
+};
+
+#endif
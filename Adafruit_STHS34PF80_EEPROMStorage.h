@@ -0,0 +1,174 @@
+/*!
+ * @file Adafruit_STHS34PF80_EEPROMStorage.h
+ *
+ * Event log storage in the MCU's EEPROM (or the core's EEPROM emulation),
+ * through the Arduino EEPROM library.
+ *
+ * Header only, so the EEPROM library is pulled in just by the sketches that
+ * include this file, and only on cores known to ship one; elsewhere (e.g.
+ * SAMD) STHS34PF80_HAS_EEPROM stays undefined and the class is left out:
+ *
+ *   #include "Adafruit_STHS34PF80_EEPROMStorage.h"
+ *
+ *   Adafruit_STHS34PF80_EEPROMStorage storage(0, 4, 256); // 1 KB at 0
+ *   Adafruit_STHS34PF80_EventLog events;
+ *   storage.begin();
+ *   events.begin(&storage);
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_EEPROMSTORAGE_H__
+#define __ADAFRUIT_STHS34PF80_EEPROMSTORAGE_H__
+
+#include "Adafruit_STHS34PF80_EventLog.h"
+
+#if defined(ARDUINO_ARCH_AVR) || defined(ARDUINO_ARCH_MEGAAVR) ||   \
+    defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32) || \
+    defined(ARDUINO_ARCH_RP2040) || defined(ARDUINO_ARCH_STM32) ||  \
+    defined(ARDUINO_ARCH_RENESAS)
+#define STHS34PF80_HAS_EEPROM ///< The core has an EEPROM library
+#endif
+
+#if defined(STHS34PF80_HAS_EEPROM)
+
+#include <EEPROM.h>
+
+#if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32) || \
+    defined(ARDUINO_ARCH_RP2040)
+#define STHS34PF80_EEPROM_COMMIT ///< EEPROM is a RAM copy until commit()
+#endif
+
+/*!
+ * @brief Log storage in a range of EEPROM
+ *
+ * EEPROM is byte-erasable, so the pages are only a unit for the log's ring;
+ * bytes that already hold the value being written, including the 0xFF of
+ * an erase, are not rewritten and cost no write cycle. On cores that
+ * emulate EEPROM in flash (ESP8266, ESP32, RP2040) writes stay in RAM until
+ * sync(), so call the log's sync() as often as losing events allows.
+ */
+class Adafruit_STHS34PF80_EEPROMStorage
+    : public Adafruit_STHS34PF80_LogStorage {
+ public:
+  /*!
+   * @brief Instantiates an EEPROM storage backend
+   * @param offset First EEPROM byte the log may use
+   * @param pages Number of pages
+   * @param page_size Page size in bytes
+   */
+  Adafruit_STHS34PF80_EEPROMStorage(uint16_t offset, uint16_t pages,
+                                    uint16_t page_size)
+      : _offset(offset), _pages(pages), _page_size(page_size) {}
+
+  /*!
+   * @brief Start the EEPROM library and check the range fits
+   * @return False if the pages run past the end of the EEPROM
+   */
+  bool begin() {
+    uint32_t end = _offset + (uint32_t)_pages * _page_size;
+#if defined(STHS34PF80_EEPROM_COMMIT)
+    EEPROM.begin(end);
+#endif
+    return _pages && _page_size && end <= EEPROM.length();
+  }
+
+  /*!
+   * @brief Get the number of pages
+   * @return Page count
+   */
+  uint16_t pageCount() { return _pages; }
+
+  /*!
+   * @brief Get the page size
+   * @return Bytes per page
+   */
+  uint16_t pageSize() { return _page_size; }
+
+  /*!
+   * @brief Read bytes
+   * @param addr Byte address within the log
+   * @param data Destination
+   * @param len Number of bytes
+   * @return False if the range is out of bounds
+   */
+  bool read(uint32_t addr, uint8_t* data, uint16_t len) {
+    if (!inRange(addr, len)) {
+      return false;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+      data[i] = EEPROM.read(_offset + addr + i);
+    }
+    return true;
+  }
+
+  /*!
+   * @brief Write bytes, skipping those that already hold the value
+   * @param addr Byte address within the log
+   * @param data Bytes to write
+   * @param len Number of bytes
+   * @return False if the range is out of bounds
+   */
+  bool write(uint32_t addr, const uint8_t* data, uint16_t len) {
+    if (!inRange(addr, len)) {
+      return false;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+      update(_offset + addr + i, data[i]);
+    }
+    return true;
+  }
+
+  /*!
+   * @brief Erase one page to 0xFF
+   * @param page Page index
+   * @return False on a bad page index
+   */
+  bool erase(uint16_t page) {
+    if (page >= _pages) {
+      return false;
+    }
+    uint32_t start = _offset + (uint32_t)page * _page_size;
+    for (uint16_t i = 0; i < _page_size; i++) {
+      update(start + i, 0xFF);
+    }
+    return true;
+  }
+
+  /*!
+   * @brief Commit the RAM copy to flash on cores that emulate EEPROM
+   * @return True if successful, false otherwise
+   */
+  bool sync() {
+#if defined(STHS34PF80_EEPROM_COMMIT)
+    return EEPROM.commit();
+#else
+    return true;
+#endif
+  }
+
+ private:
+  bool inRange(uint32_t addr, uint16_t len) {
+    uint32_t size = (uint32_t)_pages * _page_size;
+    return addr <= size && len <= size - addr;
+  }
+
+  static void update(uint32_t addr, uint8_t value) {
+    if (EEPROM.read(addr) != value) {
+      EEPROM.write(addr, value);
+    }
+  }
+
+  uint16_t _offset;
+  uint16_t _pages;
+  uint16_t _page_size;
+};
+
+#endif // STHS34PF80_HAS_EEPROM
+
+#endif
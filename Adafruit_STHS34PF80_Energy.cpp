@@ -0,0 +1,275 @@
+/*!
+ * @file Adafruit_STHS34PF80_Energy.cpp
+ *
+ * Energy and bus-cost accounting for STHS34PF80 configurations and
+ * acquisition strategies.
+ *
+ * Per hour, with r samples per second:
+ *
+ *   polling:  3600000 / poll_ms wake-ups with isDataReady(), and 3600 r
+ *             readSample()
+ *   DRDY int: 3600 r wake-ups with readSample(), which also clears the INT
+ *   one-shot: 7200 r wake-ups (trigger, then read after the conversion)
+ *             with triggerOneshot(), isDataReady() and readSample()
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_Energy.h"
+
+#include "Adafruit_STHS34PF80_Model.h"
+
+#define STHS34PF80_ENERGY_DEFAULT_AVG_T 8 ///< Ambient samples in the fit
+
+/*!
+ * @brief Bus cost of a register transaction
+ * @param transactions Transactions
+ * @param bytes Data bytes
+ * @param reads Register reads among the transactions
+ * @return The cost, with the same bit count as the driver's counters
+ */
+static sths34pf80_bus_stats_t busCost(uint32_t transactions, uint32_t bytes,
+                                      uint32_t reads) {
+  sths34pf80_bus_stats_t cost;
+  cost.transactions = transactions;
+  cost.bytes = bytes;
+  // Address and register byte per transaction, second address byte and
+  // repeated start per read, 9 bits per byte, start and stop
+  cost.bits = (2 * transactions + reads + bytes) * 9 + 2 * transactions + reads;
+  return cost;
+}
+
+/*!
+ * @brief Instantiates an accountant for the power-on configuration with
+ * typical system figures: 3.3 V, a 3 mA / 5 uA MCU, 100 kHz with 4.7k
+ * pull-ups, 100 us per wake-up, 20 us per transaction and 10 ms polling
+ */
+Adafruit_STHS34PF80_Energy::Adafruit_STHS34PF80_Energy()
+    : _odr(STHS34PF80_ODR_1_HZ),
+      _avg_tmos(STHS34PF80_AVG_TMOS_32),
+      _avg_t(STHS34PF80_AVG_T_8) {
+  _params.supply_v = 3.3f;
+  _params.mcu_active_ua = 3000;
+  _params.mcu_sleep_ua = 5;
+  _params.bus_hz = 100000;
+  _params.pullup_ohms = 4700;
+  _params.wake_us = 100;
+  _params.transaction_us = 20;
+  _params.poll_ms = 10;
+
+  // The driver's sequences: STATUS bit read, two output bursts, one
+  // FUNC_STATUS read, CTRL2 read-modify-write
+  _costs[STHS34PF80_API_IS_DATA_READY] = busCost(1, 1, 1);
+  _costs[STHS34PF80_API_READ_SAMPLE] = busCost(2, 13, 2);
+  _costs[STHS34PF80_API_READ_FUNC_STATUS] = busCost(1, 1, 1);
+  _costs[STHS34PF80_API_TRIGGER_ONESHOT] = busCost(2, 2, 1);
+}
+
+/*!
+ * @brief Set the system figures
+ * @param params The figures
+ */
+void Adafruit_STHS34PF80_Energy::setParams(
+    const sths34pf80_energy_params_t& params) {
+  _params = params;
+}
+
+/*!
+ * @brief Get the system figures, e.g. to change a few of them
+ * @param params Set to the figures
+ */
+void Adafruit_STHS34PF80_Energy::getParams(
+    sths34pf80_energy_params_t* params) {
+  if (params) {
+    *params = _params;
+  }
+}
+
+/*!
+ * @brief Read the sensor configuration and measure the bus cost of each
+ * accounted call with the driver's bus counters
+ *
+ * Leaves bus accounting enabled. readFuncStatus() clears the flags and a
+ * latched INT, and triggerOneshot() is only measured while powered down.
+ * A powered-down sensor keeps the rate set before, as the one-shot rate.
+ * @param sensor The sensor, already started with begin()
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_Energy::measure(Adafruit_STHS34PF80* sensor) {
+  if (!sensor || !sensor->enableBusAccounting(true)) {
+    return false;
+  }
+
+  sths34pf80_odr_t odr = sensor->getOutputDataRate();
+  if (odr != STHS34PF80_ODR_POWER_DOWN) {
+    _odr = odr;
+  }
+  _avg_tmos = sensor->getObjAveraging();
+  _avg_t = sensor->getAmbTempAveraging();
+
+  sths34pf80_sample_t sample;
+  for (uint8_t api = 0; api < STHS34PF80_API_COUNT; api++) {
+    if (api == STHS34PF80_API_TRIGGER_ONESHOT &&
+        odr != STHS34PF80_ODR_POWER_DOWN) {
+      continue;
+    }
+
+    sths34pf80_bus_stats_t before, after;
+    sensor->getBusStats(&before);
+    bool ok = true;
+    switch (api) {
+      case STHS34PF80_API_IS_DATA_READY:
+        sensor->isDataReady();
+        break;
+      case STHS34PF80_API_READ_SAMPLE:
+        ok = sensor->readSample(&sample);
+        break;
+      case STHS34PF80_API_READ_FUNC_STATUS:
+        sensor->readFuncStatus();
+        break;
+      default:
+        ok = sensor->triggerOneshot();
+        break;
+    }
+    if (!ok) {
+      return false;
+    }
+    sensor->getBusStats(&after);
+
+    _costs[api].transactions = after.transactions - before.transactions;
+    _costs[api].bytes = after.bytes - before.bytes;
+    _costs[api].bits = after.bits - before.bits;
+  }
+  return true;
+}
+
+/*!
+ * @brief Set the configuration to account for, e.g. to compare settings
+ * after measure()
+ * @param odr Output data rate, or the one-shot rate
+ * @param avg_tmos Object temperature averaging
+ * @param avg_t Ambient temperature averaging
+ */
+void Adafruit_STHS34PF80_Energy::setConfig(sths34pf80_odr_t odr,
+                                           sths34pf80_avg_tmos_t avg_tmos,
+                                           sths34pf80_avg_t_t avg_t) {
+  _odr = odr;
+  _avg_tmos = avg_tmos;
+  _avg_t = avg_t;
+}
+
+/*!
+ * @brief Set the bus cost of one call, e.g. for a custom read path
+ * @param api The call
+ * @param cost Its cost
+ */
+void Adafruit_STHS34PF80_Energy::setApiCost(
+    sths34pf80_api_t api, const sths34pf80_bus_stats_t& cost) {
+  if (api < STHS34PF80_API_COUNT) {
+    _costs[api] = cost;
+  }
+}
+
+/*!
+ * @brief Get the bus cost of one call
+ * @param api The call
+ * @param cost Set to its cost
+ */
+void Adafruit_STHS34PF80_Energy::getApiCost(sths34pf80_api_t api,
+                                            sths34pf80_bus_stats_t* cost) {
+  if (cost && api < STHS34PF80_API_COUNT) {
+    *cost = _costs[api];
+  }
+}
+
+/*!
+ * @brief Estimate one hour of operation
+ * @param strategy How samples are acquired
+ * @param report Set to the estimate
+ * @return False for a power-down rate or an invalid configuration
+ */
+bool Adafruit_STHS34PF80_Energy::estimate(sths34pf80_acq_strategy_t strategy,
+                                          sths34pf80_energy_report_t* report) {
+  float rate = Adafruit_STHS34PF80_Model::odrHz(_odr);
+  if (!report || rate <= 0 ||
+      _odr > Adafruit_STHS34PF80_Model::maxOdr(_avg_tmos) ||
+      (strategy == STHS34PF80_ACQ_POLLING && !_params.poll_ms)) {
+    return false;
+  }
+  memset(report, 0, sizeof(*report));
+
+  report->samples = rate * 3600;
+  switch (strategy) {
+    case STHS34PF80_ACQ_POLLING:
+      report->wakeups = 3600000.0f / _params.poll_ms;
+      // A poll reads at most one sample, the rest are overwritten
+      if (report->wakeups < report->samples) {
+        report->samples = report->wakeups;
+      }
+      addCost(STHS34PF80_API_IS_DATA_READY, report->wakeups, report);
+      addCost(STHS34PF80_API_READ_SAMPLE, report->samples, report);
+      break;
+    case STHS34PF80_ACQ_DRDY_INT:
+      report->wakeups = report->samples;
+      addCost(STHS34PF80_API_READ_SAMPLE, report->samples, report);
+      break;
+    default:
+      report->wakeups = 2 * report->samples;
+      addCost(STHS34PF80_API_TRIGGER_ONESHOT, report->samples, report);
+      addCost(STHS34PF80_API_IS_DATA_READY, report->samples, report);
+      addCost(STHS34PF80_API_READ_SAMPLE, report->samples, report);
+      break;
+  }
+
+  // Fit current, plus or minus the ambient samples against the fit's 8
+  float amb_delta = Adafruit_STHS34PF80_Model::ambSamples(_avg_t) -
+                    (float)STHS34PF80_ENERGY_DEFAULT_AVG_T;
+  report->sensor_uah =
+      Adafruit_STHS34PF80_Model::supplyUA(_odr, _avg_tmos) +
+      STHS34PF80_MODEL_ACTIVE_UA * STHS34PF80_MODEL_TMOS_SAMPLE_S * amb_delta *
+          rate;
+
+  float awake_s = report->wakeups * _params.wake_us * 1e-6f +
+                  report->transactions * _params.transaction_us * 1e-6f +
+                  report->bus_bits / _params.bus_hz;
+  if (awake_s > 3600) {
+    awake_s = 3600;
+  }
+  report->mcu_awake_ms = awake_s * 1000;
+  report->mcu_uah = (_params.mcu_active_ua * awake_s +
+                     _params.mcu_sleep_ua * (3600 - awake_s)) /
+                    3600;
+
+  // Each line sinks V/R through its pull-up for about half of every bit
+  float bit_uj = _params.supply_v * _params.supply_v / _params.pullup_ohms /
+                 _params.bus_hz * 1e6f;
+  report->bus_uj = report->bus_bits * bit_uj;
+
+  report->total_uah = report->sensor_uah + report->mcu_uah +
+                      report->bus_uj / _params.supply_v / 3600;
+  return true;
+}
+
+/*!
+ * @brief Battery life at the estimated drain
+ * @param report An estimate
+ * @param capacity_mah Usable battery capacity, mAh
+ * @return Hours
+ */
+float Adafruit_STHS34PF80_Energy::batteryHours(
+    const sths34pf80_energy_report_t& report, float capacity_mah) {
+  return report.total_uah > 0 ? capacity_mah * 1000 / report.total_uah : 0;
+}
+
+/*!
+ * @brief Add the bus cost of repeated calls to a report
+ * @param api The call
+ * @param calls Calls per hour
+ * @param report The report
+ */
+void Adafruit_STHS34PF80_Energy::addCost(sths34pf80_api_t api, float calls,
+                                         sths34pf80_energy_report_t* report) {
+  report->transactions += calls * _costs[api].transactions;
+  report->bus_bits += calls * _costs[api].bits;
+}
@@ -0,0 +1,109 @@
+/*!
+ * @file Adafruit_STHS34PF80_Energy.h
+ *
+ * Energy and bus-cost accounting for STHS34PF80 configurations and
+ * acquisition strategies (polling, DRDY interrupt, one-shot).
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_ENERGY_H__
+#define __ADAFRUIT_STHS34PF80_ENERGY_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+/*!
+ * @brief How the MCU learns about new samples
+ */
+typedef enum {
+  STHS34PF80_ACQ_POLLING = 0x00,  ///< Wake at a fixed interval, poll DRDY
+  STHS34PF80_ACQ_DRDY_INT = 0x01, ///< Sleep until the DRDY interrupt
+  STHS34PF80_ACQ_ONESHOT = 0x02,  ///< Powered down, one-shot per sample
+} sths34pf80_acq_strategy_t;
+
+/*!
+ * @brief Driver calls whose bus cost is accounted
+ */
+typedef enum {
+  STHS34PF80_API_IS_DATA_READY = 0x00,    ///< isDataReady()
+  STHS34PF80_API_READ_SAMPLE = 0x01,      ///< readSample()
+  STHS34PF80_API_READ_FUNC_STATUS = 0x02, ///< readFuncStatus()
+  STHS34PF80_API_TRIGGER_ONESHOT = 0x03,  ///< triggerOneshot()
+  STHS34PF80_API_COUNT = 0x04,            ///< Number of accounted calls
+} sths34pf80_api_t;
+
+/*!
+ * @brief System figures the estimate depends on
+ */
+typedef struct {
+  float supply_v;          ///< Supply voltage
+  float mcu_active_ua;     ///< MCU current while awake, uA
+  float mcu_sleep_ua;      ///< MCU current while asleep, uA
+  uint32_t bus_hz;         ///< I2C clock, Hz
+  float pullup_ohms;       ///< I2C pull-up resistance, ohms
+  uint16_t wake_us;        ///< MCU wake-up plus back-to-sleep time
+  uint16_t transaction_us; ///< Software overhead per bus transaction
+  uint16_t poll_ms;        ///< Polling interval of STHS34PF80_ACQ_POLLING
+} sths34pf80_energy_params_t;
+
+/*!
+ * @brief Estimated cost of one hour of operation
+ */
+typedef struct {
+  float samples;      ///< Samples read
+  float wakeups;      ///< MCU wake-ups
+  float transactions; ///< Bus transactions
+  float bus_bits;     ///< Bits on the wire
+  float mcu_awake_ms; ///< MCU awake time, ms
+  float sensor_uah;   ///< Sensor charge, uAh (the average sensor uA)
+  float mcu_uah;      ///< MCU charge, uAh
+  float bus_uj;       ///< Energy dissipated in the pull-ups, uJ
+  float total_uah;    ///< Sensor, MCU and pull-up charge, uAh
+} sths34pf80_energy_report_t;
+
+/*!
+ * @brief Class that estimates the charge and bus traffic of an acquisition
+ * setup from the sensor configuration and the measured bus cost of each
+ * driver call
+ *
+ * Sensor current comes from Adafruit_STHS34PF80_Model::supplyUA(), adjusted
+ * for ambient averaging; MCU time is the wake-ups, the per-transaction
+ * overhead and the bits on the wire at the bus clock; pull-up energy
+ * assumes SDA and SCL each low for half of every bit. Without measure(),
+ * the bus costs are those of the driver's register sequences.
+ */
+class Adafruit_STHS34PF80_Energy {
+ public:
+  Adafruit_STHS34PF80_Energy();
+
+  void setParams(const sths34pf80_energy_params_t& params);
+  void getParams(sths34pf80_energy_params_t* params);
+
+  bool measure(Adafruit_STHS34PF80* sensor);
+  void setConfig(sths34pf80_odr_t odr, sths34pf80_avg_tmos_t avg_tmos,
+                 sths34pf80_avg_t_t avg_t);
+  void setApiCost(sths34pf80_api_t api, const sths34pf80_bus_stats_t& cost);
+  void getApiCost(sths34pf80_api_t api, sths34pf80_bus_stats_t* cost);
+
+  bool estimate(sths34pf80_acq_strategy_t strategy,
+                sths34pf80_energy_report_t* report);
+  static float batteryHours(const sths34pf80_energy_report_t& report,
+                            float capacity_mah);
+
+ private:
+  void addCost(sths34pf80_api_t api, float calls,
+               sths34pf80_energy_report_t* report);
+
+  sths34pf80_energy_params_t _params;
+  sths34pf80_odr_t _odr;
+  sths34pf80_avg_tmos_t _avg_tmos;
+  sths34pf80_avg_t_t _avg_t;
+  sths34pf80_bus_stats_t _costs[STHS34PF80_API_COUNT];
+};
+
+#endif
@@ -0,0 +1,804 @@
+/*!
+ * @file Adafruit_STHS34PF80_EventLog.cpp
+ *
+ * Append-only, wear-levelled log of STHS34PF80 events.
+ *
+ * Records are written as soon as they are appended, so nothing but the
+ * record in flight is lost on power failure; the only bytes written besides
+ * the records are the page headers. See the event log benchmark example for
+ * write amplification and append throughput on each backend.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_EventLog.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*!
+ * @brief Instantiates a RAM storage backend
+ * @param buffer Storage bytes, size long
+ * @param size Buffer size; a partial last page is not used
+ * @param page_size Erase page size
+ */
+Adafruit_STHS34PF80_MemoryStorage::Adafruit_STHS34PF80_MemoryStorage(
+    uint8_t* buffer, uint32_t size, uint16_t page_size)
+    : _buffer(buffer), _size(size), _page_size(page_size) {}
+
+/*!
+ * @brief Get the number of erase pages
+ * @return Page count
+ */
+uint16_t Adafruit_STHS34PF80_MemoryStorage::pageCount() {
+  if (!_page_size) {
+    return 0;
+  }
+  uint32_t pages = _size / _page_size;
+  return pages > 0xFFFF ? 0xFFFF : (uint16_t)pages;
+}
+
+/*!
+ * @brief Get the erase page size
+ * @return Bytes per page
+ */
+uint16_t Adafruit_STHS34PF80_MemoryStorage::pageSize() { return _page_size; }
+
+/*!
+ * @brief Read bytes
+ * @param addr Byte address
+ * @param data Destination
+ * @param len Number of bytes
+ * @return False if the range is out of bounds
+ */
+bool Adafruit_STHS34PF80_MemoryStorage::read(uint32_t addr, uint8_t* data,
+                                             uint16_t len) {
+  if (!_buffer || addr > _size || len > _size - addr) {
+    return false;
+  }
+  memcpy(data, _buffer + addr, len);
+  return true;
+}
+
+/*!
+ * @brief Program bytes; like flash, bits can only go from 1 to 0
+ * @param addr Byte address
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return False if the range is out of bounds
+ */
+bool Adafruit_STHS34PF80_MemoryStorage::write(uint32_t addr,
+                                              const uint8_t* data,
+                                              uint16_t len) {
+  if (!_buffer || addr > _size || len > _size - addr) {
+    return false;
+  }
+  for (uint16_t i = 0; i < len; i++) {
+    _buffer[addr + i] &= data[i];
+  }
+  return true;
+}
+
+/*!
+ * @brief Erase one page to 0xFF
+ * @param page Page index
+ * @return False on a bad page index
+ */
+bool Adafruit_STHS34PF80_MemoryStorage::erase(uint16_t page) {
+  if (!_buffer || page >= pageCount()) {
+    return false;
+  }
+  memset(_buffer + (uint32_t)page * _page_size, 0xFF, _page_size);
+  return true;
+}
+
+#if defined(__linux__)
+/*!
+ * @brief Instantiates a file storage backend, closed until begin()
+ */
+Adafruit_STHS34PF80_FileStorage::Adafruit_STHS34PF80_FileStorage()
+    : _fd(-1), _map(NULL), _pages(0), _page_size(0), _written(0) {}
+
+/*!
+ * @brief Closes the file
+ */
+Adafruit_STHS34PF80_FileStorage::~Adafruit_STHS34PF80_FileStorage() { end(); }
+
+/*!
+ * @brief Open (creating or growing as needed) the backing file
+ * @param path File path
+ * @param pages Number of pages
+ * @param page_size Page size in bytes
+ * @param mapped True to access the file through mmap() instead of
+ * pread()/pwrite()
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_FileStorage::begin(const char* path, uint16_t pages,
+                                            uint16_t page_size, bool mapped) {
+  end();
+  if (!path || !pages || !page_size) {
+    return false;
+  }
+
+  _fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (_fd < 0) {
+    return false;
+  }
+  _pages = pages;
+  _page_size = page_size;
+
+  // New space must read as erased, so grow the file with 0xFF pages
+  struct stat st;
+  if (fstat(_fd, &st) != 0) {
+    end();
+    return false;
+  }
+  uint32_t have = st.st_size / page_size;
+  for (uint32_t page = have; page < pages; page++) {
+    if (!erase(page)) {
+      end();
+      return false;
+    }
+  }
+  _written = 0;
+
+  if (mapped) {
+    void* map = mmap(NULL, (size_t)pages * page_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED) {
+      end();
+      return false;
+    }
+    _map = (uint8_t*)map;
+  }
+  return true;
+}
+
+/*!
+ * @brief Unmap and close the file
+ */
+void Adafruit_STHS34PF80_FileStorage::end() {
+  if (_map) {
+    munmap(_map, (size_t)_pages * _page_size);
+    _map = NULL;
+  }
+  if (_fd >= 0) {
+    close(_fd);
+    _fd = -1;
+  }
+  _pages = 0;
+}
+
+/*!
+ * @brief Get the number of erase pages
+ * @return Page count
+ */
+uint16_t Adafruit_STHS34PF80_FileStorage::pageCount() { return _pages; }
+
+/*!
+ * @brief Get the erase page size
+ * @return Bytes per page
+ */
+uint16_t Adafruit_STHS34PF80_FileStorage::pageSize() { return _page_size; }
+
+/*!
+ * @brief Read bytes
+ * @param addr Byte address
+ * @param data Destination
+ * @param len Number of bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_FileStorage::read(uint32_t addr, uint8_t* data,
+                                           uint16_t len) {
+  uint32_t size = (uint32_t)_pages * _page_size;
+  if (_fd < 0 || addr > size || len > size - addr) {
+    return false;
+  }
+  if (_map) {
+    memcpy(data, _map + addr, len);
+    return true;
+  }
+  return pread(_fd, data, len, addr) == len;
+}
+
+/*!
+ * @brief Write bytes
+ * @param addr Byte address
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_FileStorage::write(uint32_t addr, const uint8_t* data,
+                                            uint16_t len) {
+  uint32_t size = (uint32_t)_pages * _page_size;
+  if (_fd < 0 || addr > size || len > size - addr) {
+    return false;
+  }
+  _written += len;
+  if (_map) {
+    memcpy(_map + addr, data, len);
+    return true;
+  }
+  return pwrite(_fd, data, len, addr) == len;
+}
+
+/*!
+ * @brief Erase one page by filling it with 0xFF
+ * @param page Page index
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_FileStorage::erase(uint16_t page) {
+  if (_fd < 0 || page >= _pages) {
+    return false;
+  }
+
+  uint8_t blank[256];
+  memset(blank, 0xFF, sizeof(blank));
+  uint32_t addr = (uint32_t)page * _page_size;
+  for (uint16_t done = 0; done < _page_size;) {
+    uint16_t len = _page_size - done;
+    len = len > sizeof(blank) ? sizeof(blank) : len;
+    if (_map) {
+      memcpy(_map + addr + done, blank, len);
+    } else if (pwrite(_fd, blank, len, addr + done) != len) {
+      return false;
+    }
+    done += len;
+  }
+  _written += _page_size;
+  return true;
+}
+
+/*!
+ * @brief Flush written data to the disk
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_FileStorage::sync() {
+  if (_fd < 0) {
+    return false;
+  }
+  if (_map) {
+    return msync(_map, (size_t)_pages * _page_size, MS_SYNC) == 0;
+  }
+  return fdatasync(_fd) == 0;
+}
+
+/*!
+ * @brief Get the bytes written to the file, including erases
+ * @return Bytes written since begin()
+ */
+uint64_t Adafruit_STHS34PF80_FileStorage::bytesWritten() { return _written; }
+#endif
+
+/*!
+ * @brief Instantiates an event log, unusable until begin()
+ */
+Adafruit_STHS34PF80_EventLog::Adafruit_STHS34PF80_EventLog()
+    : _storage(NULL),
+      _seq(0),
+      _last_ms(0),
+      _page(0),
+      _offset(0),
+      _used(0),
+      _flags(0),
+      _above(0),
+      _primed(false) {
+  _thresholds[0] = 0;
+  _thresholds[1] = 0;
+  _thresholds[2] = 0;
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+/*!
+ * @brief Mount the log, recovering the write position from the storage
+ *
+ * Timestamps must not go backwards, also across restarts: log relative to
+ * lastTimestamp() (or a real-time clock) rather than to a fresh millis().
+ * @param storage The storage; needs at least two pages of 20+ bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_EventLog::begin(
+    Adafruit_STHS34PF80_LogStorage* storage) {
+  if (!storage || storage->pageCount() < 2 ||
+      storage->pageSize() <
+          STHS34PF80_LOG_HEADER_LEN + STHS34PF80_LOG_MAX_RECORD) {
+    return false;
+  }
+  _storage = storage;
+  _used = 0;
+  _seq = 0;
+  _last_ms = 0;
+  _primed = false;
+  memset(&_stats, 0, sizeof(_stats));
+
+  uint16_t pages = storage->pageCount();
+  for (uint16_t page = 0; page < pages; page++) {
+    uint32_t seq;
+    uint32_t base_ms;
+    if (!readHeader(page, &seq, &base_ms)) {
+      continue;
+    }
+    _used++;
+    if (_used == 1 || seq > _seq) {
+      _seq = seq;
+      _page = page;
+      _last_ms = base_ms;
+    }
+  }
+  if (!_used) {
+    return true;
+  }
+
+  // Find the end of the newest page
+  _offset = STHS34PF80_LOG_HEADER_LEN;
+  sths34pf80_log_event_t event;
+  int8_t len;
+  while ((len = readRecord(_page, _offset, &_last_ms, &event)) > 0) {
+    _offset += len;
+  }
+  if (len < 0) {
+    // A torn record cannot be written over, continue on a fresh page
+    _offset = storage->pageSize();
+  }
+  return true;
+}
+
+/*!
+ * @brief Erase the whole log
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_EventLog::format() {
+  if (!_storage) {
+    return false;
+  }
+  for (uint16_t page = 0; page < _storage->pageCount(); page++) {
+    if (!_storage->erase(page)) {
+      return false;
+    }
+    _stats.erases++;
+  }
+  _used = 0;
+  _seq = 0;
+  _last_ms = 0;
+  return true;
+}
+
+/*!
+ * @brief Append one event
+ * @param event The event; a timestamp older than the previous event is
+ * logged as the previous timestamp
+ * @return True if the event was written, false otherwise
+ */
+bool Adafruit_STHS34PF80_EventLog::append(const sths34pf80_log_event_t& event) {
+  if (!_storage || event.type < STHS34PF80_LOG_FLAGS ||
+      event.type > STHS34PF80_LOG_FAULT) {
+    return false;
+  }
+
+  uint32_t ts = event.timestamp_ms;
+  if (_used && (int32_t)(ts - _last_ms) < 0) {
+    ts = _last_ms;
+  }
+  uint16_t page_size = _storage->pageSize();
+  if (!_used || _offset + STHS34PF80_LOG_MAX_RECORD > page_size) {
+    uint16_t next = _used ? (_page + 1) % _storage->pageCount() : 0;
+    if (!openPage(next, ts)) {
+      return false;
+    }
+  }
+
+  uint8_t buf[STHS34PF80_LOG_MAX_RECORD];
+  uint8_t len = 0;
+  buf[len++] = (uint8_t)(event.type << 4) | (event.code & 0x0F);
+  uint32_t delta = ts - _last_ms;
+  while (delta >= 0x80) {
+    buf[len++] = (uint8_t)(delta | 0x80);
+    delta >>= 7;
+  }
+  buf[len++] = (uint8_t)delta;
+  if (event.type == STHS34PF80_LOG_CROSSING) {
+    buf[len++] = (uint8_t)event.value;
+    buf[len++] = (uint8_t)((uint16_t)event.value >> 8);
+  }
+  buf[len] = crc8(buf, len);
+  len++;
+
+  uint32_t addr = (uint32_t)_page * page_size + _offset;
+  if (!_storage->write(addr, buf, len)) {
+    // Whatever reached the storage is torn, skip the rest of the page
+    _offset = page_size;
+    return false;
+  }
+  _offset += len;
+  _last_ms = ts;
+  _stats.events++;
+  _stats.record_bytes += len;
+  return true;
+}
+
+/*!
+ * @brief Append a FUNC_STATUS flag change
+ * @param timestamp_ms Event time
+ * @param flags New flags (STHS34PF80_PRES_FLAG, _MOT_FLAG, _TAMB_SHOCK_FLAG)
+ * @return True if the event was written, false otherwise
+ */
+bool Adafruit_STHS34PF80_EventLog::logFlags(uint32_t timestamp_ms,
+                                            uint8_t flags) {
+  sths34pf80_log_event_t event = {timestamp_ms, STHS34PF80_LOG_FLAGS,
+                                  (uint8_t)(flags & 0x07), 0};
+  return append(event);
+}
+
+/*!
+ * @brief Append a threshold crossing
+ * @param timestamp_ms Event time
+ * @param signal sths34pf80_log_signal_t value, with STHS34PF80_LOG_RISING
+ * for an upward crossing
+ * @param value Signal value after the crossing
+ * @return True if the event was written, false otherwise
+ */
+bool Adafruit_STHS34PF80_EventLog::logCrossing(uint32_t timestamp_ms,
+                                               uint8_t signal, int16_t value) {
+  sths34pf80_log_event_t event = {timestamp_ms, STHS34PF80_LOG_CROSSING,
+                                  (uint8_t)(signal & 0x07), value};
+  return append(event);
+}
+
+/*!
+ * @brief Append a fault
+ * @param timestamp_ms Event time
+ * @param fault Fault code
+ * @return True if the event was written, false otherwise
+ */
+bool Adafruit_STHS34PF80_EventLog::logFault(uint32_t timestamp_ms,
+                                            sths34pf80_fault_t fault) {
+  sths34pf80_log_event_t event = {timestamp_ms, STHS34PF80_LOG_FAULT,
+                                  (uint8_t)fault, 0};
+  return append(event);
+}
+
+/*!
+ * @brief Set the thresholds record() checks for crossings
+ * @param presence TPRESENCE threshold, 0 or less to disable
+ * @param motion TMOTION threshold, 0 or less to disable
+ * @param temp_shock TAMB_SHOCK threshold, 0 or less to disable
+ */
+void Adafruit_STHS34PF80_EventLog::setThresholds(int16_t presence,
+                                                 int16_t motion,
+                                                 int16_t temp_shock) {
+  _thresholds[STHS34PF80_LOG_PRESENCE] = presence;
+  _thresholds[STHS34PF80_LOG_MOTION] = motion;
+  _thresholds[STHS34PF80_LOG_TEMP_SHOCK] = temp_shock;
+}
+
+/*!
+ * @brief Log the flag changes and threshold crossings of a new sample
+ *
+ * The first sample after begin() logs its flags as the starting state.
+ * @param timestamp_ms Sample time
+ * @param sample Sample from Adafruit_STHS34PF80::readSample()
+ * @return Number of events logged
+ */
+uint8_t Adafruit_STHS34PF80_EventLog::record(
+    uint32_t timestamp_ms, const sths34pf80_sample_t& sample) {
+  uint8_t logged = 0;
+  uint8_t flags = sample.flags & 0x07;
+  if ((!_primed || flags != _flags) && logFlags(timestamp_ms, flags)) {
+    logged++;
+  }
+  _flags = flags;
+
+  int16_t values[3] = {sample.presence, sample.motion, sample.temp_shock};
+  for (uint8_t s = 0; s < 3; s++) {
+    if (_thresholds[s] <= 0) {
+      continue;
+    }
+    uint8_t bit = 1 << s;
+    bool above = values[s] >= _thresholds[s];
+    if (_primed && above != (bool)(_above & bit) &&
+        logCrossing(timestamp_ms, s | (above ? STHS34PF80_LOG_RISING : 0),
+                    values[s])) {
+      logged++;
+    }
+    _above = above ? _above | bit : _above & ~bit;
+  }
+  _primed = true;
+  return logged;
+}
+
+/*!
+ * @brief Make the appended events durable (fsync on files)
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_EventLog::sync() {
+  return _storage && _storage->sync();
+}
+
+/*!
+ * @brief Point a cursor at the oldest event
+ * @param cursor Set to the read position
+ * @return False if the log is empty
+ */
+bool Adafruit_STHS34PF80_EventLog::rewind(sths34pf80_log_cursor_t* cursor) {
+  if (!_storage || !_used || !cursor) {
+    return false;
+  }
+  uint16_t page = oldestPage();
+  uint32_t base_ms;
+  if (!readHeader(page, &cursor->seq, &base_ms)) {
+    return false;
+  }
+  cursor->page = page;
+  cursor->offset = STHS34PF80_LOG_HEADER_LEN;
+  cursor->timestamp_ms = base_ms;
+  return true;
+}
+
+/*!
+ * @brief Point a cursor at the first event at or after a time
+ *
+ * Binary search over the page headers, then a scan of one page.
+ * @param from_ms Start time
+ * @param cursor Set to the read position
+ * @return False if the log is empty
+ */
+bool Adafruit_STHS34PF80_EventLog::seek(uint32_t from_ms,
+                                        sths34pf80_log_cursor_t* cursor) {
+  if (!rewind(cursor)) {
+    return false;
+  }
+
+  uint16_t pages = _storage->pageCount();
+  uint16_t oldest = cursor->page;
+  uint16_t lo = 0;
+  uint16_t hi = _used - 1;
+  while (lo < hi) {
+    uint16_t mid = lo + (hi - lo + 1) / 2;
+    uint32_t seq;
+    uint32_t base_ms;
+    if (readHeader((oldest + mid) % pages, &seq, &base_ms) &&
+        base_ms <= from_ms) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  cursor->page = (oldest + lo) % pages;
+  if (!readHeader(cursor->page, &cursor->seq, &cursor->timestamp_ms)) {
+    return false;
+  }
+
+  sths34pf80_log_event_t event;
+  uint32_t ts = cursor->timestamp_ms;
+  int8_t len;
+  while ((len = readRecord(cursor->page, cursor->offset, &ts, &event)) > 0 &&
+         ts < from_ms) {
+    cursor->offset += len;
+    cursor->timestamp_ms = ts;
+  }
+  return true;
+}
+
+/*!
+ * @brief Read events from a cursor onwards
+ *
+ * If the writer wrapped over the cursor's page, reading restarts at the
+ * oldest remaining event.
+ * @param cursor Read position, advanced past the returned events
+ * @param events Destination
+ * @param max_events Capacity of events
+ * @param to_ms Stop before events later than this
+ * @return Number of events read; fewer than max_events at the end of the log
+ * or of the range
+ */
+uint16_t Adafruit_STHS34PF80_EventLog::read(sths34pf80_log_cursor_t* cursor,
+                                            sths34pf80_log_event_t* events,
+                                            uint16_t max_events,
+                                            uint32_t to_ms) {
+  if (!_storage || !_used || !cursor || !events) {
+    return 0;
+  }
+
+  uint16_t count = 0;
+  uint32_t seq;
+  uint32_t base_ms;
+  if (!readHeader(cursor->page, &seq, &base_ms) || seq != cursor->seq) {
+    if (!rewind(cursor)) {
+      return 0;
+    }
+  }
+
+  while (count < max_events) {
+    uint32_t ts = cursor->timestamp_ms;
+    int8_t len = readRecord(cursor->page, cursor->offset, &ts, &events[count]);
+    if (len > 0) {
+      if (ts > to_ms) {
+        break;
+      }
+      cursor->offset += len;
+      cursor->timestamp_ms = ts;
+      count++;
+      continue;
+    }
+
+    // End of this page, follow the ring unless it is the newest one
+    if (cursor->page == _page && cursor->seq == _seq) {
+      break;
+    }
+    uint16_t next = (cursor->page + 1) % _storage->pageCount();
+    if (!readHeader(next, &seq, &base_ms) || seq != cursor->seq + 1) {
+      break;
+    }
+    cursor->page = next;
+    cursor->seq = seq;
+    cursor->offset = STHS34PF80_LOG_HEADER_LEN;
+    cursor->timestamp_ms = base_ms;
+  }
+  return count;
+}
+
+/*!
+ * @brief Get the timestamp of the newest event
+ * @return Milliseconds, 0 if the log is empty
+ */
+uint32_t Adafruit_STHS34PF80_EventLog::lastTimestamp() { return _last_ms; }
+
+/*!
+ * @brief Get the activity counters since begin()
+ * @param stats Set to the counters
+ */
+void Adafruit_STHS34PF80_EventLog::getStats(sths34pf80_log_stats_t* stats) {
+  if (stats) {
+    *stats = _stats;
+  }
+}
+
+/*!
+ * @brief CRC-8 (poly 0x07)
+ * @param data Bytes to check
+ * @param len Number of bytes
+ * @param crc Start value, or a previous result to continue
+ * @return The CRC
+ */
+uint8_t Adafruit_STHS34PF80_EventLog::crc8(const uint8_t* data, uint8_t len,
+                                           uint8_t crc) {
+  for (uint8_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = crc & 0x80 ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/*!
+ * @brief Read and check a page header
+ * @param page Page index
+ * @param seq Set to the page sequence number
+ * @param base_ms Set to the timestamp of the first record
+ * @return False for erased, torn or foreign pages
+ */
+bool Adafruit_STHS34PF80_EventLog::readHeader(uint16_t page, uint32_t* seq,
+                                              uint32_t* base_ms) {
+  uint8_t h[STHS34PF80_LOG_HEADER_LEN];
+  if (!_storage->read((uint32_t)page * _storage->pageSize(), h, sizeof(h)) ||
+      h[0] != STHS34PF80_LOG_MAGIC || h[1] != STHS34PF80_LOG_VERSION ||
+      crc8(h, sizeof(h) - 1) != h[sizeof(h) - 1]) {
+    return false;
+  }
+  *seq = h[2] | ((uint32_t)h[3] << 8) | ((uint32_t)h[4] << 16) |
+         ((uint32_t)h[5] << 24);
+  *base_ms = h[6] | ((uint32_t)h[7] << 8) | ((uint32_t)h[8] << 16) |
+             ((uint32_t)h[9] << 24);
+  return true;
+}
+
+/*!
+ * @brief Erase a page and start it as the newest page
+ * @param page Page index
+ * @param base_ms Timestamp of its first record
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_EventLog::openPage(uint16_t page, uint32_t base_ms) {
+  if (!_storage->erase(page)) {
+    return false;
+  }
+  _stats.erases++;
+
+  uint32_t seq = _seq + 1;
+  uint8_t h[STHS34PF80_LOG_HEADER_LEN] = {
+      STHS34PF80_LOG_MAGIC, STHS34PF80_LOG_VERSION, (uint8_t)seq,
+      (uint8_t)(seq >> 8),  (uint8_t)(seq >> 16),   (uint8_t)(seq >> 24),
+      (uint8_t)base_ms,     (uint8_t)(base_ms >> 8), (uint8_t)(base_ms >> 16),
+      (uint8_t)(base_ms >> 24)};
+  h[sizeof(h) - 1] = crc8(h, sizeof(h) - 1);
+  if (!_storage->write((uint32_t)page * _storage->pageSize(), h, sizeof(h))) {
+    return false;
+  }
+  _stats.header_bytes += sizeof(h);
+
+  if (_used < _storage->pageCount()) {
+    _used++;
+  }
+  _seq = seq;
+  _page = page;
+  _offset = STHS34PF80_LOG_HEADER_LEN;
+  _last_ms = base_ms;
+  return true;
+}
+
+/*!
+ * @brief Decode one record
+ * @param page Page index
+ * @param offset Byte offset in the page
+ * @param timestamp_ms Previous record time in, this record's time out
+ * @param event Set to the event
+ * @return Record length, 0 at the end of the data, -1 for a torn record
+ */
+int8_t Adafruit_STHS34PF80_EventLog::readRecord(
+    uint16_t page, uint16_t offset, uint32_t* timestamp_ms,
+    sths34pf80_log_event_t* event) {
+  uint16_t page_size = _storage->pageSize();
+  if (offset >= page_size) {
+    return 0;
+  }
+  uint8_t buf[STHS34PF80_LOG_MAX_RECORD];
+  uint8_t avail = page_size - offset < STHS34PF80_LOG_MAX_RECORD
+                      ? page_size - offset
+                      : STHS34PF80_LOG_MAX_RECORD;
+  if (!_storage->read((uint32_t)page * page_size + offset, buf, avail)) {
+    return -1;
+  }
+  if (buf[0] == 0xFF) {
+    return 0;
+  }
+
+  uint8_t type = buf[0] >> 4;
+  if (type < STHS34PF80_LOG_FLAGS || type > STHS34PF80_LOG_FAULT) {
+    return -1;
+  }
+  uint8_t len = 1;
+  uint32_t delta = 0;
+  for (uint8_t shift = 0;; shift += 7) {
+    if (len >= avail || shift > 28) {
+      return -1;
+    }
+    uint8_t b = buf[len++];
+    delta |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      break;
+    }
+  }
+  int16_t value = 0;
+  if (type == STHS34PF80_LOG_CROSSING) {
+    if (len + 2 >= avail) {
+      return -1;
+    }
+    value = (int16_t)(buf[len] | (buf[len + 1] << 8));
+    len += 2;
+  }
+  if (len >= avail || crc8(buf, len) != buf[len]) {
+    return -1;
+  }
+
+  *timestamp_ms += delta;
+  event->timestamp_ms = *timestamp_ms;
+  event->type = (sths34pf80_log_type_t)type;
+  event->code = buf[0] & 0x0F;
+  event->value = value;
+  return len + 1;
+}
+
+/*!
+ * @brief Get the page holding the oldest events
+ * @return Page index
+ */
+uint16_t Adafruit_STHS34PF80_EventLog::oldestPage() {
+  uint16_t pages = _storage->pageCount();
+  return (_page + 1 + pages - _used) % pages;
+}
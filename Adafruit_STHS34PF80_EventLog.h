@@ -0,0 +1,257 @@
+/*!
+ * @file Adafruit_STHS34PF80_EventLog.h
+ *
+ * Append-only, wear-levelled log of STHS34PF80 events (flag transitions,
+ * threshold crossings and faults) in RAM, EEPROM (see
+ * Adafruit_STHS34PF80_EEPROMStorage.h) or a file, for backfill after a node
+ * has been offline.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_EVENTLOG_H__
+#define __ADAFRUIT_STHS34PF80_EVENTLOG_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+#define STHS34PF80_LOG_MAGIC 0xA5   ///< First byte of every page header
+#define STHS34PF80_LOG_VERSION 0x01 ///< Page format version
+#define STHS34PF80_LOG_HEADER_LEN 11 ///< Page header bytes
+#define STHS34PF80_LOG_MAX_RECORD 9  ///< Longest encoded record
+
+/*!
+ * @brief Event types
+ */
+typedef enum {
+  STHS34PF80_LOG_FLAGS = 0x01,    ///< FUNC_STATUS flags changed
+  STHS34PF80_LOG_CROSSING = 0x02, ///< A signal crossed its threshold
+  STHS34PF80_LOG_FAULT = 0x03,    ///< Sensor or bus fault
+} sths34pf80_log_type_t;
+
+/*!
+ * @brief Signals checked for threshold crossings, in the low bits of the
+ * crossing code; STHS34PF80_LOG_RISING is set for upward crossings
+ */
+typedef enum {
+  STHS34PF80_LOG_PRESENCE = 0x00,   ///< TPRESENCE
+  STHS34PF80_LOG_MOTION = 0x01,     ///< TMOTION
+  STHS34PF80_LOG_TEMP_SHOCK = 0x02, ///< TAMB_SHOCK
+  STHS34PF80_LOG_RISING = 0x04,     ///< Crossed upwards
+} sths34pf80_log_signal_t;
+
+/*!
+ * @brief Fault codes
+ */
+typedef enum {
+  STHS34PF80_FAULT_BUS = 0x01,     ///< I2C transaction failed
+  STHS34PF80_FAULT_TIMEOUT = 0x02, ///< No data ready in time
+  STHS34PF80_FAULT_CONFIG = 0x03,  ///< Configuration hash mismatch
+  STHS34PF80_FAULT_RESET = 0x04,   ///< Sensor was reset or re-initialized
+} sths34pf80_fault_t;
+
+/*!
+ * @brief One logged event
+ */
+typedef struct {
+  uint32_t timestamp_ms;      ///< Event time
+  sths34pf80_log_type_t type; ///< Event type
+  uint8_t code;  ///< New flags, signal (with RISING), or fault code
+  int16_t value; ///< Signal value for crossings, 0 otherwise
+} sths34pf80_log_event_t;
+
+/*!
+ * @brief Read position in the log, from seek() or rewind()
+ */
+typedef struct {
+  uint32_t seq;    ///< Sequence number of the page being read
+  uint16_t page;   ///< Page index
+  uint16_t offset; ///< Byte offset of the next record in the page
+  uint32_t timestamp_ms; ///< Timestamp of the previous record
+} sths34pf80_log_cursor_t;
+
+/*!
+ * @brief Log activity counters, for write amplification figures
+ */
+typedef struct {
+  uint32_t events;       ///< Records appended
+  uint32_t record_bytes; ///< Encoded record bytes written
+  uint32_t header_bytes; ///< Page header bytes written
+  uint32_t erases;       ///< Pages erased
+} sths34pf80_log_stats_t;
+
+/*!
+ * @brief Block storage the log lives on
+ *
+ * Storage is split into equal erase pages. Erased bytes read 0xFF and
+ * write() only ever programs erased bytes, so NOR flash, EEPROM and files
+ * all work.
+ */
+class Adafruit_STHS34PF80_LogStorage {
+ public:
+  virtual ~Adafruit_STHS34PF80_LogStorage() {}
+
+  /*!
+   * @brief Get the number of erase pages
+   * @return Page count
+   */
+  virtual uint16_t pageCount() = 0;
+  /*!
+   * @brief Get the erase page size
+   * @return Bytes per page
+   */
+  virtual uint16_t pageSize() = 0;
+  /*!
+   * @brief Read bytes
+   * @param addr Byte address
+   * @param data Destination
+   * @param len Number of bytes
+   * @return True if successful, false otherwise
+   */
+  virtual bool read(uint32_t addr, uint8_t* data, uint16_t len) = 0;
+  /*!
+   * @brief Program erased bytes
+   * @param addr Byte address
+   * @param data Bytes to write
+   * @param len Number of bytes
+   * @return True if successful, false otherwise
+   */
+  virtual bool write(uint32_t addr, const uint8_t* data, uint16_t len) = 0;
+  /*!
+   * @brief Erase one page to 0xFF
+   * @param page Page index
+   * @return True if successful, false otherwise
+   */
+  virtual bool erase(uint16_t page) = 0;
+  /*!
+   * @brief Make written data durable
+   * @return True if successful, false otherwise
+   */
+  virtual bool sync() { return true; }
+};
+
+/*!
+ * @brief Log storage in a caller-provided RAM buffer, with flash
+ * programming semantics (write() can only clear bits), so it does not
+ * survive a reset; use Adafruit_STHS34PF80_EEPROMStorage to persist
+ */
+class Adafruit_STHS34PF80_MemoryStorage
+    : public Adafruit_STHS34PF80_LogStorage {
+ public:
+  Adafruit_STHS34PF80_MemoryStorage(uint8_t* buffer, uint32_t size,
+                                    uint16_t page_size);
+
+  uint16_t pageCount();
+  uint16_t pageSize();
+  bool read(uint32_t addr, uint8_t* data, uint16_t len);
+  bool write(uint32_t addr, const uint8_t* data, uint16_t len);
+  bool erase(uint16_t page);
+
+ private:
+  uint8_t* _buffer;
+  uint32_t _size;
+  uint16_t _page_size;
+};
+
+#if defined(__linux__)
+/*!
+ * @brief Log storage in a file, accessed with pread/pwrite or through a
+ * shared memory mapping
+ */
+class Adafruit_STHS34PF80_FileStorage : public Adafruit_STHS34PF80_LogStorage {
+ public:
+  Adafruit_STHS34PF80_FileStorage();
+  ~Adafruit_STHS34PF80_FileStorage();
+
+  bool begin(const char* path, uint16_t pages, uint16_t page_size,
+             bool mapped = false);
+  void end();
+
+  uint16_t pageCount();
+  uint16_t pageSize();
+  bool read(uint32_t addr, uint8_t* data, uint16_t len);
+  bool write(uint32_t addr, const uint8_t* data, uint16_t len);
+  bool erase(uint16_t page);
+  bool sync();
+
+  uint64_t bytesWritten();
+
+ private:
+  int _fd;
+  uint8_t* _map;
+  uint16_t _pages;
+  uint16_t _page_size;
+  uint64_t _written;
+};
+#endif
+
+/*!
+ * @brief Class that appends events to a ring of storage pages and reads
+ * them back by time
+ *
+ * Each page starts with a header (magic, version, sequence number, first
+ * timestamp, CRC-8) followed by records:
+ *
+ *   type (high nibble) | code (low nibble)
+ *   varint milliseconds since the previous record in the page
+ *   crossings only: int16 value, little endian
+ *   CRC-8 over the record
+ *
+ * A flag change takes 3 bytes, a crossing 5. Pages are filled in ring
+ * order and the oldest page is erased when the log wraps, so every page
+ * sees the same number of erase cycles. begin() finds the newest page from
+ * the sequence numbers and the end of its data from the first erased or
+ * torn record, so a power loss costs at most the record being written.
+ */
+class Adafruit_STHS34PF80_EventLog {
+ public:
+  Adafruit_STHS34PF80_EventLog();
+
+  bool begin(Adafruit_STHS34PF80_LogStorage* storage);
+  bool format();
+
+  bool append(const sths34pf80_log_event_t& event);
+  bool logFlags(uint32_t timestamp_ms, uint8_t flags);
+  bool logCrossing(uint32_t timestamp_ms, uint8_t signal, int16_t value);
+  bool logFault(uint32_t timestamp_ms, sths34pf80_fault_t fault);
+
+  void setThresholds(int16_t presence, int16_t motion, int16_t temp_shock);
+  uint8_t record(uint32_t timestamp_ms, const sths34pf80_sample_t& sample);
+  bool sync();
+
+  bool rewind(sths34pf80_log_cursor_t* cursor);
+  bool seek(uint32_t from_ms, sths34pf80_log_cursor_t* cursor);
+  uint16_t read(sths34pf80_log_cursor_t* cursor,
+                sths34pf80_log_event_t* events, uint16_t max_events,
+                uint32_t to_ms = 0xFFFFFFFFUL);
+
+  uint32_t lastTimestamp();
+  void getStats(sths34pf80_log_stats_t* stats);
+
+  static uint8_t crc8(const uint8_t* data, uint8_t len, uint8_t crc = 0);
+
+ private:
+  bool readHeader(uint16_t page, uint32_t* seq, uint32_t* base_ms);
+  bool openPage(uint16_t page, uint32_t base_ms);
+  int8_t readRecord(uint16_t page, uint16_t offset, uint32_t* timestamp_ms,
+                    sths34pf80_log_event_t* event);
+  uint16_t oldestPage();
+
+  Adafruit_STHS34PF80_LogStorage* _storage;
+  uint32_t _seq;
+  uint32_t _last_ms;
+  uint16_t _page;
+  uint16_t _offset;
+  uint16_t _used;
+  int16_t _thresholds[3];
+  uint8_t _flags;
+  uint8_t _above;
+  bool _primed;
+  sths34pf80_log_stats_t _stats;
+};
+
+#endif
@@ -0,0 +1,241 @@
+/*!
+ * @file Adafruit_STHS34PF80_Fixed.h
+ *
+ * Compile-time fixed-configuration variant of the STHS34PF80 driver.
+ *
+ * The whole register image (LPF1, LPF2, AVG_TRIM, CTRL0, CTRL1, CTRL3) and
+ * the embedded-function payload are computed from a configuration struct at
+ * compile time, invalid ODR/averaging combinations are rejected with
+ * static_assert, and begin() applies everything in a short burst sequence.
+ * Unused runtime setters are never referenced, so the linker drops them.
+ *
+ * Usage:
+ *
+ *   struct MyConfig : Adafruit_STHS34PF80_FixedDefaults {
+ *     static constexpr sths34pf80_odr_t odr = STHS34PF80_ODR_4_HZ;
+ *     static constexpr sths34pf80_avg_tmos_t avg_tmos =
+ *         STHS34PF80_AVG_TMOS_128;
+ *   };
+ *   Adafruit_STHS34PF80_Fixed<MyConfig> sths;
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_FIXED_H__
+#define __ADAFRUIT_STHS34PF80_FIXED_H__
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Model.h"
+
+#define STHS34PF80_EMBEDDED_PAYLOAD_LEN \
+  11 ///< PRESENCE_THS (0x20) through RESET_ALGO (0x2A)
+
+/*!
+ * @brief Default fixed configuration, matching begin() and the sensor's
+ * power-on filter and algorithm settings. Derive from it and shadow only
+ * the members that differ.
+ */
+struct Adafruit_STHS34PF80_FixedDefaults {
+  /// Output data rate
+  static constexpr sths34pf80_odr_t odr = STHS34PF80_ODR_1_HZ;
+  /// Object temperature averaging
+  static constexpr sths34pf80_avg_tmos_t avg_tmos = STHS34PF80_AVG_TMOS_32;
+  /// Ambient temperature averaging
+  static constexpr sths34pf80_avg_t_t avg_t = STHS34PF80_AVG_T_8;
+  /// Motion low-pass filter
+  static constexpr sths34pf80_lpf_config_t lpf_m = STHS34PF80_LPF_ODR_DIV_9;
+  /// Motion and presence low-pass filter
+  static constexpr sths34pf80_lpf_config_t lpf_p_m = STHS34PF80_LPF_ODR_DIV_9;
+  /// Presence low-pass filter
+  static constexpr sths34pf80_lpf_config_t lpf_p = STHS34PF80_LPF_ODR_DIV_9;
+  /// Ambient shock low-pass filter
+  static constexpr sths34pf80_lpf_config_t lpf_a_t = STHS34PF80_LPF_ODR_DIV_9;
+  /// Wide gain mode
+  static constexpr bool wide_gain = false;
+  /// Block data update
+  static constexpr bool block_data_update = true;
+  /// Signal routed to the INT pin
+  static constexpr sths34pf80_int_signal_t int_signal = STHS34PF80_INT_HIGH_Z;
+  /// INT_OR function flag mask (bits 2:0)
+  static constexpr uint8_t int_mask = 0;
+  /// Latch INT until FUNC_STATUS is read
+  static constexpr bool int_latched = false;
+  /// INT active low
+  static constexpr bool int_active_low = false;
+  /// INT open drain
+  static constexpr bool int_open_drain = false;
+  /// Program the algorithm thresholds below (otherwise keep OTP defaults)
+  static constexpr bool program_thresholds = false;
+  /// PRESENCE_THS (15 bits)
+  static constexpr uint16_t presence_threshold = 200;
+  /// MOTION_THS (15 bits)
+  static constexpr uint16_t motion_threshold = 200;
+  /// TAMB_SHOCK_THS (15 bits)
+  static constexpr uint16_t tamb_shock_threshold = 10;
+  /// HYST_MOTION
+  static constexpr uint8_t motion_hysteresis = 50;
+  /// HYST_PRESENCE
+  static constexpr uint8_t presence_hysteresis = 50;
+  /// ALGO_CONFIG
+  static constexpr uint8_t algo_config = 0;
+  /// HYST_TAMB_SHOCK
+  static constexpr uint8_t tamb_shock_hysteresis = 2;
+};
+
+/*!
+ * @brief The acquisition and filter part of a fixed configuration, as seen by
+ * Adafruit_STHS34PF80_Model
+ * @tparam Config Configuration struct derived from
+ * Adafruit_STHS34PF80_FixedDefaults
+ * @return The acquisition and filter configuration
+ */
+template <class Config>
+constexpr sths34pf80_config_t sths34pf80_fixed_config() {
+  return sths34pf80_config_t{Config::odr,   Config::avg_tmos, Config::avg_t,
+                             Config::lpf_m, Config::lpf_p_m,  Config::lpf_p,
+                             Config::lpf_a_t};
+}
+
+/*!
+ * @brief STHS34PF80 driver whose configuration is fixed at compile time
+ * @tparam Config Configuration struct derived from
+ * Adafruit_STHS34PF80_FixedDefaults
+ */
+template <class Config>
+class Adafruit_STHS34PF80_Fixed : public Adafruit_STHS34PF80 {
+ public:
+  /// Validation result of the acquisition and filter configuration
+  static constexpr sths34pf80_config_status_t status =
+      Adafruit_STHS34PF80_Model::validate(sths34pf80_fixed_config<Config>());
+
+  static_assert(status == STHS34PF80_CONFIG_OK ||
+                    status == STHS34PF80_CONFIG_POWER_DOWN,
+                "ODR, averaging or LPF value out of range, or ODR above the "
+                "maximum for the object averaging setting");
+  static_assert(Config::int_mask <= 0x07, "INT mask is 3 bits");
+  static_assert(Config::int_signal <= STHS34PF80_INT_OR,
+                "INT signal out of range");
+  static_assert(Config::presence_threshold <= 0x7FFF &&
+                    Config::motion_threshold <= 0x7FFF &&
+                    Config::tamb_shock_threshold <= 0x7FFF,
+                "Algorithm thresholds are 15 bits");
+
+  /// LPF1 image: LPF_P_M (5:3), LPF_M (2:0)
+  static constexpr uint8_t lpf1 = (Config::lpf_p_m << 3) | Config::lpf_m;
+  /// LPF2 image: LPF_P (5:3), LPF_A_T (2:0)
+  static constexpr uint8_t lpf2 = (Config::lpf_p << 3) | Config::lpf_a_t;
+  /// AVG_TRIM image: AVG_T (5:4), AVG_TMOS (2:0)
+  static constexpr uint8_t avg_trim = (Config::avg_t << 4) | Config::avg_tmos;
+  /// CTRL0 GAIN field (6:4), the rest of CTRL0 is preserved
+  static constexpr uint8_t ctrl0_gain = Config::wide_gain ? 0x00 : 0x70;
+  /// CTRL1 image: BDU (4), ODR (3:0)
+  static constexpr uint8_t ctrl1 =
+      (Config::block_data_update ? 0x10 : 0x00) | Config::odr;
+  /// CTRL3 image: INT_H_L, PP_OD, INT_MSK, INT_LATCHED, IEN
+  static constexpr uint8_t ctrl3 = (Config::int_active_low ? 0x80 : 0x00) |
+                                   (Config::int_open_drain ? 0x40 : 0x00) |
+                                   (Config::int_mask << 3) |
+                                   (Config::int_latched ? 0x04 : 0x00) |
+                                   Config::int_signal;
+
+  using Adafruit_STHS34PF80::begin;
+
+  /*!
+   * @brief Initializes the sensor and applies the fixed configuration
+   * @param i2c_addr I2C address to use
+   * @param wire The Wire object to be used for I2C connections
+   * @return True if initialization was successful, otherwise false
+   */
+  bool begin(uint8_t i2c_addr = STHS34PF80_DEFAULT_ADDR,
+             TwoWire* wire = &Wire) {
+    return initDevice(i2c_addr, wire) && applyFixed();
+  }
+
+  /*!
+   * @brief Initializes the sensor on a caller-provided bus device and
+   * applies the fixed configuration
+   * @param device The device, which must outlive this object
+   * @return True if initialization was successful, otherwise false
+   */
+  bool begin(Adafruit_GenericDevice* device) {
+    return initDevice(device) && applyFixed();
+  }
+
+ private:
+  /*!
+   * @brief Reboot the sensor and apply the fixed configuration
+   *
+   * Sequence after the OTP reboot (which leaves the sensor powered down):
+   * LPF1+LPF2 in one burst, AVG_TRIM, CTRL0 gain (read-modify-write, only
+   * written if different), CTRL3, then a single embedded-function session
+   * that writes the thresholds (if enabled) together with RESET_ALGO, and
+   * finally CTRL1 to start acquisition.
+   * @return True if successful, false otherwise
+   */
+  bool applyFixed() {
+    if (!rebootOTPmemory()) {
+      return false;
+    }
+
+    // Wait for sensor reset to complete
+    getClock()->delayMillis(STHS34PF80_BOOT_TIME_MS);
+
+    uint8_t lpf[2] = {lpf1, lpf2};
+    uint8_t avg = avg_trim;
+    uint8_t ctrl0;
+    uint8_t int_ctrl = ctrl3;
+    if (!writeRegisters(STHS34PF80_REG_LPF1, lpf, 2) ||
+        !writeRegisters(STHS34PF80_REG_AVG_TRIM, &avg, 1) ||
+        !readRegisters(STHS34PF80_REG_CTRL0, &ctrl0, 1)) {
+      return false;
+    }
+
+    if ((ctrl0 & 0x70) != ctrl0_gain) {
+      ctrl0 = (ctrl0 & ~0x70) | ctrl0_gain;
+      if (!writeRegisters(STHS34PF80_REG_CTRL0, &ctrl0, 1)) {
+        return false;
+      }
+    }
+
+    if (!writeRegisters(STHS34PF80_REG_CTRL3, &int_ctrl, 1)) {
+      return false;
+    }
+
+    if (Config::program_thresholds) {
+      // 0x20-0x29 followed by RESET_ALGO = 1 at 0x2A, one session
+      uint8_t payload[STHS34PF80_EMBEDDED_PAYLOAD_LEN] = {
+          (uint8_t)(Config::presence_threshold & 0xFF),
+          (uint8_t)(Config::presence_threshold >> 8),
+          (uint8_t)(Config::motion_threshold & 0xFF),
+          (uint8_t)(Config::motion_threshold >> 8),
+          (uint8_t)(Config::tamb_shock_threshold & 0xFF),
+          (uint8_t)(Config::tamb_shock_threshold >> 8),
+          Config::motion_hysteresis,
+          Config::presence_hysteresis,
+          Config::algo_config,
+          Config::tamb_shock_hysteresis,
+          1};
+      if (!writeEmbeddedFunction(STHS34PF80_EMBEDDED_PRESENCE_THS, payload,
+                                 STHS34PF80_EMBEDDED_PAYLOAD_LEN)) {
+        return false;
+      }
+    } else {
+      uint8_t reset_value = 1;
+      if (!writeEmbeddedFunction(STHS34PF80_EMBEDDED_RESET_ALGO, &reset_value,
+                                 1)) {
+        return false;
+      }
+    }
+
+    // Powered down with a freshly reset algorithm, so ODR can go straight in
+    uint8_t ctrl = ctrl1;
+    return writeRegisters(STHS34PF80_REG_CTRL1, &ctrl, 1);
+  }
+};
+
+#endif
@@ -0,0 +1,499 @@
+/*!
+ * @file Adafruit_STHS34PF80_Gateway.cpp
+ *
+ * Thread-safe access to many STHS34PF80 sensors from Linux hosts.
+ *
+ * Only bus workers touch the sensors. A worker drains its request queue,
+ * polls every sensor whose next data is due (STATUS, then readSample() on
+ * DRDY) and sleeps until the earliest due time, at most the idle interval.
+ * Polling cost is one STATUS read per sensor per ODR period plus one
+ * sample per new output, so a 400 kHz bus carries a few hundred sensors
+ * at 1 Hz.
+ *
+ * Snapshots use a seqlock: the worker makes the sequence odd, stores the
+ * words, then makes it even again. Readers retry a bounded number of
+ * times, so latest() never blocks and never waits on the worker.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_Gateway.h"
+
+#if defined(__linux__)
+
+#include <string.h>
+
+#include <chrono>
+
+#include "Adafruit_STHS34PF80_Model.h"
+
+/*!
+ * @brief Creates an empty queue
+ * @param depth Capacity, rounded up to a power of two
+ */
+Adafruit_STHS34PF80_Gateway::Queue::Queue(size_t depth) {
+  size_t size = 2;
+  while (size < depth) {
+    size <<= 1;
+  }
+  _cells.reset(new Cell[size]);
+  for (size_t i = 0; i < size; i++) {
+    _cells[i].sequence.store(i, std::memory_order_relaxed);
+    _cells[i].request = NULL;
+  }
+  _mask = size - 1;
+  _tail.store(0, std::memory_order_relaxed);
+  _head.store(0, std::memory_order_relaxed);
+}
+
+/*!
+ * @brief Add a request, from any thread
+ * @param request The request
+ * @return False if the queue is full
+ */
+bool Adafruit_STHS34PF80_Gateway::Queue::push(Request* request) {
+  size_t pos = _tail.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell* cell = &_cells[pos & _mask];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (_tail.compare_exchange_weak(pos, pos + 1,
+                                      std::memory_order_relaxed)) {
+        cell->request = request;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = _tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+/*!
+ * @brief Take the oldest request, from the bus worker only
+ * @param request Set to the request
+ * @return False if the queue is empty
+ */
+bool Adafruit_STHS34PF80_Gateway::Queue::pop(Request** request) {
+  size_t pos = _head.load(std::memory_order_relaxed);
+  Cell* cell = &_cells[pos & _mask];
+  size_t seq = cell->sequence.load(std::memory_order_acquire);
+  if (seq != pos + 1) {
+    return false;
+  }
+  _head.store(pos + 1, std::memory_order_relaxed);
+  *request = cell->request;
+  cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+  return true;
+}
+
+/*!
+ * @brief Instantiates a gateway with no buses
+ * @param queue_depth Request queue capacity per bus
+ */
+Adafruit_STHS34PF80_Gateway::Adafruit_STHS34PF80_Gateway(size_t queue_depth)
+    : _running(false),
+      _inflight(0),
+      _queue_depth(queue_depth),
+      _idle_us(STHS34PF80_GATEWAY_IDLE_US),
+      _start_us(0) {}
+
+/*!
+ * @brief Stops the workers
+ */
+Adafruit_STHS34PF80_Gateway::~Adafruit_STHS34PF80_Gateway() { stop(); }
+
+/*!
+ * @brief Add an I2C bus with its own worker thread
+ * @return Bus index, or -1 once started
+ */
+int Adafruit_STHS34PF80_Gateway::addBus() {
+  if (running()) {
+    return -1;
+  }
+  _buses.push_back(std::unique_ptr<Bus>(new Bus(_queue_depth)));
+  return (int)_buses.size() - 1;
+}
+
+/*!
+ * @brief Hand a sensor to a bus worker. From start() on, the sensor must
+ * only be used through the gateway.
+ * @param bus Bus index from addBus(); every sensor on the same TwoWire
+ * must use the same bus
+ * @param sensor A sensor on which begin() already succeeded
+ * @return Sensor id, or -1 on a bad bus or once started
+ */
+int Adafruit_STHS34PF80_Gateway::addSensor(int bus,
+                                           Adafruit_STHS34PF80* sensor) {
+  if (running() || !sensor || bus < 0 || bus >= (int)_buses.size()) {
+    return -1;
+  }
+  Sensor entry = {sensor, bus, 0, 0, 0};
+  _sensors.push_back(entry);
+  int id = (int)_sensors.size() - 1;
+  _buses[bus]->sensors.push_back(id);
+  return id;
+}
+
+/*!
+ * @brief Set the longest time a worker sleeps before checking its queue
+ * @param idle_us Sleep cap in microseconds (default 1000), bounds request
+ * latency
+ */
+void Adafruit_STHS34PF80_Gateway::setIdleMicros(uint32_t idle_us) {
+  _idle_us = idle_us ? idle_us : 1;
+}
+
+/*!
+ * @brief Start one worker per bus
+ * @return True if started, false if already running or there are no buses
+ */
+bool Adafruit_STHS34PF80_Gateway::start() {
+  if (running() || _buses.empty()) {
+    return false;
+  }
+
+  _slots.reset(new Slot[_sensors.size() ? _sensors.size() : 1]);
+  for (size_t i = 0; i < _sensors.size(); i++) {
+    _slots[i].seq.store(0, std::memory_order_relaxed);
+    for (size_t w = 0; w < STHS34PF80_GATEWAY_SLOT_WORDS; w++) {
+      _slots[i].words[w].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  _start_us = 0;
+  _start_us = nowMicros();
+  for (size_t i = 0; i < _sensors.size(); i++) {
+    _sensors[i].count = 0;
+    schedule(&_sensors[i], 0);
+  }
+
+  _running.store(true, std::memory_order_release);
+  for (size_t b = 0; b < _buses.size(); b++) {
+    _threads.push_back(
+        std::thread(&Adafruit_STHS34PF80_Gateway::worker, this, (int)b));
+  }
+  return true;
+}
+
+/*!
+ * @brief Stop the workers after they finish every accepted request
+ */
+void Adafruit_STHS34PF80_Gateway::stop() {
+  _running.store(false, std::memory_order_seq_cst);
+  for (size_t i = 0; i < _threads.size(); i++) {
+    _threads[i].join();
+  }
+  _threads.clear();
+}
+
+/*!
+ * @brief Check if the workers are running
+ * @return True between start() and stop()
+ */
+bool Adafruit_STHS34PF80_Gateway::running() {
+  return _running.load(std::memory_order_seq_cst);
+}
+
+/*!
+ * @brief Get the latest published sample without locking, from any thread
+ * @param id Sensor id
+ * @param snapshot Set to the sample, its timestamp and count
+ * @return False on a bad id, before the first sample or if the worker kept
+ * publishing during all STHS34PF80_GATEWAY_READ_TRIES attempts
+ */
+bool Adafruit_STHS34PF80_Gateway::latest(int id,
+                                         sths34pf80_snapshot_t* snapshot) {
+  if (!_slots || id < 0 || id >= (int)_sensors.size() || !snapshot) {
+    return false;
+  }
+
+  Slot* slot = &_slots[id];
+  uint32_t words[STHS34PF80_GATEWAY_SLOT_WORDS];
+  for (uint8_t tries = 0; tries < STHS34PF80_GATEWAY_READ_TRIES; tries++) {
+    uint32_t before = slot->seq.load(std::memory_order_acquire);
+    if (before & 1) {
+      continue;
+    }
+    for (size_t w = 0; w < STHS34PF80_GATEWAY_SLOT_WORDS; w++) {
+      words[w] = slot->words[w].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->seq.load(std::memory_order_relaxed) == before) {
+      memcpy(snapshot, words, sizeof(*snapshot));
+      return snapshot->count != 0;
+    }
+  }
+  return false;
+}
+
+/*!
+ * @brief Get how many samples have been published for a sensor
+ * @param id Sensor id
+ * @return Sample count, 0 if none or on a bad id
+ */
+uint32_t Adafruit_STHS34PF80_Gateway::sampleCount(int id) {
+  sths34pf80_snapshot_t snapshot;
+  return latest(id, &snapshot) ? snapshot.count : 0;
+}
+
+/*!
+ * @brief Run a function on the bus worker that owns a sensor and wait for
+ * it. It runs between polls with exclusive access to the bus.
+ * @param id Sensor id
+ * @param fn Function to run
+ * @param context Passed to fn
+ * @return The result of fn, false if not running or on a bad id
+ */
+bool Adafruit_STHS34PF80_Gateway::call(int id, sths34pf80_gateway_fn_t fn,
+                                       void* context) {
+  if (id < 0 || id >= (int)_sensors.size() || !fn) {
+    return false;
+  }
+
+  // Workers only exit once nothing is in flight, so an accepted request is
+  // always completed. The increment and the running() check here, and the
+  // store in stop() and the in-flight check in worker(), are a store-load
+  // handshake on two variables: all four are seq_cst so at least one side
+  // sees the other.
+  _inflight.fetch_add(1, std::memory_order_seq_cst);
+  if (!running()) {
+    _inflight.fetch_sub(1, std::memory_order_seq_cst);
+    return false;
+  }
+
+  Request request;
+  request.id = id;
+  request.fn = fn;
+  request.context = context;
+  request.result = false;
+  request.done.store(false, std::memory_order_relaxed);
+
+  Bus* bus = _buses[_sensors[id].bus].get();
+  while (!bus->queue.push(&request)) {
+    std::this_thread::yield();
+  }
+
+  uint32_t spins = 0;
+  while (!request.done.load(std::memory_order_acquire)) {
+    if (++spins < 64) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+
+  _inflight.fetch_sub(1, std::memory_order_seq_cst);
+  return request.result;
+}
+
+static bool gatewaySetOutputDataRate(Adafruit_STHS34PF80* sensor,
+                                     void* context) {
+  return sensor->setOutputDataRate(*(sths34pf80_odr_t*)context);
+}
+
+static bool gatewayApplyProfile(Adafruit_STHS34PF80* sensor, void* context) {
+  return sensor->applyProfile(*(const sths34pf80_profile_t*)context);
+}
+
+/*!
+ * @brief Set a sensor's output data rate through its bus worker
+ * @param id Sensor id
+ * @param odr Output data rate
+ * @return True if successful, otherwise false
+ */
+bool Adafruit_STHS34PF80_Gateway::setOutputDataRate(int id,
+                                                    sths34pf80_odr_t odr) {
+  return call(id, gatewaySetOutputDataRate, &odr);
+}
+
+/*!
+ * @brief Apply an acquisition profile through the sensor's bus worker
+ * @param id Sensor id
+ * @param profile The profile
+ * @return True if successful, otherwise false
+ */
+bool Adafruit_STHS34PF80_Gateway::applyProfile(
+    int id, const sths34pf80_profile_t& profile) {
+  return call(id, gatewayApplyProfile, (void*)&profile);
+}
+
+/*!
+ * @brief Get the number of failed transactions on a bus
+ * @param bus Bus index
+ * @return Failed STATUS or sample reads, 0 on a bad index
+ */
+uint32_t Adafruit_STHS34PF80_Gateway::busErrors(int bus) {
+  if (bus < 0 || bus >= (int)_buses.size()) {
+    return 0;
+  }
+  return _buses[bus]->errors.load(std::memory_order_relaxed);
+}
+
+/*!
+ * @brief Get the number of requests a bus worker has executed
+ * @param bus Bus index
+ * @return Executed requests, 0 on a bad index
+ */
+uint32_t Adafruit_STHS34PF80_Gateway::busRequests(int bus) {
+  if (bus < 0 || bus >= (int)_buses.size()) {
+    return 0;
+  }
+  return _buses[bus]->requests.load(std::memory_order_relaxed);
+}
+
+/*!
+ * @brief Worker loop of one bus
+ * @param index Bus index
+ */
+void Adafruit_STHS34PF80_Gateway::worker(int index) {
+  Bus* bus = _buses[index].get();
+
+  for (;;) {
+    Request* request;
+    while (bus->queue.pop(&request)) {
+      Sensor* sensor = &_sensors[request->id];
+      request->result = request->fn(sensor->dev, request->context);
+      bus->requests.fetch_add(1, std::memory_order_relaxed);
+      // The call may have changed the ODR, re-read it before polling again
+      schedule(sensor, nowMicros());
+      request->done.store(true, std::memory_order_release);
+    }
+
+    if (!running() && _inflight.load(std::memory_order_seq_cst) == 0) {
+      return;
+    }
+
+    uint64_t now = nowMicros();
+    uint64_t wake = now + _idle_us;
+    for (size_t i = 0; i < bus->sensors.size(); i++) {
+      int id = bus->sensors[i];
+      Sensor* sensor = &_sensors[id];
+      if (sensor->period_us && sensor->next_us <= now) {
+        poll(bus, id, now);
+      }
+      if (sensor->period_us && sensor->next_us < wake) {
+        wake = sensor->next_us;
+      }
+    }
+
+    now = nowMicros();
+    if (wake > now) {
+      std::this_thread::sleep_for(std::chrono::microseconds(wake - now));
+    }
+  }
+}
+
+/*!
+ * @brief Check one sensor for new data and publish it
+ * @param bus The sensor's bus
+ * @param id Sensor id
+ * @param now Current time in microseconds since start()
+ */
+void Adafruit_STHS34PF80_Gateway::poll(Bus* bus, int id, uint64_t now) {
+  Sensor* sensor = &_sensors[id];
+  sths34pf80_snapshot_t snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+
+  sths34pf80_poll_t result = pollSensor(sensor->dev, sensor->period_us, now,
+                                        &sensor->next_us, &snapshot.sample);
+  if (result == STHS34PF80_POLL_ERROR) {
+    bus->errors.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (result != STHS34PF80_POLL_SAMPLE) {
+    return;
+  }
+
+  snapshot.timestamp_us = now;
+  snapshot.count = ++sensor->count;
+  publish(id, snapshot);
+}
+
+/*!
+ * @brief One step of the workers' polling policy: read STATUS and, when
+ * DRDY is set, the sample, then schedule the next look. Shared with
+ * Adafruit_STHS34PF80_LoadSim so capacity plans poll exactly like the
+ * gateway.
+ * @param sensor The sensor, its bus held by the caller
+ * @param period_us Output period
+ * @param now Current time in microseconds
+ * @param next_us Next due time, advanced for the next step
+ * @param sample Filled in on STHS34PF80_POLL_SAMPLE
+ * @return Whether a sample was read, no data was ready or the bus failed
+ */
+sths34pf80_poll_t Adafruit_STHS34PF80_Gateway::pollSensor(
+    Adafruit_STHS34PF80* sensor, uint64_t period_us, uint64_t now,
+    uint64_t* next_us, sths34pf80_sample_t* sample) {
+  uint8_t status;
+  if (!sensor->readRegisters(STHS34PF80_REG_STATUS, &status, 1)) {
+    *next_us = now + period_us;
+    return STHS34PF80_POLL_ERROR;
+  }
+
+  if (!(status & 0x04)) {
+    // Not ready yet, look again after an eighth of a period
+    *next_us = now + period_us / 8 + 1;
+    return STHS34PF80_POLL_NOT_READY;
+  }
+
+  if (!sensor->readSample(sample)) {
+    *next_us = now + period_us;
+    return STHS34PF80_POLL_ERROR;
+  }
+
+  // Stay on the sensor's own cadence unless we fell a whole period behind
+  *next_us += period_us;
+  if (*next_us <= now) {
+    *next_us = now + period_us;
+  }
+  return STHS34PF80_POLL_SAMPLE;
+}
+
+/*!
+ * @brief Derive a sensor's polling period from its current ODR
+ * @param sensor The sensor
+ * @param now Current time in microseconds since start()
+ */
+void Adafruit_STHS34PF80_Gateway::schedule(Sensor* sensor, uint64_t now) {
+  float hz = Adafruit_STHS34PF80_Model::odrHz(sensor->dev->getOutputDataRate());
+  // Powered down sensors are not polled until a request changes the ODR
+  sensor->period_us = hz > 0 ? (uint64_t)(1000000.0f / hz) : 0;
+  sensor->next_us = now;
+}
+
+/*!
+ * @brief Publish a snapshot to the sensor's seqlock slot
+ * @param id Sensor id
+ * @param snapshot The snapshot
+ */
+void Adafruit_STHS34PF80_Gateway::publish(
+    int id, const sths34pf80_snapshot_t& snapshot) {
+  Slot* slot = &_slots[id];
+  uint32_t words[STHS34PF80_GATEWAY_SLOT_WORDS] = {0};
+  memcpy(words, &snapshot, sizeof(snapshot));
+
+  uint32_t seq = slot->seq.load(std::memory_order_relaxed);
+  slot->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t w = 0; w < STHS34PF80_GATEWAY_SLOT_WORDS; w++) {
+    slot->words[w].store(words[w], std::memory_order_relaxed);
+  }
+  slot->seq.store(seq + 2, std::memory_order_release);
+}
+
+/*!
+ * @brief Get the gateway time
+ * @return Microseconds since start()
+ */
+uint64_t Adafruit_STHS34PF80_Gateway::nowMicros() {
+  uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count();
+  return us - _start_us;
+}
+
+#endif // __linux__
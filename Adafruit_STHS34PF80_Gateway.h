@@ -0,0 +1,180 @@
+/*!
+ * @file Adafruit_STHS34PF80_Gateway.h
+ *
+ * Thread-safe access to many STHS34PF80 sensors from Linux hosts.
+ *
+ * Each I2C bus gets one worker thread that owns every transaction on that
+ * bus: it polls its sensors for new data at their output data rate and
+ * executes requests from client threads (setters, profile changes, any
+ * custom call) between polls, so read-modify-write cycles never interleave.
+ * Requests travel through a bounded lock-free queue per bus; samples are
+ * published in per-sensor seqlock slots that clients read without locks.
+ *
+ * Usage:
+ *
+ *   Adafruit_STHS34PF80_Gateway gateway;
+ *   int bus = gateway.addBus();
+ *   int id = gateway.addSensor(bus, &sths); // sths.begin() already done
+ *   gateway.start();
+ *   ...
+ *   sths34pf80_snapshot_t snap;
+ *   if (gateway.latest(id, &snap)) { ... }
+ *   gateway.setOutputDataRate(id, STHS34PF80_ODR_4_HZ);
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_GATEWAY_H__
+#define __ADAFRUIT_STHS34PF80_GATEWAY_H__
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Adafruit_STHS34PF80.h"
+
+#define STHS34PF80_GATEWAY_QUEUE_DEPTH 64 ///< Default requests per bus queue
+#define STHS34PF80_GATEWAY_IDLE_US 1000   ///< Default longest worker sleep
+#define STHS34PF80_GATEWAY_READ_TRIES 4   ///< Seqlock retries in latest()
+#define STHS34PF80_GATEWAY_SLOT_WORDS \
+  ((sizeof(sths34pf80_snapshot_t) + 3) / 4) ///< 32-bit words per snapshot
+
+/*!
+ * @brief Latest sample of one sensor, as published by its bus worker
+ */
+typedef struct {
+  sths34pf80_sample_t sample; ///< The sample
+  uint64_t timestamp_us;      ///< Read time, microseconds since start()
+  uint32_t count;             ///< Samples published so far, 0 if none
+} sths34pf80_snapshot_t;
+
+/*!
+ * @brief Outcome of one poll step
+ */
+typedef enum {
+  STHS34PF80_POLL_ERROR = 0,     ///< Bus error, retried a period later
+  STHS34PF80_POLL_NOT_READY = 1, ///< No new data, retried sooner
+  STHS34PF80_POLL_SAMPLE = 2,    ///< A new sample was read
+} sths34pf80_poll_t;
+
+/*!
+ * @brief Custom operation run by a bus worker with exclusive bus access
+ */
+typedef bool (*sths34pf80_gateway_fn_t)(Adafruit_STHS34PF80* sensor,
+                                        void* context);
+
+/*!
+ * @brief Class that shares STHS34PF80 sensors between threads, with one
+ * worker thread per I2C bus
+ */
+class Adafruit_STHS34PF80_Gateway {
+ public:
+  explicit Adafruit_STHS34PF80_Gateway(
+      size_t queue_depth = STHS34PF80_GATEWAY_QUEUE_DEPTH);
+  ~Adafruit_STHS34PF80_Gateway();
+
+  int addBus();
+  int addSensor(int bus, Adafruit_STHS34PF80* sensor);
+  void setIdleMicros(uint32_t idle_us);
+
+  bool start();
+  void stop();
+  bool running();
+
+  bool latest(int id, sths34pf80_snapshot_t* snapshot);
+  uint32_t sampleCount(int id);
+
+  bool call(int id, sths34pf80_gateway_fn_t fn, void* context);
+  bool setOutputDataRate(int id, sths34pf80_odr_t odr);
+  bool applyProfile(int id, const sths34pf80_profile_t& profile);
+
+  uint32_t busErrors(int bus);
+  uint32_t busRequests(int bus);
+
+  static sths34pf80_poll_t pollSensor(Adafruit_STHS34PF80* sensor,
+                                      uint64_t period_us, uint64_t now,
+                                      uint64_t* next_us,
+                                      sths34pf80_sample_t* sample);
+
+ private:
+  /// One client request, owned by the calling thread until done is set
+  struct Request {
+    int id;
+    sths34pf80_gateway_fn_t fn;
+    void* context;
+    bool result;
+    std::atomic<bool> done;
+  };
+
+  /// Bounded multi-producer queue of request pointers (Vyukov ring)
+  class Queue {
+   public:
+    explicit Queue(size_t depth);
+    bool push(Request* request);
+    bool pop(Request** request);
+
+   private:
+    struct Cell {
+      std::atomic<size_t> sequence;
+      Request* request;
+    };
+    std::unique_ptr<Cell[]> _cells;
+    size_t _mask;
+    std::atomic<size_t> _tail; // producers
+    char _pad[64];             // keeps producers and consumer apart
+    std::atomic<size_t> _head; // consumer
+  };
+
+  /// Per-sensor seqlock slot, padded so neighbours do not share a line
+  struct Slot {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> words[STHS34PF80_GATEWAY_SLOT_WORDS];
+    char pad[64 - (4 + 4 * STHS34PF80_GATEWAY_SLOT_WORDS) % 64];
+  };
+
+  /// Worker-private polling state of one sensor
+  struct Sensor {
+    Adafruit_STHS34PF80* dev;
+    int bus;
+    uint64_t period_us;
+    uint64_t next_us;
+    uint32_t count;
+  };
+
+  /// Worker-owned state of one bus
+  struct Bus {
+    explicit Bus(size_t depth) : queue(depth), errors(0), requests(0) {}
+    Queue queue;
+    std::vector<int> sensors;
+    std::atomic<uint32_t> errors;
+    std::atomic<uint32_t> requests;
+  };
+
+  void worker(int bus);
+  void poll(Bus* bus, int id, uint64_t now);
+  void schedule(Sensor* sensor, uint64_t now);
+  void publish(int id, const sths34pf80_snapshot_t& snapshot);
+  uint64_t nowMicros();
+
+  std::vector<std::unique_ptr<Bus> > _buses;
+  std::vector<Sensor> _sensors;
+  std::unique_ptr<Slot[]> _slots;
+  std::vector<std::thread> _threads;
+  std::atomic<bool> _running;
+  std::atomic<uint32_t> _inflight;
+  size_t _queue_depth;
+  uint32_t _idle_us;
+  uint64_t _start_us;
+};
+
+#endif // __linux__
+
+#endif
@@ -0,0 +1,261 @@
+/*!
+ * @file Adafruit_STHS34PF80_Health.cpp
+ *
+ * Streaming health monitor for the STHS34PF80.
+ *
+ * Per sample: a run-length counter for repeated TOBJECT values, a limit
+ * check on TOBJECT/TOBJ_COMP, a Q4 exponential average of the absolute
+ * first difference for the noise (for Gaussian noise sigma is 0.886 times
+ * the mean absolute difference), the gap since the previous sample against
+ * the ODR period, and a range and step check on TAMBIENT. Each difference
+ * is clamped to twice the noise limit, so a single step (someone walking
+ * in) cannot raise the average past the limit on its own.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_Health.h"
+
+#include "Adafruit_STHS34PF80_Model.h"
+
+#define STHS34PF80_HEALTH_Q 4              ///< Fractional bits of the noise
+#define STHS34PF80_HEALTH_NOISE_SHIFT 4    ///< Noise average step 2^-4
+#define STHS34PF80_HEALTH_MAD_TO_SIGMA 227 ///< 0.886 in Q8
+#define STHS34PF80_HEALTH_NOISE_FACTOR 4   ///< Default limit, x model noise
+
+/*!
+ * @brief Instantiates a monitor for the driver defaults (1 Hz, AVG_TMOS
+ * 32), flagging 16 repeats, 3 missed periods, and an ambient outside
+ * -40..85 degC or moving over 2 degC per sample
+ */
+Adafruit_STHS34PF80_Health::Adafruit_STHS34PF80_Health()
+    : _stuck_samples(16),
+      _ambient_step(200),
+      _ambient_min(-4000),
+      _ambient_max(8500),
+      _slack(3) {
+  configure(STHS34PF80_ODR_1_HZ, STHS34PF80_AVG_TMOS_32);
+}
+
+/*!
+ * @brief Set the expected cadence and noise, and start over
+ * @param odr Output data rate
+ * @param avg_tmos Object temperature averaging
+ */
+void Adafruit_STHS34PF80_Health::configure(sths34pf80_odr_t odr,
+                                           sths34pf80_avg_tmos_t avg_tmos) {
+  // Any 1xxx code runs at 30 Hz
+  float hz = Adafruit_STHS34PF80_Model::odrHz(
+      (odr & 0x08) ? STHS34PF80_ODR_30_HZ : odr);
+  _period_ms = hz > 0 ? (uint16_t)(1000.0f / hz + 0.5f) : 0;
+  _noise_limit = STHS34PF80_HEALTH_NOISE_FACTOR *
+                 Adafruit_STHS34PF80_Model::noiseLsb(avg_tmos);
+  reset();
+}
+
+/*!
+ * @brief Configure from the sensor's current ODR and averaging
+ * @param sensor The sensor
+ * @return False without a sensor
+ */
+bool Adafruit_STHS34PF80_Health::configure(Adafruit_STHS34PF80* sensor) {
+  if (!sensor) {
+    return false;
+  }
+  configure(sensor->getOutputDataRate(), sensor->getObjAveraging());
+  return true;
+}
+
+/*!
+ * @brief Set how many identical TOBJECT values in a row count as stuck
+ * @param samples Run length (default 16), 0 to disable
+ */
+void Adafruit_STHS34PF80_Health::setStuckSamples(uint16_t samples) {
+  _stuck_samples = samples;
+}
+
+/*!
+ * @brief Override the noise limit set by configure()
+ * @param sigma_lsb Largest acceptable RMS noise in LSB, 0 to disable
+ */
+void Adafruit_STHS34PF80_Health::setNoiseLimit(uint16_t sigma_lsb) {
+  _noise_limit = sigma_lsb;
+}
+
+/*!
+ * @brief Set how late a sample may be
+ * @param periods Largest gap in ODR periods (default 3)
+ */
+void Adafruit_STHS34PF80_Health::setCadenceSlack(uint8_t periods) {
+  _slack = periods ? periods : 1;
+}
+
+/*!
+ * @brief Set the plausible ambient temperature range
+ * @param min_raw Lowest TAMBIENT, 0.01 degC/LSB (default -4000)
+ * @param max_raw Highest TAMBIENT, 0.01 degC/LSB (default 8500)
+ */
+void Adafruit_STHS34PF80_Health::setAmbientRange(int16_t min_raw,
+                                                 int16_t max_raw) {
+  _ambient_min = min_raw;
+  _ambient_max = max_raw;
+}
+
+/*!
+ * @brief Set the largest plausible ambient change between samples
+ * @param max_step_raw Change in 0.01 degC (default 200)
+ */
+void Adafruit_STHS34PF80_Health::setAmbientStep(uint16_t max_step_raw) {
+  _ambient_step = max_step_raw;
+}
+
+/*!
+ * @brief Forget the stream, the findings and the missed sample count
+ */
+void Adafruit_STHS34PF80_Health::reset() {
+  _last_ms = 0;
+  _missed = 0;
+  _mad_q4 = 0;
+  _repeats = 0;
+  _count = 0;
+  _last_object = 0;
+  _last_ambient = 0;
+  _status = STHS34PF80_HEALTH_OK;
+  _latched = STHS34PF80_HEALTH_OK;
+  _armed = false;
+}
+
+/*!
+ * @brief Check one sample, O(1)
+ * @param object Raw object temperature (TOBJECT)
+ * @param obj_comp Raw compensated object temperature (TOBJ_COMP)
+ * @param ambient Raw ambient temperature (0.01 degC/LSB)
+ * @param t_ms Time the sample was read, e.g. from the driver's clock
+ * @return The findings for this sample, sths34pf80_health_t bits
+ */
+uint8_t Adafruit_STHS34PF80_Health::update(int16_t object, int16_t obj_comp,
+                                           int16_t ambient, uint32_t t_ms) {
+  uint8_t status = STHS34PF80_HEALTH_OK;
+
+  if (_armed && _period_ms) {
+    uint32_t gap = t_ms - _last_ms;
+    if (gap > (uint32_t)_period_ms * _slack) {
+      status |= STHS34PF80_HEALTH_CADENCE;
+      _missed += gap / _period_ms - 1;
+    }
+  }
+  _last_ms = t_ms;
+  _armed = true;
+
+  if (object == 32767 || object == -32768 || obj_comp == 32767 ||
+      obj_comp == -32768) {
+    status |= STHS34PF80_HEALTH_SATURATED;
+  }
+  if (ambient < _ambient_min || ambient > _ambient_max) {
+    status |= STHS34PF80_HEALTH_AMBIENT;
+  }
+
+  if (_count) {
+    if (object == _last_object) {
+      if (_repeats < 0xFFFF) {
+        _repeats++;
+      }
+    } else {
+      _repeats = 1;
+    }
+
+    int32_t diff = (int32_t)object - _last_object;
+    diff = diff < 0 ? -diff : diff;
+    if (_noise_limit && diff > 2 * (int32_t)_noise_limit) {
+      diff = 2 * (int32_t)_noise_limit;
+    }
+    _mad_q4 += ((diff << STHS34PF80_HEALTH_Q) - _mad_q4) >>
+               STHS34PF80_HEALTH_NOISE_SHIFT;
+
+    int32_t step = (int32_t)ambient - _last_ambient;
+    if ((step < 0 ? -step : step) > _ambient_step) {
+      status |= STHS34PF80_HEALTH_AMBIENT;
+    }
+  } else {
+    _repeats = 1;
+  }
+  if (_count < 0xFFFF) {
+    _count++;
+  }
+  _last_object = object;
+  _last_ambient = ambient;
+
+  if (_stuck_samples && _repeats >= _stuck_samples) {
+    status |= STHS34PF80_HEALTH_STUCK;
+  }
+  // The average needs about 2^shift differences to settle
+  if (_noise_limit && _count > (1 << STHS34PF80_HEALTH_NOISE_SHIFT) &&
+      noise() > _noise_limit) {
+    status |= STHS34PF80_HEALTH_NOISY;
+  }
+
+  _status = status;
+  _latched |= status;
+  return status;
+}
+
+/*!
+ * @brief Check one sample read with readSample(), O(1)
+ * @param sample The sample
+ * @param t_ms Time the sample was read, e.g. from the driver's clock
+ * @return The findings for this sample, sths34pf80_health_t bits
+ */
+uint8_t Adafruit_STHS34PF80_Health::update(const sths34pf80_sample_t& sample,
+                                           uint32_t t_ms) {
+  return update(sample.object, sample.obj_comp, sample.ambient, t_ms);
+}
+
+/*!
+ * @brief Check for overdue samples between updates, e.g. from a periodic
+ * task; the first call (or update()) starts the cadence check
+ * @param t_ms Current time
+ * @return The current findings, sths34pf80_health_t bits
+ */
+uint8_t Adafruit_STHS34PF80_Health::check(uint32_t t_ms) {
+  if (!_armed) {
+    _last_ms = t_ms;
+    _armed = true;
+  } else if (_period_ms && t_ms - _last_ms > (uint32_t)_period_ms * _slack) {
+    _status |= STHS34PF80_HEALTH_CADENCE;
+    _latched |= STHS34PF80_HEALTH_CADENCE;
+  }
+  return _status;
+}
+
+/*!
+ * @brief Get the findings of the last sample or check()
+ * @return sths34pf80_health_t bits
+ */
+uint8_t Adafruit_STHS34PF80_Health::status() { return _status; }
+
+/*!
+ * @brief Get every finding since reset() or clearLatched()
+ * @return sths34pf80_health_t bits
+ */
+uint8_t Adafruit_STHS34PF80_Health::latched() { return _latched; }
+
+/*!
+ * @brief Clear the latched findings, down to the current ones
+ */
+void Adafruit_STHS34PF80_Health::clearLatched() { _latched = _status; }
+
+/*!
+ * @brief Get the noise estimate
+ * @return RMS TOBJECT noise in LSB
+ */
+uint16_t Adafruit_STHS34PF80_Health::noise() {
+  return (uint16_t)((_mad_q4 * STHS34PF80_HEALTH_MAD_TO_SIGMA) >>
+                    (STHS34PF80_HEALTH_Q + 8));
+}
+
+/*!
+ * @brief Get the estimated number of samples lost to late reads
+ * @return Missed samples since reset()
+ */
+uint32_t Adafruit_STHS34PF80_Health::missedSamples() { return _missed; }
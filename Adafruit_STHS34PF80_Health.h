@@ -0,0 +1,87 @@
+/*!
+ * @file Adafruit_STHS34PF80_Health.h
+ *
+ * Streaming health monitor for the STHS34PF80 sample stream: stuck,
+ * saturated or noisy object channel, broken DRDY cadence and implausible
+ * ambient temperature.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_HEALTH_H__
+#define __ADAFRUIT_STHS34PF80_HEALTH_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+/*!
+ * @brief Health findings, one bit each
+ */
+typedef enum {
+  STHS34PF80_HEALTH_OK = 0x00,        ///< Nothing found
+  STHS34PF80_HEALTH_STUCK = 0x01,     ///< TOBJECT repeats the same value
+  STHS34PF80_HEALTH_SATURATED = 0x02, ///< TOBJECT or TOBJ_COMP at a limit
+  STHS34PF80_HEALTH_NOISY = 0x04,     ///< Noise far above the averaging's
+  STHS34PF80_HEALTH_CADENCE = 0x08,   ///< Samples late or missing for the ODR
+  STHS34PF80_HEALTH_AMBIENT = 0x10,   ///< Ambient out of range or jumping
+} sths34pf80_health_t;
+
+/*!
+ * @brief Class that checks every sample in O(1) time and fixed memory,
+ * with integer math only
+ *
+ * Noise is the average absolute difference between consecutive TOBJECT
+ * values, which ignores slow drift and holds a person's step for only a
+ * few samples; it is compared with Adafruit_STHS34PF80_Model::noiseLsb()
+ * for the configured averaging. Findings are current (status()) and
+ * latched until clearLatched() (latched()).
+ */
+class Adafruit_STHS34PF80_Health {
+ public:
+  Adafruit_STHS34PF80_Health();
+
+  void configure(sths34pf80_odr_t odr, sths34pf80_avg_tmos_t avg_tmos);
+  bool configure(Adafruit_STHS34PF80* sensor);
+  void setStuckSamples(uint16_t samples);
+  void setNoiseLimit(uint16_t sigma_lsb);
+  void setCadenceSlack(uint8_t periods);
+  void setAmbientRange(int16_t min_raw, int16_t max_raw);
+  void setAmbientStep(uint16_t max_step_raw);
+
+  void reset();
+  uint8_t update(int16_t object, int16_t obj_comp, int16_t ambient,
+                 uint32_t t_ms);
+  uint8_t update(const sths34pf80_sample_t& sample, uint32_t t_ms);
+  uint8_t check(uint32_t t_ms);
+
+  uint8_t status();
+  uint8_t latched();
+  void clearLatched();
+  uint16_t noise();
+  uint32_t missedSamples();
+
+ private:
+  uint32_t _last_ms;
+  uint32_t _missed;
+  int32_t _mad_q4;
+  uint16_t _period_ms;
+  uint16_t _stuck_samples;
+  uint16_t _repeats;
+  uint16_t _count;
+  uint16_t _noise_limit;
+  uint16_t _ambient_step;
+  int16_t _ambient_min;
+  int16_t _ambient_max;
+  int16_t _last_object;
+  int16_t _last_ambient;
+  uint8_t _slack;
+  uint8_t _status;
+  uint8_t _latched;
+  bool _armed;
+};
+
+#endif
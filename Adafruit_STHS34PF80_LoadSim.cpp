@@ -0,0 +1,419 @@
+/*!
+ * @file Adafruit_STHS34PF80_LoadSim.cpp
+ *
+ * Fleet-scale load simulator for planning STHS34PF80 gateway capacity on
+ * Linux hosts.
+ *
+ * Buses are independent, so they run one after the other, each on its own
+ * simulated clock: the driver's waits and every transfer move that clock,
+ * and the worker loop jumps it to the next due sensor. A transfer takes
+ * its bits at the SCL frequency plus the configured overhead: a register
+ * read is (3 + n) * 9 + 3 bits, a register write (2 + n) * 9 + 2, the same
+ * counts as the driver's bus accounting. Sensor phases are random within
+ * one period, and nothing is measured during a warm-up.
+ *
+ * Sample loss compares the conversions of the measured window with the
+ * samples read in it, so windows should span many periods.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_LoadSim.h"
+
+#if defined(__linux__)
+
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "Adafruit_STHS34PF80_Gateway.h"
+#include "Adafruit_STHS34PF80_Model.h"
+
+/*!
+ * @brief Creates a simulated sensor on a bus clock, with a timed device
+ * @param clock The bus clock
+ */
+Adafruit_STHS34PF80_LoadSim::Node::Node(Adafruit_STHS34PF80_Clock* clock)
+    : sim(clock),
+      device(this, busRead, busWrite, busReadRegister, busWriteRegister),
+      bus(NULL),
+      next_us(0) {}
+
+/*!
+ * @brief Instantiates a load simulator
+ */
+Adafruit_STHS34PF80_LoadSim::Adafruit_STHS34PF80_LoadSim() : _samples(0) {}
+
+/*!
+ * @brief Fill in a scenario: one bus of 8 sensors at 400 kHz and 8 Hz,
+ * 10 seconds measured
+ * @param config The scenario
+ */
+void Adafruit_STHS34PF80_LoadSim::defaults(sths34pf80_load_config_t* config) {
+  config->buses = 1;
+  config->sensors_per_bus = 8;
+  config->bus_hz = 400000;
+  config->overhead_us = STHS34PF80_LOADSIM_OVERHEAD_US;
+  config->kernel_us = STHS34PF80_LOADSIM_KERNEL_US;
+  config->odr = STHS34PF80_ODR_8_HZ;
+  config->duration_ms = 10000;
+  config->seed = 1;
+}
+
+/*!
+ * @brief Simulate a scenario
+ * @param config The scenario
+ * @param result Filled in with the measurements
+ * @return False for an empty scenario, a zero bus speed or power-down
+ */
+bool Adafruit_STHS34PF80_LoadSim::run(const sths34pf80_load_config_t& config,
+                                      sths34pf80_load_result_t* result) {
+  float hz = Adafruit_STHS34PF80_Model::odrHz(config.odr);
+  if (!result || !config.buses || !config.sensors_per_bus || !config.bus_hz ||
+      !config.duration_ms || hz <= 0) {
+    return false;
+  }
+  uint64_t period_us = (uint64_t)(1000000.0f / hz);
+  uint64_t window_us = (uint64_t)config.duration_ms * 1000;
+
+  memset(result, 0, sizeof(*result));
+  _latencies.clear();
+  _latencies.reserve((size_t)(config.buses * config.sensors_per_bus *
+                              (window_us / period_us + 1)));
+  _samples = 0;
+
+  uint64_t wall_start = monotonicNanos();
+  uint64_t cpu_ns = 0;
+  uint64_t model_ns = 0;
+  double utilisation = 0;
+  double elapsed_s = 0;
+  uint32_t rng = config.seed ? config.seed : 1;
+
+  for (uint32_t b = 0; b < config.buses; b++) {
+    std::unique_ptr<Bus> bus(new Bus());
+    bus->selected = NULL;
+    bus->busy_us = 0;
+    bus->transactions = 0;
+    bus->model_ns = 0;
+    bus->bus_hz = config.bus_hz;
+    bus->overhead_us = config.overhead_us;
+
+    // Power-down first, then start each sensor at a random phase
+    std::vector<uint32_t> phases;
+    for (uint32_t i = 0; i < config.sensors_per_bus; i++) {
+      Node* node = new Node(&bus->clock);
+      bus->nodes.emplace_back(node);
+      node->bus = bus.get();
+      node->sim.setSeed(config.seed * 7919 + b * config.sensors_per_bus + i);
+      node->sths.setClock(&bus->clock);
+      if (!node->sths.begin(&node->device)) {
+        result->failed++;
+      }
+      rng ^= rng << 13;
+      rng ^= rng >> 17;
+      rng ^= rng << 5;
+      phases.push_back(rng % (uint32_t)period_us);
+    }
+    std::sort(phases.begin(), phases.end());
+    // Shuffle, so the worker's scan order does not follow the phases
+    for (uint32_t i = config.sensors_per_bus - 1; i > 0; i--) {
+      rng ^= rng << 13;
+      rng ^= rng >> 17;
+      rng ^= rng << 5;
+      std::swap(bus->nodes[i], bus->nodes[rng % (i + 1)]);
+    }
+    uint64_t start = bus->clock.now();
+    for (uint32_t i = 0; i < config.sensors_per_bus; i++) {
+      Node* node = bus->nodes[i].get();
+      if (bus->clock.now() < start + phases[i]) {
+        bus->clock.set(start + phases[i]);
+      }
+      if (!node->sths.setOutputDataRate(config.odr)) {
+        result->failed++;
+      }
+      node->next_us = bus->clock.now();
+    }
+
+    runBus(bus.get(),
+           bus->clock.now() + STHS34PF80_LOADSIM_WARMUP_MS * 1000ULL,
+           period_us, false);
+
+    uint64_t before = 0;
+    for (size_t i = 0; i < bus->nodes.size(); i++) {
+      before += bus->nodes[i]->sim.conversions();
+    }
+    bus->busy_us = 0;
+    bus->transactions = 0;
+    bus->model_ns = 0;
+
+    uint64_t cpu_start = cpuNanos();
+    uint64_t window_start = bus->clock.now();
+    runBus(bus.get(), window_start + window_us, period_us, true);
+    cpu_ns += cpuNanos() - cpu_start;
+    // The last worker pass may run past the end of the window
+    uint64_t elapsed_us = bus->clock.now() - window_start;
+    elapsed_s += elapsed_us / 1e6;
+
+    uint64_t after = 0;
+    for (size_t i = 0; i < bus->nodes.size(); i++) {
+      after += bus->nodes[i]->sim.conversions();
+    }
+    result->conversions += after - before;
+    result->transactions += bus->transactions;
+    model_ns += bus->model_ns;
+
+    float busy = (float)bus->busy_us / elapsed_us;
+    utilisation += busy;
+    if (busy > result->peak_utilisation) {
+      result->peak_utilisation = busy;
+    }
+  }
+
+  result->sensors = config.buses * config.sensors_per_bus;
+  result->samples = _samples;
+  result->loss =
+      result->conversions > result->samples
+          ? (float)(result->conversions - result->samples) / result->conversions
+          : 0;
+  result->utilisation = (float)(utilisation / config.buses);
+
+  if (!_latencies.empty()) {
+    std::sort(_latencies.begin(), _latencies.end());
+    size_t count = _latencies.size();
+    result->latency_p50_us = _latencies[(count * 50 + 99) / 100 - 1];
+    result->latency_p90_us = _latencies[(count * 90 + 99) / 100 - 1];
+    result->latency_p99_us = _latencies[(count * 99 + 99) / 100 - 1];
+    result->latency_max_us = _latencies[count - 1];
+  }
+
+  // The simulated sensors' own time is not the gateway's
+  double host_us = (cpu_ns > model_ns ? cpu_ns - model_ns : 0) / 1000.0 +
+                   (double)result->transactions * config.kernel_us;
+  result->cpu_us_per_sensor_s =
+      (float)(host_us / config.sensors_per_bus / elapsed_s);
+  result->wall_s = (monotonicNanos() - wall_start) / 1e9f;
+  return true;
+}
+
+/*!
+ * @brief Find the most sensors one bus carries within the limits, by
+ * doubling then bisecting the sensor count
+ * @param config The scenario; buses and sensors_per_bus are ignored
+ * @param max_loss Largest acceptable fraction of lost samples
+ * @param max_latency_us Largest acceptable 99th percentile latency
+ * @param limit Largest sensor count to try, at most the mux limit
+ * (STHS34PF80_LOADSIM_MUX_LIMIT)
+ * @return Sensors per bus, 0 if even one sensor misses the limits; a
+ * result equal to the limit means the bus has headroom left
+ */
+uint32_t Adafruit_STHS34PF80_LoadSim::saturation(
+    const sths34pf80_load_config_t& config, float max_loss,
+    uint32_t max_latency_us, uint32_t limit) {
+  sths34pf80_load_config_t trial = config;
+  trial.buses = 1;
+  if (limit > STHS34PF80_LOADSIM_MUX_LIMIT) {
+    limit = STHS34PF80_LOADSIM_MUX_LIMIT;
+  }
+
+  uint32_t good = 0;
+  uint32_t count = 1;
+  while (count <= limit &&
+         passes(&trial, count, max_loss, max_latency_us)) {
+    good = count;
+    count *= 2;
+  }
+  uint32_t bad = count <= limit ? count : limit + 1;
+  while (bad - good > 1) {
+    uint32_t mid = good + (bad - good) / 2;
+    if (passes(&trial, mid, max_loss, max_latency_us)) {
+      good = mid;
+    } else {
+      bad = mid;
+    }
+  }
+  return good;
+}
+
+/*!
+ * @brief Run a scenario with a sensor count and check it against limits
+ * @param trial The scenario, its sensor count is overwritten
+ * @param sensors Sensors per bus
+ * @param max_loss Largest acceptable fraction of lost samples
+ * @param max_latency_us Largest acceptable 99th percentile latency
+ * @return True if every sensor started, both limits hold and the bus is
+ * busy at most STHS34PF80_LOADSIM_MAX_BUSY of the time, leaving room for
+ * requests, retries and clock stretching the simulation does not see
+ */
+bool Adafruit_STHS34PF80_LoadSim::passes(sths34pf80_load_config_t* trial,
+                                         uint32_t sensors, float max_loss,
+                                         uint32_t max_latency_us) {
+  sths34pf80_load_result_t result;
+  trial->sensors_per_bus = sensors;
+  return run(*trial, &result) && !result.failed && result.loss <= max_loss &&
+         result.latency_p99_us <= max_latency_us &&
+         result.peak_utilisation <= STHS34PF80_LOADSIM_MAX_BUSY;
+}
+
+/*!
+ * @brief Run one bus's gateway worker until the given time, as
+ * Adafruit_STHS34PF80_Gateway does: poll each due sensor with the gateway's
+ * own pollSensor(), then sleep to the earliest due time or the idle
+ * interval
+ * @param bus The bus
+ * @param end_us Simulated time to stop at
+ * @param period_us Output period
+ * @param record Count the samples and their latency
+ */
+void Adafruit_STHS34PF80_LoadSim::runBus(Bus* bus, uint64_t end_us,
+                                         uint64_t period_us, bool record) {
+  uint64_t now = bus->clock.now();
+  while (now < end_us) {
+    uint64_t wake = now + STHS34PF80_GATEWAY_IDLE_US;
+    for (size_t i = 0; i < bus->nodes.size(); i++) {
+      Node* node = bus->nodes[i].get();
+      sths34pf80_sample_t sample;
+      if (node->next_us <= now &&
+          Adafruit_STHS34PF80_Gateway::pollSensor(&node->sths, period_us, now,
+                                                  &node->next_us, &sample) ==
+              STHS34PF80_POLL_SAMPLE &&
+          record) {
+        _latencies.push_back(node->sim.sampleAgeMicros());
+        _samples++;
+      }
+      if (node->next_us < wake) {
+        wake = node->next_us;
+      }
+    }
+
+    now = bus->clock.now();
+    if (wake > now) {
+      bus->clock.set(wake);
+      now = wake;
+    }
+  }
+}
+
+/*!
+ * @brief Hold the bus for one transfer, selecting the sensor's mux channel
+ * first when another sensor was addressed last
+ * @param node The sensor
+ * @param bits Bits on the wire, ACKs and start/stop included
+ */
+void Adafruit_STHS34PF80_LoadSim::transfer(Node* node, uint32_t bits) {
+  Bus* bus = node->bus;
+  uint64_t us = 0;
+  if (bus->nodes.size() > 1 && bus->selected != node) {
+    us += (STHS34PF80_LOADSIM_MUX_BITS * 1000000ULL + bus->bus_hz - 1) /
+              bus->bus_hz +
+          bus->overhead_us;
+    bus->transactions++;
+    bus->selected = node;
+  }
+  us += (bits * 1000000ULL + bus->bus_hz - 1) / bus->bus_hz + bus->overhead_us;
+  bus->transactions++;
+  bus->busy_us += us;
+  bus->clock.advance(us);
+}
+
+/*!
+ * @brief Timed raw read
+ * @param obj The sensor's Node
+ * @param buffer Destination
+ * @param len Bytes
+ * @return The simulated sensor's result
+ */
+bool Adafruit_STHS34PF80_LoadSim::busRead(void* obj, uint8_t* buffer,
+                                          size_t len) {
+  Node* node = (Node*)obj;
+  transfer(node, (1 + len) * 9 + 2);
+  uint64_t start = monotonicNanos();
+  bool ok = node->sim.device()->read(buffer, len);
+  node->bus->model_ns += monotonicNanos() - start;
+  return ok;
+}
+
+/*!
+ * @brief Timed raw write
+ * @param obj The sensor's Node
+ * @param buffer Bytes to write
+ * @param len Bytes
+ * @return The simulated sensor's result
+ */
+bool Adafruit_STHS34PF80_LoadSim::busWrite(void* obj, const uint8_t* buffer,
+                                           size_t len) {
+  Node* node = (Node*)obj;
+  transfer(node, (1 + len) * 9 + 2);
+  uint64_t start = monotonicNanos();
+  bool ok = node->sim.device()->write(buffer, len);
+  node->bus->model_ns += monotonicNanos() - start;
+  return ok;
+}
+
+/*!
+ * @brief Timed register read: write the address, repeated start, read
+ * @param obj The sensor's Node
+ * @param addr_buf Register address
+ * @param addrsiz Address bytes
+ * @param data Destination
+ * @param datalen Bytes
+ * @return The simulated sensor's result
+ */
+bool Adafruit_STHS34PF80_LoadSim::busReadRegister(void* obj,
+                                                  uint8_t* addr_buf,
+                                                  uint8_t addrsiz,
+                                                  uint8_t* data,
+                                                  uint16_t datalen) {
+  Node* node = (Node*)obj;
+  transfer(node, (2 + addrsiz + datalen) * 9 + 3);
+  uint64_t start = monotonicNanos();
+  bool ok = node->sim.device()->readRegister(addr_buf, addrsiz, data, datalen);
+  node->bus->model_ns += monotonicNanos() - start;
+  return ok;
+}
+
+/*!
+ * @brief Timed register write
+ * @param obj The sensor's Node
+ * @param addr_buf Register address
+ * @param addrsiz Address bytes
+ * @param data Values
+ * @param datalen Bytes
+ * @return The simulated sensor's result
+ */
+bool Adafruit_STHS34PF80_LoadSim::busWriteRegister(void* obj,
+                                                   uint8_t* addr_buf,
+                                                   uint8_t addrsiz,
+                                                   const uint8_t* data,
+                                                   uint16_t datalen) {
+  Node* node = (Node*)obj;
+  transfer(node, (1 + addrsiz + datalen) * 9 + 2);
+  uint64_t start = monotonicNanos();
+  bool ok =
+      node->sim.device()->writeRegister(addr_buf, addrsiz, data, datalen);
+  node->bus->model_ns += monotonicNanos() - start;
+  return ok;
+}
+
+/*!
+ * @brief Wall-clock time for measuring the simulated sensors
+ * @return Monotonic nanoseconds
+ */
+uint64_t Adafruit_STHS34PF80_LoadSim::monotonicNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*!
+ * @brief CPU time of the calling thread
+ * @return Nanoseconds
+ */
+uint64_t Adafruit_STHS34PF80_LoadSim::cpuNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif // __linux__
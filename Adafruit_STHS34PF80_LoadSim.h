@@ -0,0 +1,146 @@
+/*!
+ * @file Adafruit_STHS34PF80_LoadSim.h
+ *
+ * Fleet-scale load simulator for planning STHS34PF80 gateway capacity on
+ * Linux hosts.
+ *
+ * Runs many simulated sensors behind simulated I2C buses through the real
+ * driver, on simulated time, and reports bus utilisation, sample loss,
+ * end-to-end latency percentiles and host CPU cost per sensor.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_LOADSIM_H__
+#define __ADAFRUIT_STHS34PF80_LOADSIM_H__
+
+#if defined(__linux__)
+
+#include <memory>
+#include <vector>
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Sim.h"
+
+#define STHS34PF80_LOADSIM_OVERHEAD_US 20 ///< Default bus idle per transfer
+#define STHS34PF80_LOADSIM_KERNEL_US 5    ///< Default host CPU per transfer
+#define STHS34PF80_LOADSIM_WARMUP_MS 2000 ///< Simulated time before measuring
+#define STHS34PF80_LOADSIM_MUX_BITS 20    ///< Mux channel select, 1-byte write
+#define STHS34PF80_LOADSIM_MUX_LIMIT 64   ///< Sensors a TCA9548A tree reaches
+#define STHS34PF80_LOADSIM_MAX_BUSY 0.8f  ///< Bus utilisation ceiling
+
+/*!
+ * @brief One load scenario
+ */
+typedef struct {
+  uint32_t buses;           ///< Buses, one gateway worker each
+  uint32_t sensors_per_bus; ///< Sensors on each bus
+  uint32_t bus_hz;          ///< SCL frequency
+  uint16_t overhead_us;     ///< Bus idle time per transfer (driver, IRQs)
+  uint16_t kernel_us;       ///< Host CPU per transfer in the kernel
+  sths34pf80_odr_t odr;     ///< Output data rate of every sensor
+  uint32_t duration_ms;     ///< Measured simulated time, after a warm-up
+  uint32_t seed;            ///< Sensor phases and noise
+} sths34pf80_load_config_t;
+
+/*!
+ * @brief Results of one load scenario
+ */
+typedef struct {
+  uint32_t sensors;          ///< Sensors simulated
+  uint32_t failed;           ///< Sensors that failed to start
+  uint64_t conversions;      ///< Samples the sensors produced
+  uint64_t samples;          ///< Samples the gateway read
+  uint64_t transactions;     ///< Bus transfers, mux selects included
+  float loss;                ///< Fraction of the samples never read
+  float utilisation;         ///< Mean fraction of time a bus is busy
+  float peak_utilisation;    ///< Busiest bus
+  uint32_t latency_p50_us;   ///< Conversion to sample read, median
+  uint32_t latency_p90_us;   ///< 90th percentile
+  uint32_t latency_p99_us;   ///< 99th percentile
+  uint32_t latency_max_us;   ///< Worst sample
+  float cpu_us_per_sensor_s; ///< Host CPU per sensor and second
+  float wall_s;              ///< Wall time the simulation took
+} sths34pf80_load_result_t;
+
+/*!
+ * @brief Class that simulates gateways polling fleets of sensors
+ *
+ * Each bus is simulated on its own clock and polled with
+ * Adafruit_STHS34PF80_Gateway::pollSensor(), the gateway workers' own
+ * step: poll STATUS when a sample is due, read it with readSample() when
+ * DRDY is set, otherwise look again after an eighth of a period. Every
+ * transfer holds the bus for its bits at the SCL frequency plus a fixed
+ * overhead, and all STHS34PF80 share address 0x5A, so sensors on one bus
+ * sit behind I2C muxes (TCA9548A) and switching sensor costs a channel
+ * select. A TCA9548A tree reaches STHS34PF80_LOADSIM_MUX_LIMIT sensors per
+ * bus: run() still simulates larger counts, for the trend, but
+ * saturation() never reports more.
+ *
+ * Host CPU is the measured driver and scheduling time, with the simulated
+ * sensors' own time taken out, plus the configured kernel time per
+ * transfer. Latency runs from the conversion to the end of its read.
+ * Sensor clocks run at exactly the nominal ODR.
+ */
+class Adafruit_STHS34PF80_LoadSim {
+ public:
+  Adafruit_STHS34PF80_LoadSim();
+
+  static void defaults(sths34pf80_load_config_t* config);
+  bool run(const sths34pf80_load_config_t& config,
+           sths34pf80_load_result_t* result);
+  uint32_t saturation(const sths34pf80_load_config_t& config, float max_loss,
+                      uint32_t max_latency_us,
+                      uint32_t limit = STHS34PF80_LOADSIM_MUX_LIMIT);
+
+ private:
+  struct Bus;
+
+  /// One simulated sensor, its timed bus device and its driver
+  struct Node {
+    explicit Node(Adafruit_STHS34PF80_Clock* clock);
+    Adafruit_STHS34PF80_Sim sim;
+    Adafruit_GenericDevice device;
+    Adafruit_STHS34PF80 sths;
+    Bus* bus;
+    uint64_t next_us;
+  };
+
+  /// One simulated bus and its worker's clock
+  struct Bus {
+    Adafruit_STHS34PF80_SimClock clock;
+    std::vector<std::unique_ptr<Node> > nodes;
+    Node* selected;
+    uint64_t busy_us;
+    uint64_t transactions;
+    uint64_t model_ns;
+    uint32_t bus_hz;
+    uint16_t overhead_us;
+  };
+
+  static bool busRead(void* obj, uint8_t* buffer, size_t len);
+  static bool busWrite(void* obj, const uint8_t* buffer, size_t len);
+  static bool busReadRegister(void* obj, uint8_t* addr_buf, uint8_t addrsiz,
+                              uint8_t* data, uint16_t datalen);
+  static bool busWriteRegister(void* obj, uint8_t* addr_buf, uint8_t addrsiz,
+                               const uint8_t* data, uint16_t datalen);
+  static void transfer(Node* node, uint32_t bits);
+  static uint64_t monotonicNanos();
+  static uint64_t cpuNanos();
+
+  void runBus(Bus* bus, uint64_t end_us, uint64_t period_us, bool record);
+  bool passes(sths34pf80_load_config_t* trial, uint32_t sensors,
+              float max_loss, uint32_t max_latency_us);
+
+  std::vector<uint32_t> _latencies;
+  uint64_t _samples;
+};
+
+#endif // __linux__
+
+#endif
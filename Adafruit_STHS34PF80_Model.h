@@ -0,0 +1,622 @@
+/*!
+ * @file Adafruit_STHS34PF80_Model.h
+ *
+ * Configuration validator and timing/power model for the STHS34PF80.
+ *
+ * Everything except lowestPowerConfig() is constexpr, so a configuration
+ * can be checked with static_assert as well as at runtime.
+ *
+ * The low-pass filters are modelled as first-order sections with a cutoff
+ * of ODR/N, arranged as in Adafruit_STHS34PF80_Sim: presence is LPF_P
+ * after LPF_P_M, motion is LPF_M minus LPF_P_M. Object conversion time
+ * and supply current are fitted to the datasheet ODR ceilings and the
+ * 10 uA @ 1 Hz (AVG_TMOS 128) figure, and the object noise is a fit
+ * shared with Adafruit_STHS34PF80_Sim; they are estimates meant for
+ * comparing configurations, not guarantees.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_MODEL_H__
+#define __ADAFRUIT_STHS34PF80_MODEL_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+#define STHS34PF80_MODEL_TMOS_SAMPLE_S \
+  0.0009f ///< Modelled time per averaged TMOS sample, seconds
+#define STHS34PF80_MODEL_STANDBY_UA \
+  2.0f ///< Modelled supply current between conversions, uA
+#define STHS34PF80_MODEL_ACTIVE_UA \
+  70.0f ///< Modelled extra supply current while converting, uA
+#define STHS34PF80_MODEL_TWO_PI 6.2831853f ///< 2 * pi
+#define STHS34PF80_MODEL_LN20 2.9957323f   ///< ln(20), 95% settling
+#define STHS34PF80_MODEL_EXP_SERIES 0.01f  ///< expNeg() series range
+#define STHS34PF80_MODEL_SEARCH_STEPS 20   ///< Bisection steps per search
+#define STHS34PF80_MODEL_SEARCH_SPAN 64.0f ///< Search span, slowest taus
+#define STHS34PF80_MODEL_NEVER_S \
+  3.4e38f ///< Latency of a path that cannot respond
+#define STHS34PF80_SENS_BASE_LSB \
+  2048.0f ///< Sensitivity coded by SENS_DATA 0, LSB/degC
+#define STHS34PF80_SENS_STEP_LSB \
+  16.0f ///< Sensitivity step per SENS_DATA LSB, LSB/degC
+
+/*!
+ * @brief Result of validating a configuration
+ */
+typedef enum {
+  STHS34PF80_CONFIG_OK = 0x00,            ///< Configuration is valid
+  STHS34PF80_CONFIG_POWER_DOWN = 0x01,    ///< ODR is power-down
+  STHS34PF80_CONFIG_BAD_ODR = 0x02,       ///< ODR value out of range
+  STHS34PF80_CONFIG_BAD_AVERAGING = 0x03, ///< Averaging value out of range
+  STHS34PF80_CONFIG_BAD_LPF = 0x04,       ///< LPF value out of range
+  STHS34PF80_CONFIG_ODR_TOO_HIGH = 0x05,  ///< ODR above the AVG_TMOS ceiling
+} sths34pf80_config_status_t;
+
+/*!
+ * @brief Timing and power figures of a configuration
+ */
+typedef struct {
+  sths34pf80_config_status_t status; ///< Validation result
+  float motion_cutoff_hz;            ///< LPF_M cutoff
+  float motion_presence_cutoff_hz;   ///< LPF_P_M cutoff
+  float presence_cutoff_hz;          ///< LPF_P cutoff
+  float ambient_shock_cutoff_hz;     ///< LPF_A_T cutoff
+  float conversion_s;                ///< Object conversion time per sample
+  float presence_settling_s;         ///< Presence 95% step settling time
+  float motion_settling_s;           ///< Motion 95% step settling time
+  float presence_latency_s;          ///< Worst-case presence detection latency
+  float motion_latency_s;            ///< Worst-case motion detection latency
+  float supply_ua;                   ///< Average sensor supply current
+} sths34pf80_config_report_t;
+
+/*!
+ * @brief Pure model of STHS34PF80 configurations
+ */
+class Adafruit_STHS34PF80_Model {
+ public:
+  /*!
+   * @brief Output data rate in Hz
+   * @param odr The output data rate value
+   * @return Samples per second, 0 for power-down
+   */
+  static constexpr float odrHz(sths34pf80_odr_t odr) {
+    return odr == STHS34PF80_ODR_0_25_HZ  ? 0.25f
+           : odr == STHS34PF80_ODR_0_5_HZ ? 0.5f
+           : odr == STHS34PF80_ODR_1_HZ   ? 1.0f
+           : odr == STHS34PF80_ODR_2_HZ   ? 2.0f
+           : odr == STHS34PF80_ODR_4_HZ   ? 4.0f
+           : odr == STHS34PF80_ODR_8_HZ   ? 8.0f
+           : odr == STHS34PF80_ODR_15_HZ  ? 15.0f
+           : odr == STHS34PF80_ODR_30_HZ  ? 30.0f
+                                          : 0.0f;
+  }
+
+  /*!
+   * @brief Highest output data rate for an object averaging setting, same
+   * table as Adafruit_STHS34PF80::maxOutputDataRate()
+   * @param avg_tmos The object temperature averaging value
+   * @return The maximum output data rate
+   */
+  static constexpr sths34pf80_odr_t maxOdr(sths34pf80_avg_tmos_t avg_tmos) {
+    return avg_tmos == STHS34PF80_AVG_TMOS_128    ? STHS34PF80_ODR_8_HZ
+           : avg_tmos == STHS34PF80_AVG_TMOS_256  ? STHS34PF80_ODR_4_HZ
+           : avg_tmos == STHS34PF80_AVG_TMOS_512  ? STHS34PF80_ODR_2_HZ
+           : avg_tmos == STHS34PF80_AVG_TMOS_1024 ? STHS34PF80_ODR_1_HZ
+           : avg_tmos == STHS34PF80_AVG_TMOS_2048 ? STHS34PF80_ODR_0_5_HZ
+                                                  : STHS34PF80_ODR_30_HZ;
+  }
+
+  /*!
+   * @brief Number of object samples averaged per output
+   * @param avg_tmos The object temperature averaging value
+   * @return Samples per output (2 to 2048)
+   */
+  static constexpr uint16_t objSamples(sths34pf80_avg_tmos_t avg_tmos) {
+    return avg_tmos <= STHS34PF80_AVG_TMOS_128 ? 2 << (2 * avg_tmos)
+                                               : 1 << (avg_tmos + 4);
+  }
+
+  /*!
+   * @brief Modelled TOBJECT noise, 150 / sqrt(samples) + 5 LSB rounded
+   * @param avg_tmos The object temperature averaging value
+   * @return RMS noise in LSB
+   */
+  static constexpr uint8_t noiseLsb(sths34pf80_avg_tmos_t avg_tmos) {
+    return avg_tmos == STHS34PF80_AVG_TMOS_2      ? 111
+           : avg_tmos == STHS34PF80_AVG_TMOS_8    ? 58
+           : avg_tmos == STHS34PF80_AVG_TMOS_32   ? 32
+           : avg_tmos == STHS34PF80_AVG_TMOS_128  ? 18
+           : avg_tmos == STHS34PF80_AVG_TMOS_256  ? 14
+           : avg_tmos == STHS34PF80_AVG_TMOS_512  ? 12
+           : avg_tmos == STHS34PF80_AVG_TMOS_1024 ? 10
+                                                  : 8;
+  }
+
+  /*!
+   * @brief Number of ambient samples averaged per output
+   * @param avg_t The ambient temperature averaging value
+   * @return Samples per output (1 to 8)
+   */
+  static constexpr uint8_t ambSamples(sths34pf80_avg_t_t avg_t) {
+    return 8 >> avg_t;
+  }
+
+  /*!
+   * @brief Divider between ODR and filter cutoff
+   * @param lpf The LPF configuration value
+   * @return N of ODR/N
+   */
+  static constexpr uint16_t lpfDivider(sths34pf80_lpf_config_t lpf) {
+    return lpf == STHS34PF80_LPF_ODR_DIV_9     ? 9
+           : lpf == STHS34PF80_LPF_ODR_DIV_20  ? 20
+           : lpf == STHS34PF80_LPF_ODR_DIV_50  ? 50
+           : lpf == STHS34PF80_LPF_ODR_DIV_100 ? 100
+           : lpf == STHS34PF80_LPF_ODR_DIV_200 ? 200
+           : lpf == STHS34PF80_LPF_ODR_DIV_400 ? 400
+                                               : 800;
+  }
+
+  /*!
+   * @brief Filter cutoff frequency
+   * @param odr The output data rate value
+   * @param lpf The LPF configuration value
+   * @return Cutoff in Hz
+   */
+  static constexpr float cutoffHz(sths34pf80_odr_t odr,
+                                  sths34pf80_lpf_config_t lpf) {
+    return odrHz(odr) / lpfDivider(lpf);
+  }
+
+  /*!
+   * @brief Filter time constant
+   * @param odr The output data rate value
+   * @param lpf The LPF configuration value
+   * @return Time constant in seconds, 0 for power-down
+   */
+  static constexpr float timeConstantS(sths34pf80_odr_t odr,
+                                       sths34pf80_lpf_config_t lpf) {
+    return odrHz(odr) > 0
+               ? lpfDivider(lpf) / (STHS34PF80_MODEL_TWO_PI * odrHz(odr))
+               : 0.0f;
+  }
+
+  /*!
+   * @brief Time for one filter section to settle within 5% of a step
+   * @param odr The output data rate value
+   * @param lpf The LPF configuration value
+   * @return Settling time in seconds
+   */
+  static constexpr float settlingS(sths34pf80_odr_t odr,
+                                   sths34pf80_lpf_config_t lpf) {
+    return STHS34PF80_MODEL_LN20 * timeConstantS(odr, lpf);
+  }
+
+  /*!
+   * @brief Object conversion time for one output sample
+   * @param avg_tmos The object temperature averaging value
+   * @return Conversion time in seconds
+   */
+  static constexpr float conversionS(sths34pf80_avg_tmos_t avg_tmos) {
+    return objSamples(avg_tmos) * STHS34PF80_MODEL_TMOS_SAMPLE_S;
+  }
+
+  /*!
+   * @brief e^-x, by squaring a short series, usable in constexpr
+   * @param x Exponent, 0 or more
+   * @return e^-x
+   */
+  static constexpr float expNeg(float x) {
+    return x > STHS34PF80_MODEL_EXP_SERIES
+               ? square(expNeg(x / 2))
+               : 1 - x + x * x / 2 - x * x * x / 6;
+  }
+
+  /*!
+   * @brief Square of a value
+   * @param v The value
+   * @return v * v
+   */
+  static constexpr float square(float v) { return v * v; }
+
+  /*!
+   * @brief Unit step response of two first-order sections in series
+   * @param tau_a Time constant of one section, seconds
+   * @param tau_b Time constant of the other, seconds
+   * @param t Time since the step, seconds
+   * @return Output, rising from 0 to 1
+   */
+  static constexpr float seriesStep(float tau_a, float tau_b, float t) {
+    return tau_a <= 0 ? 1 - expNeg(t / tau_b)
+           : tau_b <= 0 ? 1 - expNeg(t / tau_a)
+           : tau_a == tau_b
+               ? 1 - expNeg(t / tau_a) * (1 + t / tau_a)
+               : 1 - (tau_a * expNeg(t / tau_a) - tau_b * expNeg(t / tau_b)) /
+                         (tau_a - tau_b);
+  }
+
+  /*!
+   * @brief Unit step response of the difference of two first-order
+   * sections, a band-pass that rises and decays back to 0
+   * @param tau_fast Time constant of the faster section, seconds
+   * @param tau_slow Time constant of the slower section, seconds
+   * @param t Time since the step, seconds
+   * @return Output magnitude
+   */
+  static constexpr float differenceStep(float tau_fast, float tau_slow,
+                                        float t) {
+    return expNeg(t / tau_slow) - expNeg(t / tau_fast);
+  }
+
+  /*!
+   * @brief Time at which a series step response reaches a level, by
+   * bisection
+   * @param tau_a Time constant of one section, seconds
+   * @param tau_b Time constant of the other, seconds
+   * @param level Level between 0 and 1
+   * @param lo Start of the search interval, seconds
+   * @param hi End of the search interval, seconds
+   * @param steps Bisection steps left
+   * @return Crossing time in seconds
+   */
+  static constexpr float seriesCrossing(float tau_a, float tau_b, float level,
+                                        float lo, float hi, uint8_t steps) {
+    return steps == 0 ? (lo + hi) / 2
+           : seriesStep(tau_a, tau_b, (lo + hi) / 2) < level
+               ? seriesCrossing(tau_a, tau_b, level, (lo + hi) / 2, hi,
+                                steps - 1)
+               : seriesCrossing(tau_a, tau_b, level, lo, (lo + hi) / 2,
+                                steps - 1);
+  }
+
+  /*!
+   * @brief Time of the peak of a difference step response, by bisection on
+   * the sign of its slope
+   * @param tau_fast Time constant of the faster section, seconds
+   * @param tau_slow Time constant of the slower section, seconds
+   * @param lo Start of the search interval, seconds
+   * @param hi End of the search interval, seconds
+   * @param steps Bisection steps left
+   * @return Peak time in seconds
+   */
+  static constexpr float differencePeak(float tau_fast, float tau_slow,
+                                        float lo, float hi, uint8_t steps) {
+    return steps == 0 ? (lo + hi) / 2
+           : expNeg((lo + hi) / 2 / tau_fast) / tau_fast >
+                   expNeg((lo + hi) / 2 / tau_slow) / tau_slow
+               ? differencePeak(tau_fast, tau_slow, (lo + hi) / 2, hi,
+                                steps - 1)
+               : differencePeak(tau_fast, tau_slow, lo, (lo + hi) / 2,
+                                steps - 1);
+  }
+
+  /*!
+   * @brief Time at which a difference step response crosses a level on its
+   * rising or falling side, by bisection
+   * @param tau_fast Time constant of the faster section, seconds
+   * @param tau_slow Time constant of the slower section, seconds
+   * @param level Output level
+   * @param rising True to search the rising side (before the peak)
+   * @param lo Start of the search interval, seconds
+   * @param hi End of the search interval, seconds
+   * @param steps Bisection steps left
+   * @return Crossing time in seconds
+   */
+  static constexpr float differenceCrossing(float tau_fast, float tau_slow,
+                                            float level, bool rising,
+                                            float lo, float hi,
+                                            uint8_t steps) {
+    return steps == 0 ? (lo + hi) / 2
+           : (differenceStep(tau_fast, tau_slow, (lo + hi) / 2) < level) ==
+                   rising
+               ? differenceCrossing(tau_fast, tau_slow, level, rising,
+                                    (lo + hi) / 2, hi, steps - 1)
+               : differenceCrossing(tau_fast, tau_slow, level, rising, lo,
+                                    (lo + hi) / 2, steps - 1);
+  }
+
+  /*!
+   * @brief Time for the presence path (LPF_P_M then LPF_P) to reach a
+   * fraction of a step
+   * @param config The configuration
+   * @param level Fraction of the step, below 1
+   * @return Seconds, 0 for power-down
+   */
+  static constexpr float presenceDelayS(const sths34pf80_config_t& config,
+                                        float level) {
+    return odrHz(config.odr) > 0
+               ? seriesCrossing(timeConstantS(config.odr, config.lpf_p),
+                                timeConstantS(config.odr, config.lpf_p_m),
+                                level, 0,
+                                STHS34PF80_MODEL_SEARCH_SPAN *
+                                    (timeConstantS(config.odr, config.lpf_p) +
+                                     timeConstantS(config.odr, config.lpf_p_m)),
+                                STHS34PF80_MODEL_SEARCH_STEPS)
+               : 0.0f;
+  }
+
+  /*!
+   * @brief Time constant of the faster motion section (LPF_M or LPF_P_M)
+   * @param config The configuration
+   * @return Seconds
+   */
+  static constexpr float motionFastTauS(const sths34pf80_config_t& config) {
+    return lpfDivider(config.lpf_m) < lpfDivider(config.lpf_p_m)
+               ? timeConstantS(config.odr, config.lpf_m)
+               : timeConstantS(config.odr, config.lpf_p_m);
+  }
+
+  /*!
+   * @brief Time constant of the slower motion section (LPF_M or LPF_P_M)
+   * @param config The configuration
+   * @return Seconds
+   */
+  static constexpr float motionSlowTauS(const sths34pf80_config_t& config) {
+    return lpfDivider(config.lpf_m) < lpfDivider(config.lpf_p_m)
+               ? timeConstantS(config.odr, config.lpf_p_m)
+               : timeConstantS(config.odr, config.lpf_m);
+  }
+
+  /*!
+   * @brief Time of the motion path's (LPF_M minus LPF_P_M) peak response
+   * to a step
+   * @param config The configuration, LPF_M and LPF_P_M different
+   * @return Seconds
+   */
+  static constexpr float motionPeakS(const sths34pf80_config_t& config) {
+    // The peak always comes before the slower time constant
+    return differencePeak(motionFastTauS(config), motionSlowTauS(config), 0,
+                          motionSlowTauS(config),
+                          STHS34PF80_MODEL_SEARCH_STEPS);
+  }
+
+  /*!
+   * @brief Time for the motion path to cross a fraction of its peak
+   * response to a step
+   * @param config The configuration
+   * @param level Fraction of the peak, below 1
+   * @param rising True for the rising side, false for the decay after it
+   * @return Seconds, 0 for power-down, STHS34PF80_MODEL_NEVER_S if LPF_M
+   * and LPF_P_M are equal and the path cannot respond
+   */
+  static constexpr float motionDelayS(const sths34pf80_config_t& config,
+                                      float level, bool rising) {
+    return odrHz(config.odr) <= 0 ? 0.0f
+           : config.lpf_m == config.lpf_p_m
+               ? STHS34PF80_MODEL_NEVER_S
+           : rising
+               ? differenceCrossing(
+                     motionFastTauS(config), motionSlowTauS(config),
+                     level * differenceStep(motionFastTauS(config),
+                                            motionSlowTauS(config),
+                                            motionPeakS(config)),
+                     true, 0, motionPeakS(config),
+                     STHS34PF80_MODEL_SEARCH_STEPS)
+               : differenceCrossing(
+                     motionFastTauS(config), motionSlowTauS(config),
+                     level * differenceStep(motionFastTauS(config),
+                                            motionSlowTauS(config),
+                                            motionPeakS(config)),
+                     false, motionPeakS(config),
+                     STHS34PF80_MODEL_SEARCH_SPAN * motionSlowTauS(config),
+                     STHS34PF80_MODEL_SEARCH_STEPS);
+  }
+
+  /*!
+   * @brief Average sensor supply current
+   * @param odr The output data rate value
+   * @param avg_tmos The object temperature averaging value
+   * @return Current in uA
+   */
+  static constexpr float supplyUA(sths34pf80_odr_t odr,
+                                  sths34pf80_avg_tmos_t avg_tmos) {
+    return STHS34PF80_MODEL_STANDBY_UA +
+           STHS34PF80_MODEL_ACTIVE_UA *
+               (conversionS(avg_tmos) * odrHz(odr) < 1.0f
+                    ? conversionS(avg_tmos) * odrHz(odr)
+                    : 1.0f);
+  }
+
+  /*!
+   * @brief Validate a configuration
+   * @param config The configuration
+   * @return STHS34PF80_CONFIG_OK or the first problem found
+   */
+  static constexpr sths34pf80_config_status_t validate(
+      const sths34pf80_config_t& config) {
+    return config.odr > STHS34PF80_ODR_30_HZ ? STHS34PF80_CONFIG_BAD_ODR
+           : config.avg_tmos > STHS34PF80_AVG_TMOS_2048 ||
+                   config.avg_t > STHS34PF80_AVG_T_1
+               ? STHS34PF80_CONFIG_BAD_AVERAGING
+           : config.lpf_m > STHS34PF80_LPF_ODR_DIV_800 ||
+                   config.lpf_p_m > STHS34PF80_LPF_ODR_DIV_800 ||
+                   config.lpf_p > STHS34PF80_LPF_ODR_DIV_800 ||
+                   config.lpf_a_t > STHS34PF80_LPF_ODR_DIV_800
+               ? STHS34PF80_CONFIG_BAD_LPF
+           : config.odr > maxOdr(config.avg_tmos)
+               ? STHS34PF80_CONFIG_ODR_TOO_HIGH
+           : config.odr == STHS34PF80_ODR_POWER_DOWN
+               ? STHS34PF80_CONFIG_POWER_DOWN
+               : STHS34PF80_CONFIG_OK;
+  }
+
+  /*!
+   * @brief Check whether a configuration can be applied and produces data
+   * @param config The configuration
+   * @return True if validate() returns STHS34PF80_CONFIG_OK
+   */
+  static constexpr bool isValid(const sths34pf80_config_t& config) {
+    return validate(config) == STHS34PF80_CONFIG_OK;
+  }
+
+  /*!
+   * @brief Worst-case presence detection latency
+   *
+   * A step that lands just after a conversion starts waits one full ODR
+   * period, then the conversion, then for LPF_P_M and LPF_P in series to
+   * cover half of the step (a threshold set at half the expected signal).
+   * @param config The configuration
+   * @return Latency in seconds, 0 for power-down
+   */
+  static constexpr float presenceLatencyS(const sths34pf80_config_t& config) {
+    return odrHz(config.odr) > 0 ? 1.0f / odrHz(config.odr) +
+                                       conversionS(config.avg_tmos) +
+                                       presenceDelayS(config, 0.5f)
+                                 : 0.0f;
+  }
+
+  /*!
+   * @brief Worst-case motion detection latency
+   *
+   * As presenceLatencyS(), with the threshold at half the peak of the
+   * LPF_M minus LPF_P_M band-pass.
+   * @param config The configuration
+   * @return Latency in seconds, 0 for power-down, STHS34PF80_MODEL_NEVER_S
+   * if LPF_M and LPF_P_M are equal
+   */
+  static constexpr float motionLatencyS(const sths34pf80_config_t& config) {
+    return odrHz(config.odr) <= 0 ? 0.0f
+           : config.lpf_m == config.lpf_p_m
+               ? STHS34PF80_MODEL_NEVER_S
+               : 1.0f / odrHz(config.odr) + conversionS(config.avg_tmos) +
+                     motionDelayS(config, 0.5f, true);
+  }
+
+  /*!
+   * @brief Presence 95% step settling time, LPF_P_M and LPF_P in series
+   * @param config The configuration
+   * @return Settling time in seconds
+   */
+  static constexpr float presenceSettlingS(const sths34pf80_config_t& config) {
+    return presenceDelayS(config, 0.95f);
+  }
+
+  /*!
+   * @brief Time for the motion output to decay back within 5% of its peak
+   * after a step, when the motion flag clears
+   * @param config The configuration
+   * @return Settling time in seconds, 0 if LPF_M and LPF_P_M are equal
+   */
+  static constexpr float motionSettlingS(const sths34pf80_config_t& config) {
+    return config.lpf_m == config.lpf_p_m ? 0.0f
+                                          : motionDelayS(config, 0.05f, false);
+  }
+
+  /*!
+   * @brief Read the configuration the sensor is running, filters included
+   * @param sensor The sensor
+   * @param config Destination
+   * @return False without a sensor
+   */
+  static bool readConfig(Adafruit_STHS34PF80* sensor,
+                         sths34pf80_config_t* config) {
+    if (!sensor || !config) {
+      return false;
+    }
+    config->odr = sensor->getOutputDataRate();
+    config->avg_tmos = sensor->getObjAveraging();
+    config->avg_t = sensor->getAmbTempAveraging();
+    config->lpf_m = sensor->getMotionLowPassFilter();
+    config->lpf_p_m = sensor->getMotionPresenceLowPassFilter();
+    config->lpf_p = sensor->getPresenceLowPassFilter();
+    config->lpf_a_t = sensor->getTemperatureLowPassFilter();
+    return true;
+  }
+
+  /*!
+   * @brief Sensitivity coded by a SENS_DATA value
+   * @param sens_data The SENS_DATA register value
+   * @return Sensitivity in LSB/degC (0 to 4080)
+   */
+  static constexpr float sensitivityLsb(int8_t sens_data) {
+    return STHS34PF80_SENS_BASE_LSB + STHS34PF80_SENS_STEP_LSB * sens_data;
+  }
+
+  /*!
+   * @brief Nearest SENS_DATA value for a sensitivity
+   * @param lsb_per_c Sensitivity in LSB/degC
+   * @return SENS_DATA value, saturated to the int8_t range
+   */
+  static constexpr int8_t sensData(float lsb_per_c) {
+    return lsb_per_c <= sensitivityLsb(-128)  ? -128
+           : lsb_per_c >= sensitivityLsb(127) ? 127
+           : lsb_per_c >= STHS34PF80_SENS_BASE_LSB
+               ? (int8_t)((lsb_per_c - STHS34PF80_SENS_BASE_LSB) /
+                              STHS34PF80_SENS_STEP_LSB +
+                          0.5f)
+               : (int8_t)((lsb_per_c - STHS34PF80_SENS_BASE_LSB) /
+                              STHS34PF80_SENS_STEP_LSB -
+                          0.5f);
+  }
+
+  /*!
+   * @brief Full timing and power report of a configuration
+   * @param config The configuration
+   * @return The report, figures are meaningful only if status is OK
+   */
+  static constexpr sths34pf80_config_report_t analyze(
+      const sths34pf80_config_t& config) {
+    return sths34pf80_config_report_t{
+        validate(config),
+        cutoffHz(config.odr, config.lpf_m),
+        cutoffHz(config.odr, config.lpf_p_m),
+        cutoffHz(config.odr, config.lpf_p),
+        cutoffHz(config.odr, config.lpf_a_t),
+        conversionS(config.avg_tmos),
+        presenceSettlingS(config),
+        motionSettlingS(config),
+        presenceLatencyS(config),
+        motionLatencyS(config),
+        supplyUA(config.odr, config.avg_tmos)};
+  }
+
+  /*!
+   * @brief Find the lowest-power ODR and averaging meeting a latency target
+   *
+   * The LPF and ambient averaging settings of the base configuration are
+   * kept, and its object averaging is the least accepted: fewer samples are
+   * always cheaper but noisier. Among equal-power candidates the one with
+   * more averaging wins.
+   * @param latency_s Worst-case presence and motion latency target, seconds
+   * @param base Configuration providing the filter settings and the minimum
+   * object averaging
+   * @param result Destination for the chosen configuration
+   * @return True if a configuration meets the target, false otherwise
+   */
+  static bool lowestPowerConfig(float latency_s,
+                                const sths34pf80_config_t& base,
+                                sths34pf80_config_t* result) {
+    bool found = false;
+    float best_ua = 0;
+    sths34pf80_config_t candidate = base;
+
+    for (uint8_t odr = STHS34PF80_ODR_0_25_HZ; odr <= STHS34PF80_ODR_30_HZ;
+         odr++) {
+      for (uint8_t avg = base.avg_tmos; avg <= STHS34PF80_AVG_TMOS_2048;
+           avg++) {
+        candidate.odr = (sths34pf80_odr_t)odr;
+        candidate.avg_tmos = (sths34pf80_avg_tmos_t)avg;
+        if (!isValid(candidate) || presenceLatencyS(candidate) > latency_s ||
+            motionLatencyS(candidate) > latency_s) {
+          continue;
+        }
+        float ua = supplyUA(candidate.odr, candidate.avg_tmos);
+        if (!found || ua <= best_ua) {
+          found = true;
+          best_ua = ua;
+          if (result) {
+            *result = candidate;
+          }
+        }
+      }
+    }
+
+    return found;
+  }
+};
+
+#endif
@@ -0,0 +1,328 @@
+/*!
+ * @file Adafruit_STHS34PF80_MotionClassifier.cpp
+ *
+ * Streaming frequency-domain motion classifier for the STHS34PF80.
+ *
+ * TMOTION samples go into a 32-sample ring. Every 8 samples the window is
+ * run through a fixed-point Goertzel bank (bins 1..16, DC removed) and a
+ * small feature vector is built: log2 energy, peak and band shares,
+ * zero-crossing rate, TPRESENCE swing and how long the same peak bin has
+ * dominated. People give broadband, non-repeating energy with a presence
+ * swing; fans and oscillating vents give a stable tone; curtains and HVAC
+ * drafts give a slow low-band swell. Events are classified by a rule set,
+ * or by a linear model over the same features.
+ *
+ * Memory is fixed (about 270 bytes per instance). Cost per sample is one
+ * ring write and a running sum; every hop adds WINDOW * BINS = 512 Goertzel
+ * iterations plus 16 power terms, i.e. 64 iterations amortized per sample.
+ * Each iteration multiplies the Q14 coefficient by the 32-bit state as two
+ * 32-bit multiplies (no 64-bit arithmetic, a single MULS each on a
+ * Cortex-M0+): roughly 1-2k cycles per sample on a Cortex-M0+, a few
+ * hundred on a Cortex-M4, well under 1% of a 48 MHz core at the 30 Hz ODR.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_MotionClassifier.h"
+
+#include <math.h>
+
+#define STHS34PF80_GOERTZEL_Q 14 ///< Fractional bits of the coefficients
+#define STHS34PF80_POWER_SHIFT 8 ///< binPower() scale, 2^-8
+
+/*!
+ * @brief Instantiates a classifier with the default rule set
+ */
+Adafruit_STHS34PF80_MotionClassifier::Adafruit_STHS34PF80_MotionClassifier()
+    : _bias(0), _linear(false) {
+  // 2cos(2 pi k / N) in Q14, computed once
+  for (uint8_t k = 0; k < STHS34PF80_MOTION_BINS; k++) {
+    float w = 6.2831853f * (k + 1) / STHS34PF80_MOTION_WINDOW;
+    _coeff[k] = (int16_t)(2.0f * cosf(w) * (1 << STHS34PF80_GOERTZEL_Q));
+  }
+  for (uint8_t i = 0; i < STHS34PF80_FEAT_COUNT; i++) {
+    _weights[i] = 0;
+  }
+
+  _rules.min_energy = 300;     // ~50 LSB sine amplitude
+  _rules.periodic_share = 160; // 62% of the energy in one bin
+  _rules.periodic_hops = 4;
+  _rules.slow_share = 200; // 78% of the energy below WINDOW/8
+  _rules.person_swing = 300;
+
+  reset();
+}
+
+/*!
+ * @brief Replace the rule set thresholds and classify with rules
+ * @param rules The thresholds
+ */
+void Adafruit_STHS34PF80_MotionClassifier::setRules(
+    const sths34pf80_motion_rules_t& rules) {
+  _rules = rules;
+  _linear = false;
+}
+
+/*!
+ * @brief Classify with a linear model instead of the rule set
+ *
+ * score = bias + sum(weights[i] * feature[i]); windows above the minimum
+ * energy are PERSON if score > 0, OTHER otherwise.
+ * @param weights STHS34PF80_FEAT_COUNT weights, indexed by
+ * sths34pf80_motion_feature_t
+ * @param bias Score offset
+ */
+void Adafruit_STHS34PF80_MotionClassifier::setLinearModel(
+    const int16_t* weights, int32_t bias) {
+  for (uint8_t i = 0; i < STHS34PF80_FEAT_COUNT; i++) {
+    _weights[i] = weights[i];
+  }
+  _bias = bias;
+  _linear = true;
+}
+
+/*!
+ * @brief Go back to classifying with the rule set
+ */
+void Adafruit_STHS34PF80_MotionClassifier::useRules() {
+  _linear = false;
+}
+
+/*!
+ * @brief Clear the window and the last classification
+ */
+void Adafruit_STHS34PF80_MotionClassifier::reset() {
+  for (uint8_t i = 0; i < STHS34PF80_MOTION_WINDOW; i++) {
+    _motion[i] = 0;
+    _presence[i] = 0;
+  }
+  for (uint8_t k = 0; k < STHS34PF80_MOTION_BINS; k++) {
+    _power[k] = 0;
+  }
+  for (uint8_t i = 0; i < STHS34PF80_FEAT_COUNT; i++) {
+    _features[i] = 0;
+  }
+  _sum = 0;
+  _head = 0;
+  _filled = 0;
+  _since_hop = 0;
+  _peak_bin = 0;
+  _class = STHS34PF80_MOTION_NONE;
+}
+
+/*!
+ * @brief Add one sample, analyzing the window every STHS34PF80_MOTION_HOP
+ * samples once it is full
+ * @param motion Raw TMOTION value
+ * @param presence Raw TPRESENCE value
+ * @return True if a new classification is available
+ */
+bool Adafruit_STHS34PF80_MotionClassifier::addSample(int16_t motion,
+                                                     int16_t presence) {
+  _sum += motion - _motion[_head];
+  _motion[_head] = motion;
+  _presence[_head] = presence;
+  _head = (_head + 1) % STHS34PF80_MOTION_WINDOW;
+
+  if (_filled < STHS34PF80_MOTION_WINDOW) {
+    _filled++;
+  }
+  if (++_since_hop < STHS34PF80_MOTION_HOP ||
+      _filled < STHS34PF80_MOTION_WINDOW) {
+    return false;
+  }
+
+  _since_hop = 0;
+  analyze();
+  _class = classify();
+  return true;
+}
+
+/*!
+ * @brief Goertzel coefficient times state, (coeff * s) >> Q exactly, from
+ * two 32-bit products instead of a 64-bit one
+ * @param coeff Q14 coefficient
+ * @param s State
+ * @return The product, scaled back by 2^-14
+ */
+static int32_t goertzelMul(int32_t coeff, int32_t s) {
+  // s = hi * 2^14 + lo with 0 <= lo < 2^14, so the low product fits too
+  int32_t hi = s >> STHS34PF80_GOERTZEL_Q;
+  int32_t lo = s & ((1L << STHS34PF80_GOERTZEL_Q) - 1);
+  return coeff * hi + ((coeff * lo) >> STHS34PF80_GOERTZEL_Q);
+}
+
+/*!
+ * @brief Run the Goertzel bank over the window and rebuild the features
+ */
+void Adafruit_STHS34PF80_MotionClassifier::analyze() {
+  int32_t mean = _sum / STHS34PF80_MOTION_WINDOW;
+  uint64_t total = 0;
+  uint64_t low = 0;
+  uint64_t high = 0;
+  uint64_t peak = 0;
+  uint8_t peak_bin = 0;
+
+  for (uint8_t k = 0; k < STHS34PF80_MOTION_BINS; k++) {
+    int32_t coeff = _coeff[k];
+    int32_t s1 = 0;
+    int32_t s2 = 0;
+    uint8_t idx = _head; // oldest sample
+    for (uint8_t n = 0; n < STHS34PF80_MOTION_WINDOW; n++) {
+      int32_t x = _motion[idx] - mean;
+      int32_t s0 = x + goertzelMul(coeff, s1) - s2;
+      s2 = s1;
+      s1 = s0;
+      idx = (idx + 1) % STHS34PF80_MOTION_WINDOW;
+    }
+
+    int64_t p = (int64_t)s1 * s1 + (int64_t)s2 * s2 -
+                (int64_t)goertzelMul(coeff, s1) * s2;
+    uint64_t power = p > 0 ? (uint64_t)p : 0;
+
+    uint64_t scaled = power >> STHS34PF80_POWER_SHIFT;
+    _power[k] = scaled > 0xFFFFFFFFUL ? 0xFFFFFFFFUL : (uint32_t)scaled;
+
+    total += power;
+    if (k < STHS34PF80_MOTION_WINDOW / 8) {
+      low += power;
+    } else if (k >= STHS34PF80_MOTION_WINDOW / 4) {
+      high += power;
+    }
+    if (power > peak) {
+      peak = power;
+      peak_bin = k + 1;
+    }
+  }
+
+  // log2(total) in Q4: integer part from the top bit, 4 fraction bits below
+  int16_t energy = 0;
+  if (total) {
+    uint8_t msb = 63;
+    while (!(total >> msb)) {
+      msb--;
+    }
+    uint8_t frac = msb >= 4 ? (total >> (msb - 4)) & 0x0F
+                            : (total << (4 - msb)) & 0x0F;
+    energy = msb * 16 + frac;
+  }
+
+  uint8_t crossings = 0;
+  int16_t pres_min = _presence[0];
+  int16_t pres_max = _presence[0];
+  bool above = _motion[_head] >= mean;
+  for (uint8_t n = 0; n < STHS34PF80_MOTION_WINDOW; n++) {
+    uint8_t idx = (_head + n) % STHS34PF80_MOTION_WINDOW;
+    bool now_above = _motion[idx] >= mean;
+    if (now_above != above) {
+      crossings++;
+      above = now_above;
+    }
+    if (_presence[n] < pres_min) {
+      pres_min = _presence[n];
+    }
+    if (_presence[n] > pres_max) {
+      pres_max = _presence[n];
+    }
+  }
+  int32_t swing = (int32_t)pres_max - pres_min;
+
+  int16_t peak_share = total ? (int16_t)((peak << 8) / total) : 0;
+  int16_t stability = 0;
+  if (peak_share >= _rules.periodic_share) {
+    stability = 1;
+    if (peak_bin == _peak_bin &&
+        _features[STHS34PF80_FEAT_STABILITY] < 255) {
+      stability = _features[STHS34PF80_FEAT_STABILITY] + 1;
+    }
+  }
+
+  _peak_bin = peak_bin;
+  _features[STHS34PF80_FEAT_ENERGY] = energy;
+  _features[STHS34PF80_FEAT_PEAK_SHARE] = peak_share;
+  _features[STHS34PF80_FEAT_LOW_SHARE] =
+      total ? (int16_t)((low << 8) / total) : 0;
+  _features[STHS34PF80_FEAT_HIGH_SHARE] =
+      total ? (int16_t)((high << 8) / total) : 0;
+  _features[STHS34PF80_FEAT_ZERO_CROSSINGS] =
+      (int16_t)(crossings * 256 / (STHS34PF80_MOTION_WINDOW - 1));
+  _features[STHS34PF80_FEAT_PRESENCE_SWING] =
+      swing > 32767 ? 32767 : (int16_t)swing;
+  _features[STHS34PF80_FEAT_STABILITY] = stability;
+}
+
+/*!
+ * @brief Classify the current feature vector
+ * @return The motion class
+ */
+sths34pf80_motion_class_t Adafruit_STHS34PF80_MotionClassifier::classify() {
+  if (_features[STHS34PF80_FEAT_ENERGY] < _rules.min_energy) {
+    return STHS34PF80_MOTION_NONE;
+  }
+
+  if (_linear) {
+    // A 16x16 product per feature plus the bias can exceed 32 bits
+    int64_t score = _bias;
+    for (uint8_t i = 0; i < STHS34PF80_FEAT_COUNT; i++) {
+      score += (int32_t)_weights[i] * _features[i];
+    }
+    return score > 0 ? STHS34PF80_MOTION_PERSON : STHS34PF80_MOTION_OTHER;
+  }
+
+  if (_features[STHS34PF80_FEAT_PRESENCE_SWING] >= _rules.person_swing) {
+    return STHS34PF80_MOTION_PERSON;
+  }
+  if (_features[STHS34PF80_FEAT_LOW_SHARE] >= _rules.slow_share) {
+    return STHS34PF80_MOTION_SLOW;
+  }
+  if (_features[STHS34PF80_FEAT_PEAK_SHARE] >= _rules.periodic_share) {
+    // A tone is only called periodic once it has held for a few hops
+    return _features[STHS34PF80_FEAT_STABILITY] >= _rules.periodic_hops
+               ? STHS34PF80_MOTION_PERIODIC
+               : STHS34PF80_MOTION_OTHER;
+  }
+  return STHS34PF80_MOTION_PERSON;
+}
+
+/*!
+ * @brief Get the classification of the last analyzed window
+ * @return The motion class
+ */
+sths34pf80_motion_class_t
+Adafruit_STHS34PF80_MotionClassifier::classification() {
+  return _class;
+}
+
+/*!
+ * @brief Get one feature of the last analyzed window
+ * @param index The feature
+ * @return The feature value, 0 for an invalid index
+ */
+int16_t Adafruit_STHS34PF80_MotionClassifier::feature(
+    sths34pf80_motion_feature_t index) {
+  if (index >= STHS34PF80_FEAT_COUNT) {
+    return 0;
+  }
+  return _features[index];
+}
+
+/*!
+ * @brief Get the power of one Goertzel bin of the last analyzed window
+ * @param bin Bin number, 1 to STHS34PF80_MOTION_BINS (bin * ODR / WINDOW Hz)
+ * @return Power scaled by 2^-8, 0 for an invalid bin
+ */
+uint32_t Adafruit_STHS34PF80_MotionClassifier::binPower(uint8_t bin) {
+  if (bin < 1 || bin > STHS34PF80_MOTION_BINS) {
+    return 0;
+  }
+  return _power[bin - 1];
+}
+
+/*!
+ * @brief Get the strongest bin of the last analyzed window
+ * @return Bin number, 1 to STHS34PF80_MOTION_BINS, or 0 if silent
+ */
+uint8_t Adafruit_STHS34PF80_MotionClassifier::peakBin() {
+  return _peak_bin;
+}
@@ -0,0 +1,101 @@
+/*!
+ * @file Adafruit_STHS34PF80_MotionClassifier.h
+ *
+ * Streaming frequency-domain classifier for the STHS34PF80 TMOTION signal,
+ * separating people from fans, curtains and HVAC vents.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_MOTIONCLASSIFIER_H__
+#define __ADAFRUIT_STHS34PF80_MOTIONCLASSIFIER_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+#define STHS34PF80_MOTION_WINDOW 32 ///< Samples per analysis window
+#define STHS34PF80_MOTION_HOP 8     ///< Samples between analyses
+#define STHS34PF80_MOTION_BINS \
+  (STHS34PF80_MOTION_WINDOW / 2) ///< Goertzel bins 1..WINDOW/2
+
+/*!
+ * @brief Motion event classes
+ */
+typedef enum {
+  STHS34PF80_MOTION_NONE = 0x00,     ///< Too little motion energy
+  STHS34PF80_MOTION_PERSON = 0x01,   ///< Broadband, non-repeating motion
+  STHS34PF80_MOTION_PERIODIC = 0x02, ///< Stable tone (fan, oscillating vent)
+  STHS34PF80_MOTION_SLOW = 0x03,     ///< Slow swell without presence change
+  STHS34PF80_MOTION_OTHER = 0x04,    ///< Unconfirmed tone or rejected event
+} sths34pf80_motion_class_t;
+
+/*!
+ * @brief Indices into the feature vector
+ */
+typedef enum {
+  STHS34PF80_FEAT_ENERGY = 0,         ///< log2 of AC energy, Q4
+  STHS34PF80_FEAT_PEAK_SHARE = 1,     ///< Strongest bin share of energy, /256
+  STHS34PF80_FEAT_LOW_SHARE = 2,      ///< Bins 1..WINDOW/8 share, /256
+  STHS34PF80_FEAT_HIGH_SHARE = 3,     ///< Bins above WINDOW/4 share, /256
+  STHS34PF80_FEAT_ZERO_CROSSINGS = 4, ///< Zero-crossing rate, /256
+  STHS34PF80_FEAT_PRESENCE_SWING = 5, ///< TPRESENCE max - min in the window
+  STHS34PF80_FEAT_STABILITY = 6,      ///< Hops the same peak bin dominated
+  STHS34PF80_FEAT_COUNT = 7,          ///< Number of features
+} sths34pf80_motion_feature_t;
+
+/*!
+ * @brief Thresholds of the built-in rule set
+ */
+typedef struct {
+  int16_t min_energy;     ///< Below this STHS34PF80_FEAT_ENERGY: NONE
+  int16_t periodic_share; ///< Peak share for a tone, /256
+  int16_t periodic_hops;  ///< Hops a tone must persist to be PERIODIC
+  int16_t slow_share;     ///< Low-band share for a slow swell, /256
+  int16_t person_swing;   ///< Presence swing that always means a person
+} sths34pf80_motion_rules_t;
+
+/*!
+ * @brief Class that classifies motion from the TMOTION/TPRESENCE stream
+ */
+class Adafruit_STHS34PF80_MotionClassifier {
+ public:
+  Adafruit_STHS34PF80_MotionClassifier();
+
+  void setRules(const sths34pf80_motion_rules_t& rules);
+  void setLinearModel(const int16_t* weights, int32_t bias);
+  void useRules();
+
+  void reset();
+  bool addSample(int16_t motion, int16_t presence);
+
+  sths34pf80_motion_class_t classification();
+  int16_t feature(sths34pf80_motion_feature_t index);
+  uint32_t binPower(uint8_t bin);
+  uint8_t peakBin();
+
+ private:
+  void analyze();
+  sths34pf80_motion_class_t classify();
+
+  int16_t _motion[STHS34PF80_MOTION_WINDOW];
+  int16_t _presence[STHS34PF80_MOTION_WINDOW];
+  int16_t _coeff[STHS34PF80_MOTION_BINS];
+  uint32_t _power[STHS34PF80_MOTION_BINS];
+  int16_t _features[STHS34PF80_FEAT_COUNT];
+  int16_t _weights[STHS34PF80_FEAT_COUNT];
+  int32_t _bias;
+  int32_t _sum;
+  sths34pf80_motion_rules_t _rules;
+  sths34pf80_motion_class_t _class;
+  uint8_t _head;
+  uint8_t _filled;
+  uint8_t _since_hop;
+  uint8_t _peak_bin;
+  bool _linear;
+};
+
+#endif
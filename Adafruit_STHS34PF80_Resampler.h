@@ -0,0 +1,357 @@
+/*!
+ * @file Adafruit_STHS34PF80_Resampler.h
+ *
+ * Aligns samples from STHS34PF80 sensors running at different ODRs onto one
+ * common time grid.
+ *
+ * Each sensor's arrival timestamps (host clock, jittered by polling and bus
+ * latency) are tracked with an alpha-beta filter on the sample index, which
+ * gives a smoothed sample time and the sensor's actual period. Comparing
+ * that period with the nominal one from setSensorOdr() gives the drift of
+ * the sensor oscillator against the host clock (the datasheet allows a
+ * few percent). Gaps of up to STHS34PF80_RESAMPLE_MAX_GAP missed samples
+ * are bridged; longer gaps resynchronize the sensor.
+ *
+ * A grid point at time T is emitted once the host clock passes T plus the
+ * configured latency. Every sensor is then linearly interpolated between
+ * the two smoothed samples around T. Flags come from the earlier sample. A
+ * sensor with no sample after T yet (slower than the latency allows, or
+ * late) holds its newest value instead. Output therefore trails real time
+ * by at most the latency plus the caller's poll interval.
+ *
+ * Memory is fixed at compile time: DEPTH samples per sensor. DEPTH has to
+ * cover the latency at the fastest ODR in use plus two samples.
+ *
+ * Usage:
+ *
+ *   Adafruit_STHS34PF80_Resampler<4> resampler(100000, 250000);
+ *   resampler.setSensorOdr(0, STHS34PF80_ODR_30_HZ);
+ *   resampler.setSensorOdr(1, STHS34PF80_ODR_1_HZ);
+ *   ...
+ *   if (sensor0.readSample(&sample)) resampler.push(0, micros(), sample);
+ *   ...
+ *   while (resampler.ready(micros())) {
+ *     resampler.sample(0, &aligned0);
+ *     resampler.sample(1, &aligned1);
+ *     resampler.advance();
+ *   }
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_RESAMPLER_H__
+#define __ADAFRUIT_STHS34PF80_RESAMPLER_H__
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Model.h"
+
+#define STHS34PF80_RESAMPLE_MAX_GAP 64 ///< Missed samples bridged before resync
+
+/*!
+ * @brief How a resampled value was produced
+ */
+typedef enum {
+  STHS34PF80_RESAMPLE_NONE = 0x00,         ///< No sample from this sensor yet
+  STHS34PF80_RESAMPLE_INTERPOLATED = 0x01, ///< Between two samples
+  STHS34PF80_RESAMPLE_HELD = 0x02,         ///< Nearest sample held
+} sths34pf80_resample_status_t;
+
+/*!
+ * @brief Class that resamples many sensors onto one time grid
+ * @tparam MAX_SENSORS Sensor capacity
+ * @tparam DEPTH Samples kept per sensor, at most 255
+ */
+template <uint16_t MAX_SENSORS, uint8_t DEPTH = 8>
+class Adafruit_STHS34PF80_Resampler {
+ public:
+  static_assert(DEPTH >= 2, "Interpolation needs two samples");
+
+  /*!
+   * @brief Instantiates a resampler
+   * @param period_us Grid period in microseconds
+   * @param latency_us How long a grid point waits for late samples
+   */
+  Adafruit_STHS34PF80_Resampler(uint32_t period_us = 100000,
+                                uint32_t latency_us = 250000)
+      : _grid_period(period_us ? period_us : 1), _latency(latency_us) {
+    for (uint16_t s = 0; s < MAX_SENSORS; s++) {
+      _nominal_q8[s] = 0;
+    }
+    reset();
+  }
+
+  /*!
+   * @brief Forget all samples and estimates, keeping the nominal ODRs
+   */
+  void reset() {
+    for (uint16_t s = 0; s < MAX_SENSORS; s++) {
+      _period_q8[s] = _nominal_q8[s];
+      _fit[s] = 0;
+      _seen[s] = 0;
+      _head[s] = 0;
+      _fill[s] = 0;
+    }
+    _grid = 0;
+    _started = false;
+  }
+
+  /*!
+   * @brief Set the grid period and output latency
+   * @param period_us Grid period in microseconds
+   * @param latency_us How long a grid point waits for late samples
+   */
+  void setGrid(uint32_t period_us, uint32_t latency_us) {
+    _grid_period = period_us ? period_us : 1;
+    _latency = latency_us;
+  }
+
+  /*!
+   * @brief Set a sensor's programmed ODR, the reference for its drift and
+   * the starting point of its period estimate
+   * @param sensor Sensor index
+   * @param odr Output data rate
+   * @return False on a bad index or power-down
+   */
+  bool setSensorOdr(uint16_t sensor, sths34pf80_odr_t odr) {
+    if (sensor >= MAX_SENSORS || odr == STHS34PF80_ODR_POWER_DOWN) {
+      return false;
+    }
+    _nominal_q8[sensor] =
+        (uint32_t)(256000000.0f / Adafruit_STHS34PF80_Model::odrHz(odr));
+    _period_q8[sensor] = _nominal_q8[sensor];
+    _seen[sensor] = 0;
+    return true;
+  }
+
+  /*!
+   * @brief Add a sample
+   * @param sensor Sensor index
+   * @param timestamp_us Host time the sample was read, e.g. micros()
+   * @param sample The sample
+   * @return False on a bad index
+   */
+  bool push(uint16_t sensor, uint32_t timestamp_us,
+            const sths34pf80_sample_t& sample) {
+    if (sensor >= MAX_SENSORS) {
+      return false;
+    }
+
+    uint32_t t = track(sensor, timestamp_us);
+    uint32_t base = sensor * DEPTH;
+    _time[base + _head[sensor]] = t;
+    _ring[base + _head[sensor]] = sample;
+    _head[sensor] = _head[sensor] + 1 == DEPTH ? 0 : _head[sensor] + 1;
+    if (_fill[sensor] < DEPTH) {
+      _fill[sensor]++;
+    }
+
+    if (!_started) {
+      // First grid point: the next multiple of the grid period
+      _grid = (t / _grid_period + 1) * _grid_period;
+      _started = true;
+    }
+    return true;
+  }
+
+  /*!
+   * @brief Check whether the current grid point can be emitted
+   * @param now_us Host time, same clock as the push() timestamps
+   * @return True once now_us is past the grid point plus the latency
+   */
+  bool ready(uint32_t now_us) {
+    return _started && (int32_t)(now_us - _grid - _latency) >= 0;
+  }
+
+  /*!
+   * @brief Get the time of the current grid point
+   * @return Host time in microseconds
+   */
+  uint32_t gridTime() { return _grid; }
+
+  /*!
+   * @brief Move on to the next grid point
+   */
+  void advance() { _grid += _grid_period; }
+
+  /*!
+   * @brief Get a sensor's value at the current grid point
+   * @param sensor Sensor index
+   * @param out Set to the resampled sample, untouched for
+   * STHS34PF80_RESAMPLE_NONE
+   * @return How the value was produced
+   */
+  sths34pf80_resample_status_t sample(uint16_t sensor,
+                                      sths34pf80_sample_t* out) {
+    if (sensor >= MAX_SENSORS || !_fill[sensor] || !out) {
+      return STHS34PF80_RESAMPLE_NONE;
+    }
+
+    // Oldest first; stop at the first sample after the grid point
+    uint32_t base = sensor * DEPTH;
+    uint8_t fill = _fill[sensor];
+    uint8_t i = _head[sensor] >= fill ? _head[sensor] - fill
+                                      : _head[sensor] + DEPTH - fill;
+    uint8_t before = DEPTH;
+    for (uint8_t n = 0; n < fill; n++) {
+      if ((int32_t)(_time[base + i] - _grid) > 0) {
+        if (before == DEPTH) {
+          *out = _ring[base + i];
+          return STHS34PF80_RESAMPLE_HELD;
+        }
+        interpolate(base + before, base + i, out);
+        return STHS34PF80_RESAMPLE_INTERPOLATED;
+      }
+      before = i;
+      i = i + 1 == DEPTH ? 0 : i + 1;
+    }
+
+    *out = _ring[base + before];
+    return STHS34PF80_RESAMPLE_HELD;
+  }
+
+  /*!
+   * @brief Get a sensor's estimated sample period
+   * @param sensor Sensor index
+   * @return Period in microseconds on the host clock, 0 if unknown
+   */
+  uint32_t periodMicros(uint16_t sensor) {
+    return sensor < MAX_SENSORS ? (_period_q8[sensor] + 128) >> 8 : 0;
+  }
+
+  /*!
+   * @brief Get a sensor's estimated output data rate
+   * @param sensor Sensor index
+   * @return ODR in Hz on the host clock, 0 if unknown
+   */
+  float odrHz(uint16_t sensor) {
+    if (sensor >= MAX_SENSORS || !_period_q8[sensor]) {
+      return 0;
+    }
+    return 256000000.0f / _period_q8[sensor];
+  }
+
+  /*!
+   * @brief Get a sensor's clock drift against the host clock
+   * @param sensor Sensor index
+   * @return Parts per million the sensor runs fast (positive) or slow, 0
+   * if no nominal ODR was set
+   */
+  int32_t driftPpm(uint16_t sensor) {
+    if (sensor >= MAX_SENSORS || !_nominal_q8[sensor] || !_period_q8[sensor]) {
+      return 0;
+    }
+    int64_t delta = (int64_t)_nominal_q8[sensor] - _period_q8[sensor];
+    return (int32_t)(delta * 1000000 / _period_q8[sensor]);
+  }
+
+ private:
+  /*!
+   * @brief Update a sensor's period estimate with a new arrival time
+   * @param s Sensor index
+   * @param t Arrival time in microseconds
+   * @return Smoothed sample time
+   */
+  uint32_t track(uint16_t s, uint32_t t) {
+    if (_seen[s] < 0xFF) {
+      _seen[s]++;
+    }
+    if (_seen[s] == 1) {
+      _fit[s] = t;
+      return t;
+    }
+
+    uint32_t elapsed = (int32_t)(t - _fit[s]) > 0 ? t - _fit[s] : 0;
+    if (!_period_q8[s]) {
+      // No nominal ODR: the first interval is the initial estimate
+      _period_q8[s] = elapsed < 0x00FFFFFF ? elapsed << 8 : 0xFFFFFF00;
+      _fit[s] = t;
+      return t;
+    }
+
+    uint32_t period = _period_q8[s] >> 8;
+    uint32_t n = period ? (elapsed + period / 2) / period : 1;
+    if (n > STHS34PF80_RESAMPLE_MAX_GAP) {
+      // Too many missed samples to trust the phase, start over here
+      _fit[s] = t;
+      return t;
+    }
+    if (n == 0) {
+      n = 1;
+    }
+
+    uint32_t predicted = _fit[s] + n * period +
+                         ((n * (_period_q8[s] & 0xFF)) >> 8);
+    int32_t err = (int32_t)(t - predicted);
+    int32_t limit = period / 2;
+    err = err > limit ? limit : (err < -limit ? -limit : err);
+
+    // alpha = 1/8 on the phase, beta = 1/128 on the period
+    _fit[s] = predicted + err / 8;
+    int32_t step = err * 2 / (int32_t)n;
+    _period_q8[s] = step < 0 && (uint32_t)-step >= _period_q8[s]
+                        ? _period_q8[s]
+                        : _period_q8[s] + step;
+    return _fit[s];
+  }
+
+  /*!
+   * @brief Interpolate every channel between two stored samples
+   * @param a Index of the sample at or before the grid point
+   * @param b Index of the sample after it
+   * @param out Set to the result; flags are taken from a
+   */
+  void interpolate(uint32_t a, uint32_t b, sths34pf80_sample_t* out) {
+    // Q15 position of the grid point between the two samples
+    uint32_t span = _time[b] - _time[a];
+    uint32_t offset = _grid - _time[a];
+    while (span > 0xFFFF) {
+      span >>= 1;
+      offset >>= 1;
+    }
+    int32_t frac = span ? (int32_t)((offset << 15) / span) : 0;
+
+    const sths34pf80_sample_t& x = _ring[a];
+    const sths34pf80_sample_t& y = _ring[b];
+    out->object = lerp(x.object, y.object, frac);
+    out->ambient = lerp(x.ambient, y.ambient, frac);
+    out->obj_comp = lerp(x.obj_comp, y.obj_comp, frac);
+    out->presence = lerp(x.presence, y.presence, frac);
+    out->motion = lerp(x.motion, y.motion, frac);
+    out->temp_shock = lerp(x.temp_shock, y.temp_shock, frac);
+    out->flags = x.flags;
+  }
+
+  /*!
+   * @brief Linear interpolation of one value
+   * @param a Value at position 0
+   * @param b Value at position 32768
+   * @param frac Q15 position
+   * @return The interpolated value
+   */
+  static int16_t lerp(int16_t a, int16_t b, int32_t frac) {
+    return (int16_t)(a + (((int32_t)b - a) * frac) / 32768);
+  }
+
+  // Per sensor
+  uint32_t _nominal_q8[MAX_SENSORS]; // Programmed period, us Q8
+  uint32_t _period_q8[MAX_SENSORS];  // Estimated period, us Q8
+  uint32_t _fit[MAX_SENSORS];        // Smoothed time of the newest sample
+  uint8_t _seen[MAX_SENSORS];
+  uint8_t _head[MAX_SENSORS];
+  uint8_t _fill[MAX_SENSORS];
+  // Per stored sample, DEPTH per sensor
+  uint32_t _time[MAX_SENSORS * DEPTH];
+  sths34pf80_sample_t _ring[MAX_SENSORS * DEPTH];
+
+  uint32_t _grid;
+  uint32_t _grid_period;
+  uint32_t _latency;
+  bool _started;
+};
+
+#endif
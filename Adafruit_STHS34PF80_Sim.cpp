@@ -0,0 +1,565 @@
+/*!
+ * @file Adafruit_STHS34PF80_Sim.cpp
+ *
+ * Simulated STHS34PF80 for running the real driver without hardware.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_Sim.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "Adafruit_STHS34PF80_Model.h"
+
+#define STHS34PF80_SIM_AMBIENT_C 25.0f   ///< Default scene temperature
+#define STHS34PF80_SIM_SENS_LSB 2000.0f  ///< Default true sensitivity
+#define STHS34PF80_SIM_BASELINE_S 30.0f  ///< Presence baseline time constant
+#define STHS34PF80_SIM_WALK_EDGE_MS 1500 ///< Walking person enter/leave time
+#define STHS34PF80_SIM_MAX_BACKLOG 4096  ///< Conversions run in one catch-up
+
+/*!
+ * @brief Instantiates a simulated sensor, powered on
+ * @param clock Clock conversions are timed by, shared with the driver; NULL
+ * for the system clock
+ */
+Adafruit_STHS34PF80_Sim::Adafruit_STHS34PF80_Sim(
+    Adafruit_STHS34PF80_Clock* clock)
+    : _clock(clock ? clock : Adafruit_STHS34PF80_Clock::system()),
+      _device(this, busRead, busWrite, busReadRegister, busWriteRegister),
+      _last_addr(0),
+      _stimulus(STHS34PF80_STIMULUS_NONE),
+      _amplitude(0),
+      _start_ms(0),
+      _duration_ms(0),
+      _noise_scale(1.0f),
+      _rng(1),
+      _object_c(STHS34PF80_SIM_AMBIENT_C),
+      _ambient_c(STHS34PF80_SIM_AMBIENT_C),
+      _transmission(1.0f),
+      _sensitivity(STHS34PF80_SIM_SENS_LSB),
+      _conversions(0) {
+  _clock_us = _clock->getMicros();
+  _time_us = _clock_us;
+  _last_conversion_us = _time_us;
+  resetBusStats();
+  powerOn();
+}
+
+/*!
+ * @brief Get the bus device to pass to Adafruit_STHS34PF80::begin()
+ * @return The device
+ */
+Adafruit_GenericDevice* Adafruit_STHS34PF80_Sim::device() { return &_device; }
+
+/*!
+ * @brief Restore the power-on register values, as after an OTP reboot
+ */
+void Adafruit_STHS34PF80_Sim::powerOn() {
+  memset(_regs, 0, sizeof(_regs));
+  memset(_embedded, 0, sizeof(_embedded));
+  _regs[STHS34PF80_REG_WHO_AM_I] = 0xD3;
+  _regs[STHS34PF80_REG_AVG_TRIM] = 0x03;
+  _regs[STHS34PF80_REG_CTRL0] = 0x70;
+  // Factory trim of the bare part
+  _regs[STHS34PF80_REG_SENS_DATA] =
+      (uint8_t)Adafruit_STHS34PF80_Model::sensData(_sensitivity);
+  _embedded[STHS34PF80_EMBEDDED_PRESENCE_THS] = 200;
+  _embedded[STHS34PF80_EMBEDDED_MOTION_THS] = 200;
+  _embedded[STHS34PF80_EMBEDDED_TAMB_SHOCK_THS] = 10;
+  _embedded[STHS34PF80_EMBEDDED_HYST_MOTION] = 50;
+  _embedded[STHS34PF80_EMBEDDED_HYST_PRESENCE] = 50;
+  _embedded[STHS34PF80_EMBEDDED_HYST_TAMB_SHOCK] = 2;
+  _running = false;
+  _next_us = 0;
+  resetAlgorithm();
+}
+
+/*!
+ * @brief Seed the noise generator, for repeatable runs
+ * @param seed Any value
+ */
+void Adafruit_STHS34PF80_Sim::setSeed(uint32_t seed) {
+  _rng = seed ? seed : 1;
+}
+
+/*!
+ * @brief Set the object temperature stimulus
+ * @param type Stimulus shape
+ * @param amplitude Peak TOBJECT change in LSB
+ * @param start_ms Clock time the stimulus starts
+ * @param duration_ms Step/stay length, or ramp rise time
+ */
+void Adafruit_STHS34PF80_Sim::setStimulus(sths34pf80_stimulus_t type,
+                                          float amplitude, uint32_t start_ms,
+                                          uint32_t duration_ms) {
+  _stimulus = type;
+  _amplitude = amplitude;
+  _start_ms = start_ms;
+  _duration_ms = duration_ms;
+}
+
+/*!
+ * @brief Evaluate the stimulus, without noise
+ * @param t_ms Clock time
+ * @return TOBJECT change in LSB
+ */
+float Adafruit_STHS34PF80_Sim::stimulus(uint32_t t_ms) {
+  if (_stimulus == STHS34PF80_STIMULUS_NONE ||
+      (int32_t)(t_ms - _start_ms) < 0) {
+    return 0;
+  }
+  uint32_t t = t_ms - _start_ms;
+
+  switch (_stimulus) {
+    case STHS34PF80_STIMULUS_STEP:
+      return t < _duration_ms ? _amplitude : 0;
+    case STHS34PF80_STIMULUS_RAMP:
+      return t < _duration_ms ? _amplitude * t / _duration_ms : _amplitude;
+    default: {
+      // Raised-cosine walk in and out of the field of view, with a small
+      // sway while standing
+      const uint32_t edge = STHS34PF80_SIM_WALK_EDGE_MS;
+      const float pi = 3.14159265f;
+      if (t < edge) {
+        return _amplitude * (1 - cosf(pi * t / edge)) / 2;
+      }
+      t -= edge;
+      if (t < _duration_ms) {
+        return _amplitude * (1 + 0.1f * sinf(pi * t / 1000));
+      }
+      t -= _duration_ms;
+      if (t < edge) {
+        return _amplitude * (1 + cosf(pi * t / edge)) / 2;
+      }
+      return 0;
+    }
+  }
+}
+
+/*!
+ * @brief Scale the object noise
+ * @param scale Multiplier of the modelled noise (default 1, 0 for none)
+ */
+void Adafruit_STHS34PF80_Sim::setNoiseScale(float scale) {
+  _noise_scale = scale;
+}
+
+/*!
+ * @brief Set the temperatures in view; equal temperatures (the default)
+ * leave only the stimulus
+ * @param object_c Object temperature filling the field of view, degC
+ * @param ambient_c Ambient (sensor die) temperature, degC
+ */
+void Adafruit_STHS34PF80_Sim::setScene(float object_c, float ambient_c) {
+  _object_c = object_c;
+  _ambient_c = ambient_c;
+}
+
+/*!
+ * @brief Set the transmission of a window or lens in front of the sensor
+ * @param transmission Fraction of the object signal reaching the part
+ * (default 1, no optics)
+ */
+void Adafruit_STHS34PF80_Sim::setTransmission(float transmission) {
+  _transmission = transmission;
+}
+
+/*!
+ * @brief Set the true sensitivity of the bare part, also programmed as its
+ * factory SENS_DATA trim
+ * @param lsb_per_c Sensitivity in LSB/degC (default 2000)
+ */
+void Adafruit_STHS34PF80_Sim::setSensitivity(float lsb_per_c) {
+  _sensitivity = lsb_per_c;
+  _regs[STHS34PF80_REG_SENS_DATA] =
+      (uint8_t)Adafruit_STHS34PF80_Model::sensData(lsb_per_c);
+}
+
+/*!
+ * @brief Get the bus traffic since the last resetBusStats()
+ * @param stats Set to the counters
+ */
+void Adafruit_STHS34PF80_Sim::getBusStats(sths34pf80_bus_stats_t* stats) {
+  if (stats) {
+    *stats = _bus;
+  }
+}
+
+/*!
+ * @brief Clear the bus traffic counters
+ */
+void Adafruit_STHS34PF80_Sim::resetBusStats() {
+  memset(&_bus, 0, sizeof(_bus));
+}
+
+/*!
+ * @brief Get the number of conversions since construction, up to the
+ * current time
+ * @return Conversions
+ */
+uint32_t Adafruit_STHS34PF80_Sim::conversions() {
+  update();
+  return _conversions;
+}
+
+/*!
+ * @brief Get the age of the output registers at the last bus access, e.g.
+ * the latency of a sample just read
+ * @return Microseconds from the latest conversion to the last access
+ */
+uint32_t Adafruit_STHS34PF80_Sim::sampleAgeMicros() {
+  return (uint32_t)(_time_us - _last_conversion_us);
+}
+
+/*!
+ * @brief Sample the INT pin as CTRL3 routes it, e.g. for
+ * Adafruit_STHS34PF80_WakeCoordinator::setInterruptLine()
+ *
+ * DRDY follows the STATUS bit. INT_OR asserts when a conversion changes a
+ * flag enabled in INT_MSK and, latched, holds until FUNC_STATUS is read;
+ * pulsed, it drops at the next conversion. Polarity and output type are
+ * wiring matters and not modelled.
+ * @return True while INT is asserted
+ */
+bool Adafruit_STHS34PF80_Sim::intLine() {
+  update();
+  switch (_regs[STHS34PF80_REG_CTRL3] & 0x03) {
+    case STHS34PF80_INT_DRDY:
+      return _regs[STHS34PF80_REG_STATUS] & 0x04;
+    case STHS34PF80_INT_OR:
+      return _int_or;
+    default:
+      return false;
+  }
+}
+
+/*!
+ * @brief Read registers with auto-increment, as an I2C burst would
+ * @param reg First register address
+ * @param data Destination
+ * @param len Number of registers
+ * @return True, the model does not fail
+ */
+bool Adafruit_STHS34PF80_Sim::readRegisters(uint8_t reg, uint8_t* data,
+                                            uint16_t len) {
+  update();
+  count(len, true);
+
+  bool embedded = (_regs[STHS34PF80_REG_CTRL2] & 0x10) &&
+                  (_regs[STHS34PF80_REG_PAGE_RW] & 0x20);
+  for (uint16_t i = 0; i < len; i++) {
+    uint8_t addr = (reg + i) & 0x3F;
+    if (addr == STHS34PF80_REG_FUNC_CFG_DATA && embedded) {
+      data[i] = _embedded[_regs[STHS34PF80_REG_FUNC_CFG_ADDR] & 0x3F];
+    } else {
+      data[i] = _regs[addr];
+    }
+    if (addr == STHS34PF80_REG_FUNC_STATUS) {
+      // Reading FUNC_STATUS clears DRDY and releases a latched INT_OR
+      _regs[STHS34PF80_REG_STATUS] &= ~0x04;
+      _int_or = false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * @brief Write registers with auto-increment, applying their side effects
+ * @param reg First register address
+ * @param data Values
+ * @param len Number of registers
+ * @return True, the model does not fail
+ */
+bool Adafruit_STHS34PF80_Sim::writeRegisters(uint8_t reg, const uint8_t* data,
+                                             uint16_t len) {
+  update();
+  count(len, false);
+
+  for (uint16_t i = 0; i < len; i++) {
+    uint8_t addr = (reg + i) & 0x3F;
+    uint8_t value = data[i];
+
+    switch (addr) {
+      case STHS34PF80_REG_WHO_AM_I:
+      case STHS34PF80_REG_STATUS:
+      case STHS34PF80_REG_FUNC_STATUS:
+        break;
+
+      case STHS34PF80_REG_FUNC_CFG_DATA:
+        if ((_regs[STHS34PF80_REG_CTRL2] & 0x10) &&
+            (_regs[STHS34PF80_REG_PAGE_RW] & 0x40)) {
+          uint8_t target = _regs[STHS34PF80_REG_FUNC_CFG_ADDR] & 0x3F;
+          _embedded[target] = value;
+          if (target == STHS34PF80_EMBEDDED_RESET_ALGO && (value & 0x01)) {
+            resetAlgorithm();
+          }
+          _regs[STHS34PF80_REG_FUNC_CFG_ADDR]++;
+        }
+        break;
+
+      case STHS34PF80_REG_CTRL1: {
+        bool was_running = _regs[addr] & 0x0F;
+        _regs[addr] = value;
+        _running = value & 0x0F;
+        if (_running && !was_running) {
+          _next_us = _time_us + periodMicros();
+        }
+        break;
+      }
+
+      case STHS34PF80_REG_CTRL2:
+        if (value & 0x80) {
+          powerOn();
+          break;
+        }
+        _regs[addr] = value & ~0x01;
+        if ((value & 0x01) && !_running) {
+          _last_conversion_us = _time_us;
+          convert((uint32_t)(_time_us / 1000));
+        }
+        break;
+
+      default:
+        if (addr >= STHS34PF80_REG_TOBJECT_L) {
+          break; // Outputs are read-only
+        }
+        _regs[addr] = value;
+        break;
+    }
+  }
+  return true;
+}
+
+/*!
+ * @brief Run the conversions that fell due since the last bus access
+ */
+void Adafruit_STHS34PF80_Sim::update() {
+  uint32_t now = _clock->getMicros();
+  _time_us += (uint32_t)(now - _clock_us);
+  _clock_us = now;
+  if (!_running) {
+    return;
+  }
+
+  uint64_t period = periodMicros();
+  if (_time_us > _next_us + period * STHS34PF80_SIM_MAX_BACKLOG) {
+    // Nobody looked for a long time, skip the conversions nobody can see
+    _next_us = _time_us - period * STHS34PF80_SIM_MAX_BACKLOG;
+  }
+  while (_next_us <= _time_us) {
+    _last_conversion_us = _next_us;
+    convert((uint32_t)(_next_us / 1000));
+    _next_us += period;
+  }
+}
+
+/*!
+ * @brief Get the conversion period of the programmed ODR
+ * @return Microseconds between conversions, 0 when powered down
+ */
+uint32_t Adafruit_STHS34PF80_Sim::periodMicros() {
+  uint8_t odr = _regs[STHS34PF80_REG_CTRL1] & 0x0F;
+  if (!odr) {
+    return 0;
+  }
+  // Any 1xxx code runs at 30 Hz
+  float hz = Adafruit_STHS34PF80_Model::odrHz(
+      odr & 0x08 ? STHS34PF80_ODR_30_HZ : (sths34pf80_odr_t)odr);
+  return (uint32_t)(1000000.0f / hz);
+}
+
+/*!
+ * @brief Produce one output sample
+ * @param t_ms Conversion time
+ */
+void Adafruit_STHS34PF80_Sim::convert(uint32_t t_ms) {
+  uint8_t lpf1 = _regs[STHS34PF80_REG_LPF1];
+  uint8_t lpf2 = _regs[STHS34PF80_REG_LPF2];
+  sths34pf80_avg_tmos_t avg =
+      (sths34pf80_avg_tmos_t)(_regs[STHS34PF80_REG_AVG_TRIM] & 0x07);
+
+  // Averaging lowers the noise down to a floor
+  float sigma = _noise_scale * Adafruit_STHS34PF80_Model::noiseLsb(avg);
+  float contrast = _transmission * _sensitivity * (_object_c - _ambient_c);
+  float object = contrast + stimulus(t_ms) + sigma * gaussian();
+
+  if (!_primed) {
+    _lpf_m = _lpf_p_m = _lpf_p = _baseline = object;
+    _primed = true;
+  }
+
+  const float two_pi = 6.2831853f;
+  float a_m = 1 - expf(-two_pi / Adafruit_STHS34PF80_Model::lpfDivider(
+                                     (sths34pf80_lpf_config_t)(lpf1 & 0x07)));
+  float a_p_m =
+      1 - expf(-two_pi / Adafruit_STHS34PF80_Model::lpfDivider(
+                             (sths34pf80_lpf_config_t)((lpf1 >> 3) & 0x07)));
+  float a_p =
+      1 - expf(-two_pi / Adafruit_STHS34PF80_Model::lpfDivider(
+                             (sths34pf80_lpf_config_t)((lpf2 >> 3) & 0x07)));
+  _lpf_m += a_m * (object - _lpf_m);
+  _lpf_p_m += a_p_m * (object - _lpf_p_m);
+  _lpf_p += a_p * (_lpf_p_m - _lpf_p);
+
+  float presence = _lpf_p - _baseline;
+  float motion = _lpf_m - _lpf_p_m;
+
+  uint8_t flags = _regs[STHS34PF80_REG_FUNC_STATUS] & 0x07;
+  int32_t ths = ((_embedded[STHS34PF80_EMBEDDED_PRESENCE_THS + 1] << 8) |
+                 _embedded[STHS34PF80_EMBEDDED_PRESENCE_THS]) &
+                0x7FFF;
+  int32_t hyst = _embedded[STHS34PF80_EMBEDDED_HYST_PRESENCE];
+  if (flags & STHS34PF80_PRES_FLAG ? presence < ths - hyst : presence >= ths) {
+    flags ^= STHS34PF80_PRES_FLAG;
+  }
+  ths = ((_embedded[STHS34PF80_EMBEDDED_MOTION_THS + 1] << 8) |
+         _embedded[STHS34PF80_EMBEDDED_MOTION_THS]) &
+        0x7FFF;
+  hyst = _embedded[STHS34PF80_EMBEDDED_HYST_MOTION];
+  float magnitude = fabsf(motion);
+  if (flags & STHS34PF80_MOT_FLAG ? magnitude < ths - hyst
+                                  : magnitude >= ths) {
+    flags ^= STHS34PF80_MOT_FLAG;
+  }
+
+  // The baseline follows slow drift but not a person in view
+  if (!(flags & STHS34PF80_PRES_FLAG)) {
+    float period_s = periodMicros() / 1000000.0f;
+    _baseline += (1 - expf(-period_s / STHS34PF80_SIM_BASELINE_S)) *
+                 (_lpf_p - _baseline);
+  }
+
+  setOutput(STHS34PF80_REG_TOBJECT_L, (int32_t)object);
+  setOutput(STHS34PF80_REG_TAMBIENT_L, (int32_t)lroundf(_ambient_c * 100));
+  setOutput(STHS34PF80_REG_TOBJ_COMP_L, (int32_t)object);
+  setOutput(STHS34PF80_REG_TPRESENCE_L, (int32_t)presence);
+  setOutput(STHS34PF80_REG_TMOTION_L, (int32_t)motion);
+  setOutput(STHS34PF80_REG_TAMB_SHOCK_L, 0);
+  uint8_t ctrl3 = _regs[STHS34PF80_REG_CTRL3];
+  uint8_t mask = (ctrl3 >> 3) & 0x07;
+  bool changed = (flags ^ _regs[STHS34PF80_REG_FUNC_STATUS]) & mask;
+  _int_or = changed || (_int_or && (ctrl3 & 0x04));
+  _regs[STHS34PF80_REG_FUNC_STATUS] = flags;
+  _regs[STHS34PF80_REG_STATUS] |= 0x04;
+  _conversions++;
+}
+
+/*!
+ * @brief Restart the detection algorithm, as RESET_ALGO does
+ */
+void Adafruit_STHS34PF80_Sim::resetAlgorithm() {
+  _primed = false;
+  _lpf_m = _lpf_p_m = _lpf_p = _baseline = 0;
+  _regs[STHS34PF80_REG_FUNC_STATUS] = 0;
+  _int_or = false;
+}
+
+/*!
+ * @brief Store a saturated int16 output register pair
+ * @param reg Low byte register address
+ * @param value Value
+ */
+void Adafruit_STHS34PF80_Sim::setOutput(uint8_t reg, int32_t value) {
+  value = value > 32767 ? 32767 : (value < -32768 ? -32768 : value);
+  _regs[reg] = (uint8_t)value;
+  _regs[reg + 1] = (uint8_t)((uint16_t)value >> 8);
+}
+
+/*!
+ * @brief Draw standard normal noise (xorshift32 and Box-Muller)
+ * @return Noise sample
+ */
+float Adafruit_STHS34PF80_Sim::gaussian() {
+  float u[2];
+  for (uint8_t i = 0; i < 2; i++) {
+    _rng ^= _rng << 13;
+    _rng ^= _rng >> 17;
+    _rng ^= _rng << 5;
+    u[i] = ((_rng >> 8) + 1) / 16777217.0f;
+  }
+  return sqrtf(-2 * logf(u[0])) * cosf(6.2831853f * u[1]);
+}
+
+/*!
+ * @brief Count one transaction in the bus statistics
+ * @param len Data bytes
+ * @param read True for a register read, which needs a repeated start
+ */
+void Adafruit_STHS34PF80_Sim::count(uint16_t len, bool read) {
+  _bus.transactions++;
+  _bus.bytes += len;
+  // Address and register bytes, data bytes, 9 bits each with the ACK, plus
+  // start/stop (and the repeated start and second address byte of a read)
+  _bus.bits += read ? (3 + len) * 9 + 3 : (2 + len) * 9 + 2;
+}
+
+/*!
+ * @brief Raw bus read: continues at the last addressed register
+ * @param obj The simulator
+ * @param buffer Destination
+ * @param len Number of bytes
+ * @return True, the model does not fail
+ */
+bool Adafruit_STHS34PF80_Sim::busRead(void* obj, uint8_t* buffer, size_t len) {
+  Adafruit_STHS34PF80_Sim* sim = (Adafruit_STHS34PF80_Sim*)obj;
+  return sim->readRegisters(sim->_last_addr, buffer, len);
+}
+
+/*!
+ * @brief Raw bus write: register address followed by data
+ * @param obj The simulator
+ * @param buffer Register address and data
+ * @param len Number of bytes
+ * @return False for an empty write
+ */
+bool Adafruit_STHS34PF80_Sim::busWrite(void* obj, const uint8_t* buffer,
+                                       size_t len) {
+  Adafruit_STHS34PF80_Sim* sim = (Adafruit_STHS34PF80_Sim*)obj;
+  if (!len) {
+    return false;
+  }
+  sim->_last_addr = buffer[0];
+  return len == 1 || sim->writeRegisters(buffer[0], buffer + 1, len - 1);
+}
+
+/*!
+ * @brief Register read callback of the generic device
+ * @param obj The simulator
+ * @param addr_buf Register address
+ * @param addrsiz Address length, 1
+ * @param data Destination
+ * @param datalen Number of bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_Sim::busReadRegister(void* obj, uint8_t* addr_buf,
+                                              uint8_t addrsiz, uint8_t* data,
+                                              uint16_t datalen) {
+  if (addrsiz != 1) {
+    return false;
+  }
+  return ((Adafruit_STHS34PF80_Sim*)obj)
+      ->readRegisters(addr_buf[0], data, datalen);
+}
+
+/*!
+ * @brief Register write callback of the generic device
+ * @param obj The simulator
+ * @param addr_buf Register address
+ * @param addrsiz Address length, 1
+ * @param data Values
+ * @param datalen Number of bytes
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_Sim::busWriteRegister(void* obj, uint8_t* addr_buf,
+                                               uint8_t addrsiz,
+                                               const uint8_t* data,
+                                               uint16_t datalen) {
+  if (addrsiz != 1) {
+    return false;
+  }
+  return ((Adafruit_STHS34PF80_Sim*)obj)
+      ->writeRegisters(addr_buf[0], data, datalen);
+}
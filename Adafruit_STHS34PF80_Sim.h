@@ -0,0 +1,124 @@
+/*!
+ * @file Adafruit_STHS34PF80_Sim.h
+ *
+ * Simulated STHS34PF80 for running the real driver without hardware, with
+ * injectable thermal stimuli.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_SIM_H__
+#define __ADAFRUIT_STHS34PF80_SIM_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+/*!
+ * @brief Object temperature stimulus shapes
+ */
+typedef enum {
+  STHS34PF80_STIMULUS_NONE = 0x00, ///< Empty scene, noise only
+  STHS34PF80_STIMULUS_STEP = 0x01, ///< Instant rise, held for the duration
+  STHS34PF80_STIMULUS_RAMP = 0x02, ///< Linear rise over the duration, held
+  STHS34PF80_STIMULUS_WALK = 0x03, ///< Person walking in, staying, leaving
+} sths34pf80_stimulus_t;
+
+/*!
+ * @brief Class that models the STHS34PF80 register map and signal chain
+ *
+ * The driver talks to it through device(), an Adafruit_GenericDevice, so
+ * the real register sequences (safe ODR changes, embedded page access,
+ * burst reads) run unchanged. Conversions happen at the programmed ODR on
+ * the shared clock, normally an Adafruit_STHS34PF80_SimClock that the
+ * caller advances.
+ *
+ * Signal chain per conversion, as first-order sections with the cutoffs
+ * of Adafruit_STHS34PF80_Model: TOBJECT is the scene contrast (object
+ * minus ambient, through the optics' transmission at the part's true
+ * sensitivity) plus the stimulus and Gaussian noise that shrinks with
+ * AVG_TMOS; TPRESENCE is LPF_P after LPF_P_M of TOBJ_COMP minus a slow
+ * baseline that freezes while presence is flagged; TMOTION is
+ * LPF_M minus LPF_P_M. Flags compare against the embedded thresholds with
+ * their hysteresis, and intLine() gives the INT pin as CTRL3 routes it.
+ * The noise and baseline figures are estimates for comparing
+ * configurations, not a characterization of the part.
+ */
+class Adafruit_STHS34PF80_Sim {
+ public:
+  Adafruit_STHS34PF80_Sim(Adafruit_STHS34PF80_Clock* clock = NULL);
+
+  Adafruit_GenericDevice* device();
+  void powerOn();
+  void setSeed(uint32_t seed);
+
+  void setStimulus(sths34pf80_stimulus_t type, float amplitude,
+                   uint32_t start_ms, uint32_t duration_ms);
+  float stimulus(uint32_t t_ms);
+  void setNoiseScale(float scale);
+  void setScene(float object_c, float ambient_c);
+  void setTransmission(float transmission);
+  void setSensitivity(float lsb_per_c);
+
+  void getBusStats(sths34pf80_bus_stats_t* stats);
+  void resetBusStats();
+  uint32_t conversions();
+  uint32_t sampleAgeMicros();
+  bool intLine();
+
+  bool readRegisters(uint8_t reg, uint8_t* data, uint16_t len);
+  bool writeRegisters(uint8_t reg, const uint8_t* data, uint16_t len);
+
+ private:
+  static bool busRead(void* obj, uint8_t* buffer, size_t len);
+  static bool busWrite(void* obj, const uint8_t* buffer, size_t len);
+  static bool busReadRegister(void* obj, uint8_t* addr_buf, uint8_t addrsiz,
+                              uint8_t* data, uint16_t datalen);
+  static bool busWriteRegister(void* obj, uint8_t* addr_buf, uint8_t addrsiz,
+                               const uint8_t* data, uint16_t datalen);
+
+  void update();
+  uint32_t periodMicros();
+  void convert(uint32_t t_ms);
+  void resetAlgorithm();
+  void setOutput(uint8_t reg, int32_t value);
+  float gaussian();
+  void count(uint16_t len, bool read);
+
+  Adafruit_STHS34PF80_Clock* _clock;
+  Adafruit_GenericDevice _device;
+  uint8_t _regs[0x40];
+  uint8_t _embedded[0x40];
+  uint8_t _last_addr;
+
+  sths34pf80_stimulus_t _stimulus;
+  float _amplitude;
+  uint32_t _start_ms;
+  uint32_t _duration_ms;
+  float _noise_scale;
+  uint32_t _rng;
+  float _object_c;
+  float _ambient_c;
+  float _transmission;
+  float _sensitivity;
+
+  uint64_t _time_us;
+  uint32_t _clock_us;
+  uint64_t _next_us;
+  uint64_t _last_conversion_us;
+  bool _running;
+  bool _primed;
+  bool _int_or;
+  float _lpf_m;
+  float _lpf_p_m;
+  float _lpf_p;
+  float _baseline;
+
+  uint32_t _conversions;
+  sths34pf80_bus_stats_t _bus;
+};
+
+#endif
@@ -0,0 +1,316 @@
+/*!
+ * @file Adafruit_STHS34PF80_Telemetry.cpp
+ *
+ * Compact, versioned binary frames for uplinking STHS34PF80 sample batches.
+ *
+ * Values are stored channel by channel as zigzag varints of the deltas
+ * between consecutive samples, so the slowly moving object and ambient
+ * channels mostly take one byte per sample, and quiet presence/motion
+ * channels often less than that would suggest. The three FUNC_STATUS flags
+ * are bit-packed. A raw sample is 14 bytes; see the telemetry benchmark
+ * example for the frame size per minute at each ODR.
+ *
+ * The same code encodes on the MCU and decodes on the host side.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_Telemetry.h"
+
+#define STHS34PF80_TELEMETRY_CHANNELS 6 ///< Channels in a sample
+#define STHS34PF80_TELEMETRY_FLAG_BITS 3 ///< FUNC_STATUS bits per sample
+#define STHS34PF80_TELEMETRY_FIXED_LEN 7 ///< magic, version, mask, hash
+
+/*!
+ * @brief Byte sink that only counts once the buffer is full (or absent)
+ */
+typedef struct {
+  uint8_t* buf; ///< Output, NULL to only measure
+  size_t max;   ///< Output capacity
+  size_t len;   ///< Bytes produced so far
+} sths34pf80_writer_t;
+
+/*!
+ * @brief Byte source that flags reads past the end
+ */
+typedef struct {
+  const uint8_t* buf; ///< Input
+  size_t len;         ///< Input length
+  size_t pos;         ///< Read position
+  bool error;         ///< A read went past the end
+} sths34pf80_reader_t;
+
+static void putByte(sths34pf80_writer_t* w, uint8_t b) {
+  if (w->buf && w->len < w->max) {
+    w->buf[w->len] = b;
+  }
+  w->len++;
+}
+
+static void putVarint(sths34pf80_writer_t* w, uint32_t v) {
+  while (v >= 0x80) {
+    putByte(w, (uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  putByte(w, (uint8_t)v);
+}
+
+static uint8_t getByte(sths34pf80_reader_t* r) {
+  if (r->pos >= r->len) {
+    r->error = true;
+    return 0;
+  }
+  return r->buf[r->pos++];
+}
+
+static uint32_t getVarint(sths34pf80_reader_t* r) {
+  uint32_t v = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    uint8_t b = getByte(r);
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      return v;
+    }
+  }
+  r->error = true;
+  return 0;
+}
+
+static uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static int16_t* channel(sths34pf80_sample_t* sample, uint8_t index) {
+  switch (index) {
+    case 0:
+      return &sample->object;
+    case 1:
+      return &sample->ambient;
+    case 2:
+      return &sample->obj_comp;
+    case 3:
+      return &sample->presence;
+    case 4:
+      return &sample->motion;
+    default:
+      return &sample->temp_shock;
+  }
+}
+
+static int16_t channelValue(const sths34pf80_sample_t& sample,
+                            uint8_t index) {
+  return *channel((sths34pf80_sample_t*)&sample, index);
+}
+
+/*!
+ * @brief Write (or, with a NULL buffer, measure) a frame without the CRC
+ * @param samples Samples to encode
+ * @param count Number of samples
+ * @param info Header fields
+ * @param w Output
+ */
+static void writeFrame(const sths34pf80_sample_t* samples, uint16_t count,
+                       const sths34pf80_frame_info_t& info,
+                       sths34pf80_writer_t* w) {
+  putByte(w, STHS34PF80_TELEMETRY_MAGIC);
+  putByte(w, STHS34PF80_TELEMETRY_VERSION);
+  putByte(w, info.channels & STHS34PF80_TELEMETRY_ALL);
+  for (uint8_t i = 0; i < 4; i++) {
+    putByte(w, (uint8_t)(info.config_hash >> (8 * i)));
+  }
+  putVarint(w, info.timestamp_ms);
+  putVarint(w, info.period_ms);
+  putVarint(w, count);
+
+  uint16_t acc = 0;
+  uint8_t bits = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    acc |= (uint16_t)(samples[i].flags & 0x07) << bits;
+    bits += STHS34PF80_TELEMETRY_FLAG_BITS;
+    if (bits >= 8) {
+      putByte(w, (uint8_t)acc);
+      acc >>= 8;
+      bits -= 8;
+    }
+  }
+  if (bits) {
+    putByte(w, (uint8_t)acc);
+  }
+
+  for (uint8_t c = 0; c < STHS34PF80_TELEMETRY_CHANNELS; c++) {
+    if (!(info.channels & (1 << c))) {
+      continue;
+    }
+    int32_t previous = 0;
+    for (uint16_t i = 0; i < count; i++) {
+      int32_t value = channelValue(samples[i], c);
+      putVarint(w, zigzag(value - previous));
+      previous = value;
+    }
+  }
+}
+
+/*!
+ * @brief Get the size of the frame encode() would produce
+ * @param samples Samples to encode
+ * @param count Number of samples
+ * @param info Header fields (channels, config_hash, timestamp_ms, period_ms)
+ * @return Frame length in bytes
+ */
+size_t Adafruit_STHS34PF80_Telemetry::encodedSize(
+    const sths34pf80_sample_t* samples, uint16_t count,
+    const sths34pf80_frame_info_t& info) {
+  sths34pf80_writer_t w = {NULL, 0, 0};
+  writeFrame(samples, count, info, &w);
+  return w.len + 2;
+}
+
+/*!
+ * @brief Find how many leading samples fit in one frame
+ * @param samples Samples to encode
+ * @param count Number of samples available
+ * @param info Header fields
+ * @param max_len Largest frame, e.g. the radio payload size
+ * @return Number of samples that fit, 0 if not even one does
+ */
+uint16_t Adafruit_STHS34PF80_Telemetry::fit(const sths34pf80_sample_t* samples,
+                                            uint16_t count,
+                                            const sths34pf80_frame_info_t& info,
+                                            size_t max_len) {
+  // Frame size grows with the sample count, so bisect on it
+  uint16_t lo = 0;
+  uint16_t hi = count;
+  while (lo < hi) {
+    uint16_t mid = lo + (hi - lo + 1) / 2;
+    if (encodedSize(samples, mid, info) <= max_len) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
+
+/*!
+ * @brief Encode a batch of samples into one frame
+ * @param samples Samples to encode
+ * @param count Number of samples
+ * @param info Header fields (channels, config_hash, timestamp_ms, period_ms)
+ * @param frame Output buffer
+ * @param max_len Output buffer size
+ * @return Frame length in bytes, 0 if it does not fit
+ */
+size_t Adafruit_STHS34PF80_Telemetry::encode(
+    const sths34pf80_sample_t* samples, uint16_t count,
+    const sths34pf80_frame_info_t& info, uint8_t* frame, size_t max_len) {
+  if (!frame || (count && !samples)) {
+    return 0;
+  }
+
+  sths34pf80_writer_t w = {frame, max_len, 0};
+  writeFrame(samples, count, info, &w);
+  if (w.len + 2 > max_len) {
+    return 0;
+  }
+
+  uint16_t crc = crc16(frame, w.len);
+  putByte(&w, (uint8_t)crc);
+  putByte(&w, (uint8_t)(crc >> 8));
+  return w.len;
+}
+
+/*!
+ * @brief Decode and verify one frame
+ * @param frame The frame
+ * @param len Frame length
+ * @param info Set to the header fields
+ * @param samples Set to the samples; channels not in the frame are 0
+ * @param max_samples Capacity of samples
+ * @return False on a bad magic, version, length or CRC, or if the frame
+ * holds more than max_samples samples
+ */
+bool Adafruit_STHS34PF80_Telemetry::decode(const uint8_t* frame, size_t len,
+                                           sths34pf80_frame_info_t* info,
+                                           sths34pf80_sample_t* samples,
+                                           uint16_t max_samples) {
+  if (!frame || !info || len < STHS34PF80_TELEMETRY_FIXED_LEN + 2) {
+    return false;
+  }
+  uint16_t crc = frame[len - 2] | ((uint16_t)frame[len - 1] << 8);
+  if (crc != crc16(frame, len - 2)) {
+    return false;
+  }
+
+  sths34pf80_reader_t r = {frame, len - 2, 0, false};
+  if (getByte(&r) != STHS34PF80_TELEMETRY_MAGIC) {
+    return false;
+  }
+  info->version = getByte(&r);
+  if (info->version != STHS34PF80_TELEMETRY_VERSION) {
+    return false;
+  }
+  info->channels = getByte(&r) & STHS34PF80_TELEMETRY_ALL;
+  info->config_hash = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    info->config_hash |= (uint32_t)getByte(&r) << (8 * i);
+  }
+  info->timestamp_ms = getVarint(&r);
+  info->period_ms = getVarint(&r);
+  uint32_t count = getVarint(&r);
+  if (r.error || count > 0xFFFF) {
+    return false;
+  }
+  info->count = (uint16_t)count;
+  if (count > max_samples || (count && !samples)) {
+    return false;
+  }
+
+  uint16_t acc = 0;
+  uint8_t bits = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    if (bits < STHS34PF80_TELEMETRY_FLAG_BITS) {
+      acc |= (uint16_t)getByte(&r) << bits;
+      bits += 8;
+    }
+    samples[i].flags = acc & 0x07;
+    acc >>= STHS34PF80_TELEMETRY_FLAG_BITS;
+    bits -= STHS34PF80_TELEMETRY_FLAG_BITS;
+  }
+
+  for (uint8_t c = 0; c < STHS34PF80_TELEMETRY_CHANNELS; c++) {
+    bool present = info->channels & (1 << c);
+    int32_t value = 0;
+    for (uint16_t i = 0; i < count; i++) {
+      if (present) {
+        value += unzigzag(getVarint(&r));
+      }
+      *channel(&samples[i], c) = (int16_t)value;
+    }
+  }
+
+  // Trailing bytes mean the frame does not match this format version
+  return !r.error && r.pos == r.len;
+}
+
+/*!
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ * @param data Bytes to check
+ * @param len Number of bytes
+ * @return The CRC
+ */
+uint16_t Adafruit_STHS34PF80_Telemetry::crc16(const uint8_t* data,
+                                              size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
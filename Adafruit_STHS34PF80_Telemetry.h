@@ -0,0 +1,74 @@
+/*!
+ * @file Adafruit_STHS34PF80_Telemetry.h
+ *
+ * Compact, versioned binary frames for uplinking STHS34PF80 sample batches.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_TELEMETRY_H__
+#define __ADAFRUIT_STHS34PF80_TELEMETRY_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+#define STHS34PF80_TELEMETRY_MAGIC 0xB5   ///< First byte of every frame
+#define STHS34PF80_TELEMETRY_VERSION 0x01 ///< Frame format version
+
+#define STHS34PF80_TELEMETRY_OBJECT 0x01     ///< TOBJECT channel
+#define STHS34PF80_TELEMETRY_AMBIENT 0x02    ///< TAMBIENT channel
+#define STHS34PF80_TELEMETRY_OBJ_COMP 0x04   ///< TOBJ_COMP channel
+#define STHS34PF80_TELEMETRY_PRESENCE 0x08   ///< TPRESENCE channel
+#define STHS34PF80_TELEMETRY_MOTION 0x10     ///< TMOTION channel
+#define STHS34PF80_TELEMETRY_TEMP_SHOCK 0x20 ///< TAMB_SHOCK channel
+#define STHS34PF80_TELEMETRY_ALL 0x3F        ///< All six channels
+
+/*!
+ * @brief Frame header fields
+ */
+typedef struct {
+  uint8_t version;       ///< Frame format version (set by decode())
+  uint8_t channels;      ///< STHS34PF80_TELEMETRY_* channel mask
+  uint16_t count;        ///< Samples in the frame (set by decode())
+  uint32_t config_hash;  ///< Adafruit_STHS34PF80::configHash() of the sensor
+  uint32_t timestamp_ms; ///< Time of the first sample
+  uint32_t period_ms;    ///< Time between samples
+} sths34pf80_frame_info_t;
+
+/*!
+ * @brief Class with the telemetry frame encoder and decoder
+ *
+ * Frame layout, all multi-byte fixed fields little endian:
+ *
+ *   magic (1) | version (1) | channel mask (1) | config hash (4)
+ *   varint timestamp_ms | varint period_ms | varint count
+ *   flags: 3 bits per sample (FUNC_STATUS 2:0), LSB first, zero padded
+ *   per enabled channel, in mask bit order: zigzag varint of the first
+ *   value, then zigzag varints of the sample-to-sample deltas
+ *   CRC-16/CCITT-FALSE over everything above (2)
+ *
+ * Nothing is allocated; frames are written to and read from caller
+ * buffers.
+ */
+class Adafruit_STHS34PF80_Telemetry {
+ public:
+  static size_t encodedSize(const sths34pf80_sample_t* samples,
+                            uint16_t count,
+                            const sths34pf80_frame_info_t& info);
+  static uint16_t fit(const sths34pf80_sample_t* samples, uint16_t count,
+                      const sths34pf80_frame_info_t& info, size_t max_len);
+  static size_t encode(const sths34pf80_sample_t* samples, uint16_t count,
+                       const sths34pf80_frame_info_t& info, uint8_t* frame,
+                       size_t max_len);
+  static bool decode(const uint8_t* frame, size_t len,
+                     sths34pf80_frame_info_t* info,
+                     sths34pf80_sample_t* samples, uint16_t max_samples);
+
+  static uint16_t crc16(const uint8_t* data, size_t len);
+};
+
+#endif
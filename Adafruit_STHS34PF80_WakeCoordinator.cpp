@@ -0,0 +1,233 @@
+/*!
+ * @file Adafruit_STHS34PF80_WakeCoordinator.cpp
+ *
+ * Wake-on-presence coordinator for the STHS34PF80.
+ *
+ * The watch profile keeps the sensor at a low ODR with INT_OR routed to the
+ * INT pin and latched, so the MCU can sleep until someone walks in. onWake()
+ * restores the active profile through Adafruit_STHS34PF80::applyProfile(),
+ * which only touches the registers that differ, and poll() timestamps the
+ * first data-ready sample to report the wake-to-first-sample latency.
+ *
+ * Time and the INT line are sampled through function pointers so the
+ * coordinator can be driven by a simulated clock and interrupt line.
+ *
+ * MIT license, all text here must be included in any redistribution
+ *
+ */
+
+#include "Adafruit_STHS34PF80_WakeCoordinator.h"
+
+/*!
+ * @brief Instantiates a coordinator with the default watch and active
+ * profiles
+ * @param sensor The initialized sensor to coordinate
+ */
+Adafruit_STHS34PF80_WakeCoordinator::Adafruit_STHS34PF80_WakeCoordinator(
+    Adafruit_STHS34PF80* sensor)
+    : _sensor(sensor),
+      _micros(NULL),
+      _int_line(NULL),
+      _state(STHS34PF80_WAKE_IDLE),
+      _wake_flags(0),
+      _wake_micros(0),
+      _latency(0) {
+  // 1 Hz with 128-sample averaging is the datasheet default noise/power
+  // trade-off and keeps presence latency around one second
+  _watch.odr = STHS34PF80_ODR_1_HZ;
+  _watch.avg_tmos = STHS34PF80_AVG_TMOS_128;
+  _watch.avg_t = STHS34PF80_AVG_T_8;
+  _watch.int_signal = STHS34PF80_INT_OR;
+  _watch.int_mask = STHS34PF80_PRES_FLAG;
+  _watch.int_latched = true;
+
+  _active.odr = STHS34PF80_ODR_15_HZ;
+  _active.avg_tmos = STHS34PF80_AVG_TMOS_32;
+  _active.avg_t = STHS34PF80_AVG_T_8;
+  _active.int_signal = STHS34PF80_INT_DRDY;
+  _active.int_mask = 0;
+  _active.int_latched = false;
+}
+
+/*!
+ * @brief Set the profile used while waiting for presence
+ * @param profile Watch profile, must route INT_OR with a non-empty mask and a
+ * non-zero ODR
+ * @return True if the profile was accepted, false otherwise
+ */
+bool Adafruit_STHS34PF80_WakeCoordinator::setWatchProfile(
+    const sths34pf80_profile_t& profile) {
+  if (!Adafruit_STHS34PF80::isValidProfile(profile) ||
+      profile.odr == STHS34PF80_ODR_POWER_DOWN ||
+      profile.int_signal != STHS34PF80_INT_OR || profile.int_mask == 0) {
+    return false;
+  }
+
+  _watch = profile;
+  return true;
+}
+
+/*!
+ * @brief Set the profile restored after wake-up
+ * @param profile Active profile, must have a non-zero ODR
+ * @return True if the profile was accepted, false otherwise
+ */
+bool Adafruit_STHS34PF80_WakeCoordinator::setActiveProfile(
+    const sths34pf80_profile_t& profile) {
+  if (!Adafruit_STHS34PF80::isValidProfile(profile) ||
+      profile.odr == STHS34PF80_ODR_POWER_DOWN) {
+    return false;
+  }
+
+  _active = profile;
+  return true;
+}
+
+/*!
+ * @brief Replace the microsecond time source
+ * @param micros_fn Time source, or NULL to use the sensor's clock
+ */
+void Adafruit_STHS34PF80_WakeCoordinator::setTimeSource(
+    sths34pf80_micros_fn_t micros_fn) {
+  _micros = micros_fn;
+}
+
+/*!
+ * @brief Read the time source
+ * @return Microseconds from setTimeSource() or the sensor's clock
+ */
+uint32_t Adafruit_STHS34PF80_WakeCoordinator::now() {
+  if (_micros) {
+    return _micros();
+  }
+  return _sensor ? _sensor->getClock()->getMicros()
+                 : Adafruit_STHS34PF80_Clock::system()->getMicros();
+}
+
+/*!
+ * @brief Set the sampler used to check the INT line
+ * @param int_line_fn Sampler returning true while INT is asserted, or NULL to
+ * poll FUNC_STATUS over the bus instead
+ */
+void Adafruit_STHS34PF80_WakeCoordinator::setInterruptLine(
+    sths34pf80_int_line_fn_t int_line_fn) {
+  _int_line = int_line_fn;
+}
+
+/*!
+ * @brief Apply the watch profile and arm the latched presence interrupt
+ * @return True if successful, false otherwise
+ */
+bool Adafruit_STHS34PF80_WakeCoordinator::enterWatchMode() {
+  if (!_sensor || !_sensor->applyProfile(_watch)) {
+    return false;
+  }
+
+  // Drop any flag left over from the active phase so INT starts deasserted
+  _sensor->readFuncStatus();
+
+  _wake_flags = 0;
+  _state = STHS34PF80_WAKE_WATCHING;
+  return true;
+}
+
+/*!
+ * @brief Check whether the watch profile has raised a wake-up
+ * @note Without an INT line sampler this polls FUNC_STATUS, which consumes
+ * the flags; they are kept and reported by wakeFlags()
+ * @return True if the coordinator is watching and a wake-up is pending
+ */
+bool Adafruit_STHS34PF80_WakeCoordinator::wakePending() {
+  if (_state != STHS34PF80_WAKE_WATCHING) {
+    return false;
+  }
+
+  if (_int_line) {
+    return _int_line();
+  }
+
+  _wake_flags |= _sensor->readFuncStatus() & _watch.int_mask;
+  return _wake_flags != 0;
+}
+
+/*!
+ * @brief Handle a wake-up using the current time as the wake timestamp
+ * @return True if the active profile was applied, false otherwise
+ */
+bool Adafruit_STHS34PF80_WakeCoordinator::onWake() {
+  return onWake(now());
+}
+
+/*!
+ * @brief Handle a wake-up: clear the latched INT and apply the active profile
+ * @param wake_micros Time the wake-up happened, e.g. captured in the ISR
+ * @return True if the active profile was applied, false otherwise
+ */
+bool Adafruit_STHS34PF80_WakeCoordinator::onWake(uint32_t wake_micros) {
+  if (!_sensor) {
+    return false;
+  }
+
+  _wake_micros = wake_micros;
+  _latency = 0;
+
+  // Reading FUNC_STATUS releases the latched INT line
+  _wake_flags |= _sensor->readFuncStatus();
+
+  if (!_sensor->applyProfile(_active)) {
+    _state = STHS34PF80_WAKE_IDLE;
+    return false;
+  }
+
+  _state = STHS34PF80_WAKE_WAITING;
+  return true;
+}
+
+/*!
+ * @brief Check for a new sample after wake-up, one STATUS read per call
+ *
+ * The first data-ready sample after onWake() fixes the wake-to-first-sample
+ * latency.
+ * @return True if a new sample is ready to be read
+ */
+bool Adafruit_STHS34PF80_WakeCoordinator::poll() {
+  if (_state != STHS34PF80_WAKE_WAITING && _state != STHS34PF80_WAKE_ACTIVE) {
+    return false;
+  }
+
+  if (!_sensor->isDataReady()) {
+    return false;
+  }
+
+  if (_state == STHS34PF80_WAKE_WAITING) {
+    _latency = now() - _wake_micros;
+    _state = STHS34PF80_WAKE_ACTIVE;
+  }
+
+  return true;
+}
+
+/*!
+ * @brief Get the coordinator state
+ * @return The current state
+ */
+sths34pf80_wake_state_t Adafruit_STHS34PF80_WakeCoordinator::state() {
+  return _state;
+}
+
+/*!
+ * @brief Get the function flags that caused the last wake-up
+ * @return Flag bits (STHS34PF80_PRES_FLAG, STHS34PF80_MOT_FLAG,
+ * STHS34PF80_TAMB_SHOCK_FLAG)
+ */
+uint8_t Adafruit_STHS34PF80_WakeCoordinator::wakeFlags() {
+  return _wake_flags;
+}
+
+/*!
+ * @brief Get the time from the last wake-up to its first data-ready sample
+ * @return Latency in microseconds, or 0 if no sample has been seen yet
+ */
+uint32_t Adafruit_STHS34PF80_WakeCoordinator::wakeLatencyMicros() {
+  return _latency;
+}
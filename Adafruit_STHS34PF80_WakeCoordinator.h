@@ -0,0 +1,77 @@
+/*!
+ * @file Adafruit_STHS34PF80_WakeCoordinator.h
+ *
+ * Wake-on-presence coordinator for the STHS34PF80. Switches the sensor
+ * between a low-power watch profile that raises INT on presence and a fast
+ * active profile used once the host has woken up.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_WAKECOORDINATOR_H__
+#define __ADAFRUIT_STHS34PF80_WAKECOORDINATOR_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+/*!
+ * @brief Coordinator state
+ */
+typedef enum {
+  STHS34PF80_WAKE_IDLE = 0x00,     ///< No profile applied by the coordinator
+  STHS34PF80_WAKE_WATCHING = 0x01, ///< Watch profile active, waiting for INT
+  STHS34PF80_WAKE_WAITING = 0x02,  ///< Active profile applied, no sample yet
+  STHS34PF80_WAKE_ACTIVE = 0x03,   ///< Active profile delivering samples
+} sths34pf80_wake_state_t;
+
+/*!
+ * @brief Time source returning a free-running microsecond counter
+ */
+typedef uint32_t (*sths34pf80_micros_fn_t)(void);
+
+/*!
+ * @brief Interrupt line sampler, returns true while INT is asserted
+ */
+typedef bool (*sths34pf80_int_line_fn_t)(void);
+
+/*!
+ * @brief Class that moves an STHS34PF80 between watch and active profiles
+ */
+class Adafruit_STHS34PF80_WakeCoordinator {
+ public:
+  Adafruit_STHS34PF80_WakeCoordinator(Adafruit_STHS34PF80* sensor);
+
+  bool setWatchProfile(const sths34pf80_profile_t& profile);
+  bool setActiveProfile(const sths34pf80_profile_t& profile);
+  void setTimeSource(sths34pf80_micros_fn_t micros_fn);
+  void setInterruptLine(sths34pf80_int_line_fn_t int_line_fn);
+
+  bool enterWatchMode();
+  bool wakePending();
+  bool onWake();
+  bool onWake(uint32_t wake_micros);
+  bool poll();
+
+  sths34pf80_wake_state_t state();
+  uint8_t wakeFlags();
+  uint32_t wakeLatencyMicros();
+
+ private:
+  uint32_t now();
+
+  Adafruit_STHS34PF80* _sensor;
+  sths34pf80_profile_t _watch;
+  sths34pf80_profile_t _active;
+  sths34pf80_micros_fn_t _micros;
+  sths34pf80_int_line_fn_t _int_line;
+  sths34pf80_wake_state_t _state;
+  uint8_t _wake_flags;
+  uint32_t _wake_micros;
+  uint32_t _latency;
+};
+
+#endif
@@ -0,0 +1,392 @@
+/*!
+ * @file Adafruit_STHS34PF80_ZoneAggregator.h
+ *
+ * Zone-level occupancy from many STHS34PF80 sensors.
+ *
+ * Each sensor covers one or more zones with an overlap weight. Per frame,
+ * every fresh sensor turns its TPRESENCE into a person estimate (Q8,
+ * relative to the signal one person gives that sensor) and splits it over
+ * its zones in proportion to its overlaps. A zone adds up what its sensors
+ * report and divides by its coverage redundancy, the summed overlap but at
+ * least one full coverage: two sensors that each see half of a zone add
+ * up to one person, two that both see all of it do not count them twice.
+ * The result is rounded with hysteresis. Count changes produce ENTER and
+ * LEAVE events; a zone that empties again within the pass-through time
+ * produces PASS_THROUGH instead of LEAVE.
+ *
+ * State is kept as parallel arrays (struct of arrays) sized at compile
+ * time, so process() streams through a few small contiguous arrays: per
+ * frame it costs about MAX_LINKS multiply-adds and divides per sensor and
+ * one divide per zone: well under a millisecond for hundreds of sensors on a
+ * Cortex-M4, a fraction of a microsecond on a gateway CPU.
+ *
+ * Usage:
+ *
+ *   Adafruit_STHS34PF80_ZoneAggregator<128, 16> zones;
+ *   zones.addCoverage(0, HALL, 256);
+ *   zones.addCoverage(1, HALL, 128); // sensor 1 sees half the hall
+ *   zones.addCoverage(1, ROOM_A, 128);
+ *   ...
+ *   zones.setSample(0, sample0);
+ *   zones.setSample(1, sample1);
+ *   zones.process(millis());
+ *   sths34pf80_zone_event_t event;
+ *   while (zones.readEvent(&event)) { ... }
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ *
+ */
+
+#ifndef __ADAFRUIT_STHS34PF80_ZONEAGGREGATOR_H__
+#define __ADAFRUIT_STHS34PF80_ZONEAGGREGATOR_H__
+
+#include "Adafruit_STHS34PF80.h"
+
+#define STHS34PF80_ZONE_EVENTS 16 ///< Event queue length (power of two)
+#define STHS34PF80_ZONE_NONE 0xFF ///< Unused coverage link
+
+/*!
+ * @brief Zone transition events
+ */
+typedef enum {
+  STHS34PF80_ZONE_ENTER = 0x01,        ///< Zone count went up
+  STHS34PF80_ZONE_LEAVE = 0x02,        ///< Zone count went down
+  STHS34PF80_ZONE_PASS_THROUGH = 0x03, ///< Zone emptied within pass time
+} sths34pf80_zone_event_type_t;
+
+/*!
+ * @brief One zone transition
+ */
+typedef struct {
+  sths34pf80_zone_event_type_t type; ///< What happened
+  uint8_t zone;                      ///< Zone index
+  uint8_t count;                     ///< Zone count after the event
+  uint32_t timestamp_ms;             ///< Frame time of the event
+  uint32_t dwell_ms;                 ///< Time the zone had been occupied
+} sths34pf80_zone_event_t;
+
+/*!
+ * @brief Class that aggregates many sensors into zone occupancy counts
+ * @tparam MAX_SENSORS Sensor capacity
+ * @tparam MAX_ZONES Zone capacity, at most 255
+ * @tparam MAX_LINKS Zones one sensor can cover
+ */
+template <uint16_t MAX_SENSORS, uint8_t MAX_ZONES, uint8_t MAX_LINKS = 2>
+class Adafruit_STHS34PF80_ZoneAggregator {
+ public:
+  static_assert(MAX_ZONES < STHS34PF80_ZONE_NONE, "At most 254 zones");
+
+  /*!
+   * @brief Instantiates an aggregator with no coverage
+   */
+  Adafruit_STHS34PF80_ZoneAggregator()
+      : _hysteresis(48), _stale_frames(3), _pass_ms(3000) {
+    for (uint16_t s = 0; s < MAX_SENSORS; s++) {
+      _weight[s] = 256;
+      _level[s] = 1000;
+      for (uint8_t l = 0; l < MAX_LINKS; l++) {
+        _link_zone[s * MAX_LINKS + l] = STHS34PF80_ZONE_NONE;
+        _link_overlap[s * MAX_LINKS + l] = 0;
+      }
+    }
+    reset();
+  }
+
+  /*!
+   * @brief Forget the samples, counts and pending events, keeping the
+   * coverage map and tuning
+   */
+  void reset() {
+    for (uint16_t s = 0; s < MAX_SENSORS; s++) {
+      _presence[s] = 0;
+      _flags[s] = 0;
+      _age[s] = 0xFF;
+    }
+    for (uint8_t z = 0; z < MAX_ZONES; z++) {
+      _zone_estimate[z] = 0;
+      _zone_count[z] = 0;
+      _zone_since[z] = 0;
+    }
+    _event_head = 0;
+    _event_tail = 0;
+  }
+
+  /*!
+   * @brief Let a sensor contribute to a zone
+   * @param sensor Sensor index
+   * @param zone Zone index
+   * @param overlap Share of the zone the sensor sees, Q8 (256 = all of it)
+   * @return False on a bad index or if the sensor has MAX_LINKS zones
+   */
+  bool addCoverage(uint16_t sensor, uint8_t zone, uint16_t overlap) {
+    if (sensor >= MAX_SENSORS || zone >= MAX_ZONES) {
+      return false;
+    }
+    for (uint8_t l = 0; l < MAX_LINKS; l++) {
+      uint16_t i = sensor * MAX_LINKS + l;
+      if (_link_zone[i] == STHS34PF80_ZONE_NONE || _link_zone[i] == zone) {
+        _link_zone[i] = zone;
+        _link_overlap[i] = overlap;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*!
+   * @brief Set how much a sensor is trusted relative to the others
+   * @param sensor Sensor index
+   * @param weight Q8 weight (default 256), 0 to ignore the sensor
+   * @return False on a bad index
+   */
+  bool setSensorWeight(uint16_t sensor, uint16_t weight) {
+    if (sensor >= MAX_SENSORS) {
+      return false;
+    }
+    _weight[sensor] = weight;
+    return true;
+  }
+
+  /*!
+   * @brief Set the TPRESENCE one person produces at a sensor
+   * @param sensor Sensor index
+   * @param level Presence LSB per person (default 1000)
+   * @return False on a bad index or a level of 0
+   */
+  bool setPersonLevel(uint16_t sensor, int16_t level) {
+    if (sensor >= MAX_SENSORS || level <= 0) {
+      return false;
+    }
+    _level[sensor] = level;
+    return true;
+  }
+
+  /*!
+   * @brief Set the count rounding hysteresis
+   * @param hysteresis Q8 persons beyond the half-way point needed to change
+   * a count (default 48)
+   */
+  void setHysteresis(uint8_t hysteresis) { _hysteresis = hysteresis; }
+
+  /*!
+   * @brief Set after how many frames without a sample a sensor is dropped
+   * @param frames Frames (default 3)
+   */
+  void setStaleFrames(uint8_t frames) { _stale_frames = frames; }
+
+  /*!
+   * @brief Set the longest stay that still counts as passing through
+   * @param pass_ms Milliseconds (default 3000)
+   */
+  void setPassThroughTime(uint32_t pass_ms) { _pass_ms = pass_ms; }
+
+  /*!
+   * @brief Store a sensor's sample for the next frame
+   * @param sensor Sensor index
+   * @param presence Raw TPRESENCE value
+   * @param flags FUNC_STATUS flag bits
+   * @return False on a bad index
+   */
+  bool setSample(uint16_t sensor, int16_t presence, uint8_t flags) {
+    if (sensor >= MAX_SENSORS) {
+      return false;
+    }
+    _presence[sensor] = presence;
+    _flags[sensor] = flags;
+    _age[sensor] = 0;
+    return true;
+  }
+
+  /*!
+   * @brief Store a sample read with Adafruit_STHS34PF80::readSample()
+   * @param sensor Sensor index
+   * @param sample The sample
+   * @return False on a bad index
+   */
+  bool setSample(uint16_t sensor, const sths34pf80_sample_t& sample) {
+    return setSample(sensor, sample.presence, sample.flags);
+  }
+
+  /*!
+   * @brief Update every zone from the stored samples and queue events
+   * @param now_ms Frame time in milliseconds
+   */
+  void process(uint32_t now_ms) {
+    // Q16 persons reported into each zone, and its Q8 summed coverage
+    int64_t num[MAX_ZONES];
+    uint32_t den[MAX_ZONES];
+    for (uint8_t z = 0; z < MAX_ZONES; z++) {
+      num[z] = 0;
+      den[z] = 0;
+    }
+
+    for (uint16_t s = 0; s < MAX_SENSORS; s++) {
+      if (_age[s] > _stale_frames) {
+        continue;
+      }
+      if (_age[s] < 0xFF) {
+        _age[s]++;
+      }
+
+      // Persons seen by this sensor, Q8, only while it reports presence
+      int32_t persons = 0;
+      if ((_flags[s] & STHS34PF80_PRES_FLAG) && _presence[s] > 0) {
+        persons = ((int32_t)_presence[s] << 8) / _level[s];
+      }
+
+      // A sensor spanning several zones shares its persons between them
+      uint32_t overlap = 0;
+      for (uint8_t l = 0; l < MAX_LINKS; l++) {
+        uint16_t i = s * MAX_LINKS + l;
+        if (_link_zone[i] == STHS34PF80_ZONE_NONE) {
+          break;
+        }
+        overlap += _link_overlap[i];
+      }
+      if (!overlap) {
+        continue;
+      }
+
+      for (uint8_t l = 0; l < MAX_LINKS; l++) {
+        uint16_t i = s * MAX_LINKS + l;
+        uint8_t z = _link_zone[i];
+        if (z == STHS34PF80_ZONE_NONE) {
+          break;
+        }
+        num[z] += (int64_t)_weight[s] * persons * _link_overlap[i] / overlap;
+        den[z] += ((uint32_t)_weight[s] * _link_overlap[i]) >> 8;
+      }
+    }
+
+    for (uint8_t z = 0; z < MAX_ZONES; z++) {
+      // Zones no fresh sensor covers keep their last count
+      if (!den[z]) {
+        continue;
+      }
+      int64_t persons = num[z] / (den[z] > 256 ? den[z] : 256);
+      uint16_t estimate = persons > 0xFFFF ? 0xFFFF : (uint16_t)persons;
+      _zone_estimate[z] = estimate;
+
+      // Only move to a new count once the estimate is past the half-way
+      // point by the hysteresis, so a borderline person does not flicker
+      uint8_t count = _zone_count[z];
+      uint32_t current = (uint32_t)count << 8;
+      uint16_t target = (estimate + 128) >> 8;
+      if (target > 255) {
+        target = 255;
+      }
+      if (target > count && estimate >= current + 128 + _hysteresis) {
+        updateCount(z, target, now_ms);
+      } else if (target < count &&
+                 (uint32_t)estimate + 128 + _hysteresis <= current) {
+        updateCount(z, target, now_ms);
+      }
+    }
+  }
+
+  /*!
+   * @brief Get a zone's occupancy count
+   * @param zone Zone index
+   * @return Estimated number of people, 0 on a bad index
+   */
+  uint8_t zoneCount(uint8_t zone) {
+    return zone < MAX_ZONES ? _zone_count[zone] : 0;
+  }
+
+  /*!
+   * @brief Get a zone's unrounded occupancy estimate
+   * @param zone Zone index
+   * @return Estimated number of people, Q8, 0 on a bad index
+   */
+  uint16_t zoneEstimate(uint8_t zone) {
+    return zone < MAX_ZONES ? _zone_estimate[zone] : 0;
+  }
+
+  /*!
+   * @brief Get the total count over all zones
+   * @return Sum of the zone counts
+   */
+  uint16_t totalCount() {
+    uint16_t total = 0;
+    for (uint8_t z = 0; z < MAX_ZONES; z++) {
+      total += _zone_count[z];
+    }
+    return total;
+  }
+
+  /*!
+   * @brief Take the oldest queued event
+   * @param event Set to the event
+   * @return False if no event is queued
+   */
+  bool readEvent(sths34pf80_zone_event_t* event) {
+    if (_event_head == _event_tail) {
+      return false;
+    }
+    *event = _events[_event_tail];
+    _event_tail = (_event_tail + 1) % STHS34PF80_ZONE_EVENTS;
+    return true;
+  }
+
+ private:
+  /*!
+   * @brief Change a zone's count and queue the matching event
+   * @param zone Zone index
+   * @param count New count
+   * @param now_ms Frame time in milliseconds
+   */
+  void updateCount(uint8_t zone, uint8_t count, uint32_t now_ms) {
+    uint8_t previous = _zone_count[zone];
+    uint32_t dwell = previous ? now_ms - _zone_since[zone] : 0;
+    sths34pf80_zone_event_type_t type = STHS34PF80_ZONE_ENTER;
+
+    if (count < previous) {
+      type = (count == 0 && dwell <= _pass_ms) ? STHS34PF80_ZONE_PASS_THROUGH
+                                               : STHS34PF80_ZONE_LEAVE;
+    }
+    if (previous == 0) {
+      _zone_since[zone] = now_ms;
+    }
+    _zone_count[zone] = count;
+
+    // Drop the oldest event when the queue is full
+    uint8_t next = (_event_head + 1) % STHS34PF80_ZONE_EVENTS;
+    if (next == _event_tail) {
+      _event_tail = (_event_tail + 1) % STHS34PF80_ZONE_EVENTS;
+    }
+    sths34pf80_zone_event_t* event = &_events[_event_head];
+    event->type = type;
+    event->zone = zone;
+    event->count = count;
+    event->timestamp_ms = now_ms;
+    event->dwell_ms = dwell;
+    _event_head = next;
+  }
+
+  // Per sensor
+  int16_t _presence[MAX_SENSORS];
+  int16_t _level[MAX_SENSORS];
+  uint16_t _weight[MAX_SENSORS];
+  uint8_t _flags[MAX_SENSORS];
+  uint8_t _age[MAX_SENSORS];
+  // Per coverage link, MAX_LINKS per sensor
+  uint8_t _link_zone[MAX_SENSORS * MAX_LINKS];
+  uint16_t _link_overlap[MAX_SENSORS * MAX_LINKS];
+  // Per zone
+  uint16_t _zone_estimate[MAX_ZONES];
+  uint8_t _zone_count[MAX_ZONES];
+  uint32_t _zone_since[MAX_ZONES];
+
+  sths34pf80_zone_event_t _events[STHS34PF80_ZONE_EVENTS];
+  uint8_t _event_head;
+  uint8_t _event_tail;
+  uint8_t _hysteresis;
+  uint8_t _stale_frames;
+  uint32_t _pass_ms;
+};
+
+#endif
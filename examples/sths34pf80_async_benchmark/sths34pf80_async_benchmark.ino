@@ -0,0 +1,218 @@
+// Coroutine vs thread-per-sensor benchmark for the STHS34PF80
+//
+// Drives simulated sensors in real time through the same session twice:
+// once with one std::thread per sensor calling the blocking driver, once
+// with every sensor as a coroutine on a single Adafruit_STHS34PF80_Loop.
+// Each session reads samples at 8 Hz, rewrites the presence threshold
+// (power-down, embedded write, restore), reads at 4 Hz and powers down.
+// Reports wall time, CPU time, peak memory and sample counts, then scales
+// the coroutine run up. No sensor is needed.
+//
+// Linux only, compiled as C++20 or later (e.g. -std=c++20).
+
+#include "Adafruit_STHS34PF80.h"
+
+#if defined(__linux__) && defined(__cpp_impl_coroutine)
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Adafruit_STHS34PF80_Async.h"
+#include "Adafruit_STHS34PF80_Sim.h"
+
+#define SENSORS 500    // Sensors in the head-to-head runs
+#define SCALE_UP 10    // Coroutine run with SCALE_UP x SENSORS sensors
+#define PHASE_MS 3000  // Reading time at each rate
+#define THRESHOLD 300  // Presence threshold written mid-session
+
+// Real-time clock that sleeps only the calling thread
+class ThreadClock : public Adafruit_STHS34PF80_Clock {
+ public:
+  uint32_t getMillis() { return getMicros() / 1000; }
+  uint32_t getMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+  void delayMillis(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+};
+
+ThreadClock thread_clock;
+
+// One simulated sensor and its driver
+struct Node {
+  Node() : sim(&thread_clock), samples(0), ok(true) {}
+  Adafruit_STHS34PF80_Sim sim;
+  Adafruit_STHS34PF80 sths;
+  uint32_t samples;
+  bool ok;
+};
+
+std::vector<std::unique_ptr<Node> > makeNodes(uint32_t count) {
+  std::vector<std::unique_ptr<Node> > nodes;
+  Adafruit_STHS34PF80_SimClock boot_clock; // the simulated part boots at once
+  for (uint32_t i = 0; i < count; i++) {
+    nodes.emplace_back(new Node());
+    Node* node = nodes.back().get();
+    node->sim.setSeed(i + 1);
+    node->sths.setClock(&boot_clock);
+    node->ok = node->sths.begin(node->sim.device());
+    node->sths.setClock(&thread_clock);
+  }
+  return nodes;
+}
+
+uint64_t cpuMicros() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+long peakRssKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Blocking session, run on its own thread
+void blockingSession(Node* node) {
+  uint8_t ths[2] = {THRESHOLD & 0xFF, THRESHOLD >> 8};
+  const sths34pf80_odr_t rates[] = {STHS34PF80_ODR_8_HZ, STHS34PF80_ODR_4_HZ};
+  sths34pf80_sample_t sample;
+
+  for (uint8_t phase = 0; phase < 2; phase++) {
+    if (phase == 1 && !node->sths.writeEmbeddedFunction(
+                          STHS34PF80_EMBEDDED_PRESENCE_THS, ths, 2)) {
+      node->ok = false;
+    }
+    if (!node->sths.setOutputDataRate(rates[phase])) {
+      node->ok = false;
+      return;
+    }
+    uint32_t end = thread_clock.getMillis() + PHASE_MS;
+    while ((int32_t)(thread_clock.getMillis() - end) < 0) {
+      if (!node->sths.isDataReady()) {
+        thread_clock.delayMillis(1);
+        continue;
+      }
+      if (node->sths.readSample(&sample)) {
+        node->samples++;
+      }
+    }
+  }
+  node->ok = node->sths.setOutputDataRate(STHS34PF80_ODR_POWER_DOWN) &&
+             node->ok;
+}
+
+// The same session as a coroutine
+Adafruit_STHS34PF80_Task<void> asyncSession(Adafruit_STHS34PF80_Loop* loop,
+                                            Node* node) {
+  Adafruit_STHS34PF80_AsyncSensor session(loop, &node->sths);
+  uint8_t ths[2] = {THRESHOLD & 0xFF, THRESHOLD >> 8};
+  const sths34pf80_odr_t rates[] = {STHS34PF80_ODR_8_HZ, STHS34PF80_ODR_4_HZ};
+  sths34pf80_sample_t sample;
+
+  for (uint8_t phase = 0; phase < 2; phase++) {
+    if (phase == 1 && !co_await session.writeEmbeddedFunctionAsync(
+                          STHS34PF80_EMBEDDED_PRESENCE_THS, ths, 2)) {
+      node->ok = false;
+    }
+    if (!co_await session.setOutputDataRateAsync(rates[phase])) {
+      node->ok = false;
+      co_return;
+    }
+    uint64_t end = loop->nowMicros() + PHASE_MS * 1000ULL;
+    while (loop->nowMicros() < end) {
+      if (co_await session.nextSample(&sample)) {
+        node->samples++;
+      }
+    }
+  }
+  node->ok = co_await session.setOutputDataRateAsync(
+                 STHS34PF80_ODR_POWER_DOWN) &&
+             node->ok;
+}
+
+void report(const char* name, uint32_t sensors, uint32_t threads,
+            uint32_t wall_us, uint64_t cpu_us,
+            const std::vector<std::unique_ptr<Node> >& nodes) {
+  uint64_t samples = 0;
+  uint32_t failed = 0;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    samples += nodes[i]->samples;
+    failed += !nodes[i]->ok;
+  }
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(sensors);
+  Serial.print(" sensors, ");
+  Serial.print(threads);
+  Serial.print(" threads, wall ");
+  Serial.print(wall_us / 1e6, 2);
+  Serial.print(" s, CPU ");
+  Serial.print(cpu_us / 1e6, 2);
+  Serial.print(" s, ");
+  Serial.print((double)samples / sensors, 1);
+  Serial.print(" samples/sensor, ");
+  Serial.print((double)cpu_us / samples, 2);
+  Serial.print(" CPU us/sample, peak RSS ");
+  Serial.print(peakRssKb() / 1024.0, 1);
+  Serial.print(" MB, failed ");
+  Serial.println(failed);
+}
+
+void runAsync(uint32_t sensors) {
+  std::vector<std::unique_ptr<Node> > nodes = makeNodes(sensors);
+  Adafruit_STHS34PF80_Loop event_loop;
+  uint64_t cpu = cpuMicros();
+  uint32_t start = thread_clock.getMicros();
+  for (uint32_t i = 0; i < sensors; i++) {
+    event_loop.spawn(asyncSession(&event_loop, nodes[i].get()));
+  }
+  event_loop.run();
+  report("coroutines", sensors, 1, thread_clock.getMicros() - start,
+         cpuMicros() - cpu, nodes);
+}
+
+void runThreads(uint32_t sensors) {
+  std::vector<std::unique_ptr<Node> > nodes = makeNodes(sensors);
+  std::vector<std::thread> threads;
+  uint64_t cpu = cpuMicros();
+  uint32_t start = thread_clock.getMicros();
+  for (uint32_t i = 0; i < sensors; i++) {
+    threads.emplace_back(blockingSession, nodes[i].get());
+  }
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  report("threads", sensors, sensors, thread_clock.getMicros() - start,
+         cpuMicros() - cpu, nodes);
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("STHS34PF80 coroutine vs thread-per-sensor benchmark");
+
+  // Coroutines first: the peak RSS only ever grows
+  runAsync(SENSORS);
+  runThreads(SENSORS);
+  runAsync(SENSORS * SCALE_UP);
+}
+
+#else
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("This benchmark needs a Linux host and C++20");
+}
+
+#endif
+
+void loop() {}
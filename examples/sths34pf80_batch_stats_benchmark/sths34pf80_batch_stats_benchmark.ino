@@ -0,0 +1,130 @@
+// Batch statistics benchmark for STHS34PF80 sample streams
+//
+// Keeps a rolling window of one channel for many sensors and compares
+// Adafruit_STHS34PF80_BatchStats (incremental, vectorized where the CPU
+// allows) against the naive loop that rescans every sensor's window after
+// each new sample. Synthetic data, no sensor needed. Sizes are scaled down
+// on small boards.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_BatchStats.h"
+
+#if defined(__linux__)
+#define SENSORS 4096
+#define WINDOW 64
+#define ROWS 256
+#elif defined(__AVR__)
+#define SENSORS 8
+#define WINDOW 16
+#define ROWS 64
+#else
+#define SENSORS 64
+#define WINDOW 32
+#define ROWS 64
+#endif
+
+Adafruit_STHS34PF80_BatchStats batch;
+uint64_t storage[(SENSORS * (16 + 2 * WINDOW) + 7) / 8];
+int16_t history[WINDOW][SENSORS];
+int16_t row[SENSORS];
+int32_t checksum = 0;
+
+void makeRow() {
+  for (uint16_t s = 0; s < SENSORS; s++) {
+    row[s] = 200 + random(-50, 51);
+  }
+}
+
+void report(const char* name, float samples, uint32_t elapsed_us) {
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(elapsed_us);
+  Serial.print(" us, ");
+  Serial.print(samples / elapsed_us, 2);
+  Serial.println(" M samples/s");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.print("Sensors: ");
+  Serial.print(SENSORS);
+  Serial.print(" Window: ");
+  Serial.print(WINDOW);
+  Serial.print(" Vector kernels: ");
+  Serial.println(Adafruit_STHS34PF80_BatchStats::vectorized() ? "yes" : "no");
+
+  if (sizeof(storage) <
+      Adafruit_STHS34PF80_BatchStats::storageSize(SENSORS, WINDOW)) {
+    Serial.println("Storage too small");
+    while (1) delay(10);
+  }
+  batch.begin(storage, SENSORS, WINDOW);
+
+  // Naive: store the sample, then rescan each sensor's whole window
+  randomSeed(1);
+  uint32_t start = micros();
+  for (uint16_t r = 0; r < ROWS; r++) {
+    makeRow();
+    uint16_t n = r + 1 < WINDOW ? r + 1 : WINDOW;
+    for (uint16_t s = 0; s < SENSORS; s++) {
+      history[r % WINDOW][s] = row[s];
+      int16_t lo = 32767;
+      int16_t hi = -32768;
+      int32_t sum = 0;
+      int64_t sum_sq = 0;
+      for (uint16_t w = 0; w < n; w++) {
+        int16_t x = history[w][s];
+        lo = min(lo, x);
+        hi = max(hi, x);
+        sum += x;
+        sum_sq += (int32_t)x * x;
+      }
+      checksum += lo + hi + sum + (int32_t)sum_sq;
+    }
+  }
+  report("Naive per-sample loop", (float)SENSORS * ROWS, micros() - start);
+
+  // Batch: incremental sums on push, one vertical min/max pass per row
+  randomSeed(1);
+  start = micros();
+  for (uint16_t r = 0; r < ROWS; r++) {
+    makeRow();
+    batch.push(row);
+    const int16_t* lo = batch.minimums();
+    const int16_t* hi = batch.maximums();
+    for (uint16_t s = 0; s < SENSORS; s++) {
+      sths34pf80_stats_t stats;
+      batch.stats(s, &stats);
+      checksum -= lo[s] + hi[s] + stats.sum + (int32_t)stats.sum_sq;
+    }
+  }
+  report("BatchStats", (float)SENSORS * ROWS, micros() - start);
+
+  // Identical results leave the checksum at zero (row generation is timed
+  // in both runs)
+  Serial.print("Checksum (expect 0): ");
+  Serial.println(checksum);
+
+  // One long stream: vectorized reduce() against the scalar reference
+  sths34pf80_stats_t a, b;
+  start = micros();
+  for (uint16_t r = 0; r < ROWS; r++) {
+    Adafruit_STHS34PF80_BatchStats::reduceScalar(&history[0][0],
+                                                 WINDOW * SENSORS, &a);
+  }
+  report("Scalar reduce", (float)WINDOW * SENSORS * ROWS, micros() - start);
+  start = micros();
+  for (uint16_t r = 0; r < ROWS; r++) {
+    Adafruit_STHS34PF80_BatchStats::reduce(&history[0][0], WINDOW * SENSORS,
+                                           &b);
+  }
+  report("Vector reduce", (float)WINDOW * SENSORS * ROWS, micros() - start);
+  Serial.print("Mean: ");
+  Serial.print(Adafruit_STHS34PF80_BatchStats::mean(b), 2);
+  Serial.print(" Variance: ");
+  Serial.println(Adafruit_STHS34PF80_BatchStats::variance(b), 2);
+}
+
+void loop() {}
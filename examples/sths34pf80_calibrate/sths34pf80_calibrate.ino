@@ -0,0 +1,82 @@
+// Empty-room threshold calibration for the STHS34PF80
+//
+// Leave the room (or keep the sensor's field of view empty) while this runs.
+// About 60 seconds of baseline data is collected, presence and motion
+// thresholds are derived from its noise statistics, then programmed into
+// the sensor and verified.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Calibration.h"
+
+#define CALIBRATION_SAMPLES 480 // 60 seconds at 8 Hz
+
+Adafruit_STHS34PF80 sths;
+Adafruit_STHS34PF80_Calibration calibration(&sths);
+
+void printStats(const char* name, sths34pf80_noise_stats_t& stats) {
+  Serial.print(name);
+  Serial.print(" median: ");
+  Serial.print(stats.median);
+  Serial.print(" MAD: ");
+  Serial.print(stats.mad);
+  Serial.print(" sigma: ");
+  Serial.print(stats.sigma);
+  Serial.print(" p99 deviation: ");
+  Serial.println(stats.p99);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("Adafruit STHS34PF80 threshold calibration");
+
+  if (!sths.begin()) {
+    Serial.println("Could not find a valid STHS34PF80 sensor, check wiring!");
+    while (1) delay(10);
+  }
+
+  if (!sths.setOutputDataRate(STHS34PF80_ODR_8_HZ)) {
+    Serial.println("Failed to set ODR");
+    while (1) delay(10);
+  }
+
+  Serial.println("Collecting empty-room baseline, please stay out of view...");
+  sths34pf80_thresholds_t thresholds;
+  bool ok = calibration.run(CALIBRATION_SAMPLES, 120000, &thresholds);
+
+  sths34pf80_noise_stats_t stats;
+  calibration.getPresenceStats(&stats);
+  printStats("Presence", stats);
+  calibration.getMotionStats(&stats);
+  printStats("Motion", stats);
+
+  if (!ok) {
+    Serial.println("Calibration failed!");
+    while (1) delay(10);
+  }
+
+  Serial.print("Presence threshold: ");
+  Serial.print(thresholds.presence_threshold);
+  Serial.print(" hysteresis: ");
+  Serial.println(thresholds.presence_hysteresis);
+  Serial.print("Motion threshold: ");
+  Serial.print(thresholds.motion_threshold);
+  Serial.print(" hysteresis: ");
+  Serial.println(thresholds.motion_hysteresis);
+  Serial.println("Thresholds programmed and verified");
+}
+
+void loop() {
+  if (sths.isDataReady()) {
+    sths34pf80_sample_t sample;
+    sths.readSample(&sample);
+    Serial.print("Presence: ");
+    Serial.print(sample.presence);
+    Serial.print(sample.flags & STHS34PF80_PRES_FLAG ? " [PRESENT]" : "");
+    Serial.print(" Motion: ");
+    Serial.print(sample.motion);
+    Serial.println(sample.flags & STHS34PF80_MOT_FLAG ? " [MOTION]" : "");
+  }
+  delay(10);
+}
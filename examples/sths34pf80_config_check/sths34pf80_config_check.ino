@@ -0,0 +1,78 @@
+// Configuration audit for the STHS34PF80
+//
+// Dumps every register, decodes the device configuration, compares it
+// against the expected profile and prints the integrity hash. A fleet agent
+// can call readConfigHash() periodically and compare it against the hash of
+// the configuration it deployed, which costs one short I2C burst.
+
+#include "Adafruit_STHS34PF80.h"
+
+Adafruit_STHS34PF80 sths;
+
+const sths34pf80_profile_t expected = {
+    STHS34PF80_ODR_8_HZ, STHS34PF80_AVG_TMOS_32, STHS34PF80_AVG_T_8,
+    STHS34PF80_INT_OR, STHS34PF80_PRES_FLAG | STHS34PF80_MOT_FLAG, true};
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("Adafruit STHS34PF80 configuration check");
+
+  if (!sths.begin()) {
+    Serial.println("Could not find a valid STHS34PF80 sensor, check wiring!");
+    while (1) delay(10);
+  }
+
+  if (!sths.applyProfile(expected)) {
+    Serial.println("Failed to apply profile");
+    while (1) delay(10);
+  }
+
+  sths34pf80_dump_t dump;
+  if (!sths.dumpRegisters(&dump, true)) {
+    Serial.println("Register dump failed");
+    while (1) delay(10);
+  }
+
+  for (uint8_t i = 0; i < STHS34PF80_DUMP_LEN; i++) {
+    uint8_t reg = STHS34PF80_DUMP_FIRST_REG + i;
+    if (i % 8 == 0) {
+      Serial.println();
+      Serial.print("0x");
+      Serial.print(reg, HEX);
+      Serial.print(":");
+    }
+    Serial.print(" ");
+    if (dump.main[i] < 0x10) Serial.print("0");
+    Serial.print(dump.main[i], HEX);
+  }
+  Serial.println();
+
+  sths34pf80_device_config_t config;
+  Adafruit_STHS34PF80::decodeDump(dump, &config);
+  Serial.print("Presence threshold: ");
+  Serial.println(config.presence_threshold);
+  Serial.print("Motion threshold: ");
+  Serial.println(config.motion_threshold);
+  Serial.print("Sensitivity: ");
+  Serial.println(config.sensitivity);
+
+  uint32_t diff = Adafruit_STHS34PF80::diffProfile(config, expected);
+  Serial.print("Profile mismatches: 0x");
+  Serial.println(diff, HEX);
+
+  Serial.print("Decoded hash:  0x");
+  Serial.println(Adafruit_STHS34PF80::configHash(config), HEX);
+}
+
+void loop() {
+  uint32_t hash;
+  if (sths.readConfigHash(&hash)) {
+    Serial.print("Device hash:   0x");
+    Serial.println(hash, HEX);
+  } else {
+    Serial.println("Hash read failed");
+  }
+  delay(5000);
+}
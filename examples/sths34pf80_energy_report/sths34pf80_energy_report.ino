@@ -0,0 +1,136 @@
+// Energy and bus-cost report for the STHS34PF80
+//
+// Measures the bus cost of the driver calls on the connected sensor, then
+// estimates the hourly charge of polling, DRDY interrupt and one-shot
+// acquisition for a few configurations, with battery life for BATTERY_MAH.
+// Finally polls the sensor for VERIFY_MS and compares the counted bus
+// transactions with the estimate. Edit the system figures below to match
+// your board.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Energy.h"
+
+#define BATTERY_MAH 1000 // Usable battery capacity
+#define VERIFY_MS 5000   // Live polling check
+
+Adafruit_STHS34PF80 sths;
+Adafruit_STHS34PF80_Energy energy;
+
+const sths34pf80_odr_t odrs[] = {STHS34PF80_ODR_1_HZ, STHS34PF80_ODR_4_HZ,
+                                 STHS34PF80_ODR_8_HZ, STHS34PF80_ODR_30_HZ};
+const char* odr_names[] = {"1", "4", "8", "30"};
+const sths34pf80_avg_tmos_t avgs[] = {
+    STHS34PF80_AVG_TMOS_128, STHS34PF80_AVG_TMOS_32, STHS34PF80_AVG_TMOS_32,
+    STHS34PF80_AVG_TMOS_8};
+const char* avg_names[] = {"128", "32", "32", "8"};
+const char* strategy_names[] = {"polling", "DRDY int", "one-shot"};
+const char* api_names[] = {"isDataReady", "readSample", "readFuncStatus",
+                           "triggerOneshot"};
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 energy report");
+
+  if (!sths.begin()) {
+    Serial.println("Could not find a valid STHS34PF80 sensor, check wiring!");
+    while (1) delay(10);
+  }
+
+  // System figures: adjust to your MCU and bus
+  sths34pf80_energy_params_t params;
+  energy.getParams(&params);
+  params.supply_v = 3.3f;
+  params.mcu_active_ua = 3000;
+  params.mcu_sleep_ua = 5;
+  params.bus_hz = 100000;
+  params.pullup_ohms = 4700;
+  params.poll_ms = 10;
+  energy.setParams(params);
+
+  // Measure one-shot while powered down, the rest at the default 1 Hz
+  sths.setOutputDataRate(STHS34PF80_ODR_POWER_DOWN);
+  if (!energy.measure(&sths) || !sths.setOutputDataRate(STHS34PF80_ODR_1_HZ) ||
+      !energy.measure(&sths)) {
+    Serial.println("Measurement failed");
+    return;
+  }
+
+  Serial.println("\nMeasured bus cost per call:");
+  for (uint8_t api = 0; api < STHS34PF80_API_COUNT; api++) {
+    sths34pf80_bus_stats_t cost;
+    energy.getApiCost((sths34pf80_api_t)api, &cost);
+    Serial.print("  ");
+    Serial.print(api_names[api]);
+    Serial.print(": ");
+    Serial.print(cost.transactions);
+    Serial.print(" transactions, ");
+    Serial.print(cost.bytes);
+    Serial.print(" data bytes, ");
+    Serial.print(cost.bits);
+    Serial.println(" bits");
+  }
+
+  Serial.println("\nPer hour:");
+  Serial.println("ODR\tAVG\tstrategy\twakeups\ttrans\tawake ms\tsensor uAh\t"
+                 "MCU uAh\tbus uJ\ttotal uAh\tdays");
+  for (uint8_t c = 0; c < 4; c++) {
+    energy.setConfig(odrs[c], avgs[c], STHS34PF80_AVG_T_8);
+    for (uint8_t s = 0; s < 3; s++) {
+      sths34pf80_energy_report_t report;
+      if (!energy.estimate((sths34pf80_acq_strategy_t)s, &report)) {
+        continue;
+      }
+      Serial.print(odr_names[c]);
+      Serial.print("\t");
+      Serial.print(avg_names[c]);
+      Serial.print("\t");
+      Serial.print(strategy_names[s]);
+      Serial.print("\t");
+      Serial.print(report.wakeups, 0);
+      Serial.print("\t");
+      Serial.print(report.transactions, 0);
+      Serial.print("\t");
+      Serial.print(report.mcu_awake_ms, 0);
+      Serial.print("\t\t");
+      Serial.print(report.sensor_uah, 1);
+      Serial.print("\t\t");
+      Serial.print(report.mcu_uah, 1);
+      Serial.print("\t");
+      Serial.print(report.bus_uj, 0);
+      Serial.print("\t");
+      Serial.print(report.total_uah, 1);
+      Serial.print("\t\t");
+      Serial.println(
+          Adafruit_STHS34PF80_Energy::batteryHours(report, BATTERY_MAH) / 24,
+          0);
+    }
+  }
+
+  // Live check: poll at 1 Hz and count what actually went over the bus
+  energy.setConfig(STHS34PF80_ODR_1_HZ, sths.getObjAveraging(),
+                   sths.getAmbTempAveraging());
+  sths34pf80_energy_report_t expected;
+  energy.estimate(STHS34PF80_ACQ_POLLING, &expected);
+
+  sths34pf80_sample_t sample;
+  sths.resetBusStats();
+  uint32_t start = millis();
+  while (millis() - start < VERIFY_MS) {
+    if (sths.isDataReady()) {
+      sths.readSample(&sample);
+    }
+    delay(params.poll_ms);
+  }
+  sths34pf80_bus_stats_t live;
+  sths.getBusStats(&live);
+
+  Serial.print("\nLive polling: ");
+  Serial.print(live.transactions * 3600000.0f / VERIFY_MS, 0);
+  Serial.print(" transactions/h counted, ");
+  Serial.print(expected.transactions, 0);
+  Serial.println(" estimated");
+}
+
+void loop() {}
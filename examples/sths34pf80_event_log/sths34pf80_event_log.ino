@@ -0,0 +1,111 @@
+// Persistent presence event log for the STHS34PF80
+//
+// Logs presence and motion flag changes, threshold crossings and faults to
+// EEPROM. On start it prints every event that survived from before the
+// reset or power loss, then keeps logging. millis() restarts at zero on
+// every start, so log time continues from the newest stored event. The log
+// takes 4 pages of 128 bytes at the start of EEPROM, enough for about 160
+// flag changes before the oldest page is reused. On cores without an
+// EEPROM library (e.g. SAMD) the log lives in RAM and does not survive a
+// reset.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_EEPROMStorage.h"
+#include "Adafruit_STHS34PF80_EventLog.h"
+
+#define LOG_OFFSET 0  // First EEPROM byte of the log
+#define LOG_PAGES 4   // Pages in the ring
+#define LOG_PAGE 128  // Bytes per page
+#define SYNC_MS 60000 // Commit interval on cores that emulate EEPROM
+
+Adafruit_STHS34PF80 sths;
+#if defined(STHS34PF80_HAS_EEPROM)
+Adafruit_STHS34PF80_EEPROMStorage storage(LOG_OFFSET, LOG_PAGES, LOG_PAGE);
+#else
+uint8_t storage_buffer[LOG_PAGES * LOG_PAGE];
+Adafruit_STHS34PF80_MemoryStorage storage(storage_buffer,
+                                          sizeof(storage_buffer), LOG_PAGE);
+#endif
+Adafruit_STHS34PF80_EventLog events;
+uint32_t log_start_ms = 0; // Log time at millis() zero
+uint32_t last_sync = 0;
+
+void printEvent(const sths34pf80_log_event_t& event) {
+  Serial.print(event.timestamp_ms);
+  Serial.print(" ms: ");
+  if (event.type == STHS34PF80_LOG_FLAGS) {
+    Serial.print("flags");
+    if (event.code & STHS34PF80_PRES_FLAG) Serial.print(" PRESENCE");
+    if (event.code & STHS34PF80_MOT_FLAG) Serial.print(" MOTION");
+    if (event.code & STHS34PF80_TAMB_SHOCK_FLAG) Serial.print(" TAMB_SHOCK");
+    Serial.println();
+  } else if (event.type == STHS34PF80_LOG_CROSSING) {
+    Serial.print(event.code & STHS34PF80_LOG_RISING ? "rising " : "falling ");
+    Serial.print(event.code & 0x03);
+    Serial.print(" at ");
+    Serial.println(event.value);
+  } else {
+    Serial.print("fault ");
+    Serial.println(event.code);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 persistent event log");
+
+  // Reopens the log; blank or foreign bytes are not valid pages and are
+  // erased when the log reaches them
+#if defined(STHS34PF80_HAS_EEPROM)
+  if (!storage.begin() || !events.begin(&storage)) {
+#else
+  memset(storage_buffer, 0xFF, sizeof(storage_buffer));
+  if (!events.begin(&storage)) {
+#endif
+    Serial.println("Event log setup failed");
+    while (1) delay(10);
+  }
+
+  Serial.println("Events from before this start:");
+  sths34pf80_log_cursor_t cursor;
+  sths34pf80_log_event_t stored[8];
+  if (events.rewind(&cursor)) {
+    uint16_t n;
+    while ((n = events.read(&cursor, stored, 8)) > 0) {
+      for (uint16_t i = 0; i < n; i++) {
+        printEvent(stored[i]);
+      }
+    }
+  }
+  log_start_ms = events.lastTimestamp();
+
+  if (!sths.begin()) {
+    Serial.println("Failed to find STHS34PF80 chip");
+    events.logFault(log_start_ms + millis(), STHS34PF80_FAULT_BUS);
+    events.sync();
+    while (1) delay(10);
+  }
+  events.logFault(log_start_ms + millis(), STHS34PF80_FAULT_RESET);
+  events.setThresholds(1000, 500, 0);
+  Serial.println("Logging");
+}
+
+void loop() {
+  sths34pf80_sample_t sample;
+  if (sths.isDataReady() && sths.readSample(&sample)) {
+    uint8_t logged = events.record(log_start_ms + millis(), sample);
+    if (logged) {
+      Serial.print("Logged ");
+      Serial.print(logged);
+      Serial.println(logged == 1 ? " event" : " events");
+    }
+  }
+
+  if (millis() - last_sync >= SYNC_MS) {
+    events.sync();
+    last_sync = millis();
+  }
+  delay(10);
+}
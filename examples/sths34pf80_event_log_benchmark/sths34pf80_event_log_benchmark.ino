@@ -0,0 +1,142 @@
+// Event log benchmark for the STHS34PF80
+//
+// Feeds a synthetic day at 8 Hz (people walking past every few minutes,
+// motion bursts and the odd fault) through the event log and reports the
+// append throughput, the bytes per event against a raw 8-byte event and
+// the write amplification: log WA counts the page headers, file WA also
+// the erase fills of each new page. On Linux the log lives in a file,
+// accessed with pread/pwrite and then through mmap, each without and with
+// a sync after every event; elsewhere it lives in RAM. No sensor is
+// needed.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_EventLog.h"
+
+#define PAGE_SIZE 4096 // Flash sector size
+#define RAW_EVENT 8    // Timestamp, type, code and value, unpacked
+#define HOURS 24
+
+#if defined(__linux__)
+#define PAGES 64
+#define LOG_PATH "/tmp/sths34pf80_events.log"
+#else
+#define PAGES 2
+uint8_t storage_buffer[PAGES * PAGE_SIZE];
+#endif
+
+// Synthetic sample at time t (milliseconds)
+void makeSample(uint32_t t, sths34pf80_sample_t* s) {
+  uint32_t phase = t % 180000; // someone passes every three minutes
+  bool person = phase > 60000 && phase < 75000;
+  bool moving = (phase > 59000 && phase < 62000) ||
+                (phase > 73000 && phase < 76000);
+  s->presence = random(-40, 41) + (person ? 1200 : 0);
+  s->motion = random(-30, 31) + (moving ? 600 : 0);
+  s->temp_shock = random(-5, 6);
+  s->flags = (person ? STHS34PF80_PRES_FLAG : 0) |
+             (moving ? STHS34PF80_MOT_FLAG : 0);
+}
+
+void run(const char* name, Adafruit_STHS34PF80_LogStorage* storage,
+         bool sync_each) {
+  Adafruit_STHS34PF80_EventLog log;
+  if (!log.begin(storage) || !log.format()) {
+    Serial.println("Log setup failed");
+    return;
+  }
+  log.setThresholds(600, 300, 0);
+  sths34pf80_log_stats_t formatted;
+  log.getStats(&formatted);
+#if defined(__linux__)
+  uint64_t file_before =
+      ((Adafruit_STHS34PF80_FileStorage*)storage)->bytesWritten();
+#endif
+
+  randomSeed(1);
+  sths34pf80_sample_t sample;
+  uint32_t busy_us = 0;
+  for (uint32_t t = 0; t < HOURS * 3600000UL; t += 125) {
+    makeSample(t, &sample);
+    uint32_t start = micros();
+    uint8_t logged = log.record(t, sample);
+    if (t % 3600000UL == 1800000UL) {
+      log.logFault(t, STHS34PF80_FAULT_TIMEOUT);
+      logged++;
+    }
+    if (logged && sync_each) {
+      log.sync();
+    }
+    if (logged) {
+      busy_us += micros() - start;
+    }
+  }
+
+  sths34pf80_log_stats_t stats;
+  log.getStats(&stats);
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(stats.events);
+  Serial.print(" events, ");
+  Serial.print((float)busy_us / stats.events, 2);
+  Serial.print(" us/event, ");
+  Serial.print((float)stats.record_bytes / stats.events, 2);
+  Serial.print(" B/event (raw ");
+  Serial.print(RAW_EVENT);
+  Serial.print("), log WA ");
+  Serial.print((float)(stats.record_bytes + stats.header_bytes) /
+                   stats.record_bytes,
+               3);
+#if defined(__linux__)
+  Serial.print(", file WA ");
+  uint64_t file_bytes =
+      ((Adafruit_STHS34PF80_FileStorage*)storage)->bytesWritten() -
+      file_before;
+  Serial.print((float)file_bytes / stats.record_bytes, 3);
+#endif
+  Serial.print(", erases ");
+  Serial.println(stats.erases - formatted.erases);
+
+  // Backfill the last hour, as after a reconnect
+  sths34pf80_log_cursor_t cursor;
+  sths34pf80_log_event_t events[32];
+  uint32_t found = 0;
+  uint32_t start = micros();
+  if (log.seek((HOURS - 1) * 3600000UL, &cursor)) {
+    uint16_t n;
+    while ((n = log.read(&cursor, events, 32)) > 0) {
+      found += n;
+    }
+  }
+  Serial.print("  last hour: ");
+  Serial.print(found);
+  Serial.print(" events read in ");
+  Serial.print(micros() - start);
+  Serial.println(" us");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 event log benchmark");
+
+#if defined(__linux__)
+  Adafruit_STHS34PF80_FileStorage file;
+  const bool mapped[] = {false, true};
+  const char* names[] = {"pwrite", "pwrite+sync", "mmap", "mmap+sync"};
+  for (uint8_t i = 0; i < 4; i++) {
+    if (!file.begin(LOG_PATH, PAGES, PAGE_SIZE, mapped[i / 2])) {
+      Serial.println("Could not open " LOG_PATH);
+      return;
+    }
+    run(names[i], &file, i % 2);
+    file.end();
+  }
+#else
+  Adafruit_STHS34PF80_MemoryStorage memory(storage_buffer,
+                                           sizeof(storage_buffer), PAGE_SIZE);
+  run("RAM", &memory, false);
+#endif
+}
+
+void loop() {}
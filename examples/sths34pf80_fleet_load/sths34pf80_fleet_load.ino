@@ -0,0 +1,141 @@
+// Fleet-scale gateway capacity planning for the STHS34PF80
+//
+// Simulates FLEET sensors at one ODR, spread over buses of 1 to
+// MAX_PER_BUS sensors each, for every bus speed, through the real driver
+// and the gateway's polling step. Prints bus utilisation, sample loss,
+// latency percentiles (conversion to sample read) and host CPU per sensor,
+// then searches for the most sensors one bus carries with at most
+// MAX_LOSS of the samples lost, the 99th percentile latency within one
+// period and the bus busy at most 80% of the time. The search stops at
+// the 64 sensors a TCA9548A mux tree reaches; the sweep goes past that to
+// show the trend. No sensor is needed.
+//
+// Bus overhead per transfer and kernel CPU per transfer are estimates:
+// measure them on the gateway (e.g. time a few thousand STATUS reads) and
+// set them in the config before trusting the saturation point.
+//
+// Linux only.
+
+#include "Adafruit_STHS34PF80.h"
+
+#if defined(__linux__)
+
+#include "Adafruit_STHS34PF80_LoadSim.h"
+#include "Adafruit_STHS34PF80_Model.h"
+
+#define ODR STHS34PF80_ODR_8_HZ // Output data rate of every sensor
+#define FLEET 2048              // Sensors simulated in each sweep row
+#define MAX_PER_BUS 256         // Largest sensor count per bus
+#define MAX_LOSS 0.001f         // Acceptable fraction of lost samples
+#define DURATION_MS 10000       // Measured simulated time per run
+
+const uint32_t bus_speeds[] = {100000, 400000, 1000000};
+
+Adafruit_STHS34PF80_LoadSim load;
+
+void printRow(uint32_t bus_hz, uint32_t per_bus, uint32_t buses,
+              const sths34pf80_load_result_t& result) {
+  Serial.print(bus_hz / 1000);
+  Serial.print("\t");
+  Serial.print(per_bus);
+  Serial.print("\t");
+  Serial.print(buses);
+  Serial.print("\t");
+  Serial.print(100 * result.utilisation, 1);
+  Serial.print("\t");
+  Serial.print(100 * result.loss, 2);
+  Serial.print("\t");
+  Serial.print(result.latency_p50_us / 1000.0f, 2);
+  Serial.print("\t");
+  Serial.print(result.latency_p99_us / 1000.0f, 2);
+  Serial.print("\t");
+  Serial.print(result.latency_max_us / 1000.0f, 2);
+  Serial.print("\t");
+  Serial.print(result.cpu_us_per_sensor_s, 1);
+  Serial.print("\t");
+  Serial.println(result.wall_s, 2);
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("STHS34PF80 fleet load simulation");
+
+  sths34pf80_load_config_t config;
+  Adafruit_STHS34PF80_LoadSim::defaults(&config);
+  config.odr = ODR;
+  config.duration_ms = DURATION_MS;
+  uint32_t period_us = 1000000.0f / Adafruit_STHS34PF80_Model::odrHz(ODR);
+
+  Serial.print(FLEET);
+  Serial.print(" sensors at ");
+  Serial.print(Adafruit_STHS34PF80_Model::odrHz(ODR));
+  Serial.print(" Hz, ");
+  Serial.print(config.overhead_us);
+  Serial.print(" us bus overhead and ");
+  Serial.print(config.kernel_us);
+  Serial.println(" us kernel CPU per transfer");
+  Serial.println("kHz\tper bus\tbuses\tbusy %\tloss %\tp50 ms\tp99 ms\t"
+                 "max ms\tCPU us/sensor/s\twall s");
+
+  for (uint8_t s = 0; s < sizeof(bus_speeds) / sizeof(bus_speeds[0]); s++) {
+    config.bus_hz = bus_speeds[s];
+    for (uint32_t per_bus = 1; per_bus <= MAX_PER_BUS; per_bus *= 2) {
+      sths34pf80_load_result_t result;
+      config.sensors_per_bus = per_bus;
+      config.buses = FLEET / per_bus;
+      if (!load.run(config, &result)) {
+        Serial.println("Run failed");
+        continue;
+      }
+      printRow(config.bus_hz, per_bus, config.buses, result);
+      if (result.loss > 10 * MAX_LOSS) {
+        break; // well past saturation
+      }
+    }
+  }
+
+  Serial.println();
+  Serial.print("Saturation (loss <= ");
+  Serial.print(100 * MAX_LOSS, 2);
+  Serial.print(" %, p99 <= ");
+  Serial.print(period_us / 1000.0f, 1);
+  Serial.print(" ms, busy <= ");
+  Serial.print(100 * STHS34PF80_LOADSIM_MAX_BUSY, 0);
+  Serial.print(" %, mux limit ");
+  Serial.print(STHS34PF80_LOADSIM_MUX_LIMIT);
+  Serial.println("):");
+  for (uint8_t s = 0; s < sizeof(bus_speeds) / sizeof(bus_speeds[0]); s++) {
+    config.bus_hz = bus_speeds[s];
+    uint32_t per_bus = load.saturation(config, MAX_LOSS, period_us);
+
+    sths34pf80_load_result_t result;
+    config.sensors_per_bus = per_bus ? per_bus : 1;
+    config.buses = 1;
+    load.run(config, &result);
+
+    Serial.print(config.bus_hz / 1000);
+    Serial.print(" kHz: ");
+    Serial.print(per_bus);
+    Serial.print(" sensors per bus (");
+    if (per_bus == STHS34PF80_LOADSIM_MUX_LIMIT) {
+      Serial.print("mux limit, ");
+    }
+    Serial.print(100 * result.utilisation, 1);
+    Serial.print(" % busy), ");
+    Serial.print((FLEET + per_bus - 1) / (per_bus ? per_bus : 1));
+    Serial.print(" buses for the fleet, ");
+    Serial.print(1e6f / result.cpu_us_per_sensor_s, 0);
+    Serial.println(" sensors per CPU core");
+  }
+}
+
+#else
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("This simulation needs a Linux host");
+}
+
+#endif
+
+void loop() {}
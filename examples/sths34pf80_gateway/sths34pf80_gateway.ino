@@ -0,0 +1,137 @@
+// Sharing STHS34PF80 sensors between threads with the gateway
+//
+// Four simulated sensors on two buses are handed to an
+// Adafruit_STHS34PF80_Gateway, which polls them from one worker thread per
+// bus. While the main thread reads the latest samples without locking, two
+// client threads change output data rates, apply profiles and run custom
+// calls through the workers. After stop() every call is refused. No
+// sensor is needed; the simulated sensors run in real time.
+//
+// Linux only.
+
+#include "Adafruit_STHS34PF80.h"
+
+#if defined(__linux__)
+
+#include <thread>
+
+#include "Adafruit_STHS34PF80_Gateway.h"
+#include "Adafruit_STHS34PF80_Sim.h"
+
+#define SENSORS 4     // Two per bus
+#define RUN_MS 2000   // Time the clients run
+#define REPORT_MS 500 // Sample count report interval
+
+Adafruit_STHS34PF80_Sim sims[SENSORS];
+Adafruit_STHS34PF80 sensors[SENSORS];
+Adafruit_STHS34PF80_Gateway gateway;
+int ids[SENSORS];
+
+// Custom call: runs on the bus worker with exclusive access to the bus
+bool readAmbient(Adafruit_STHS34PF80* sensor, void* context) {
+  *(float*)context = sensor->readAmbientTemperature();
+  return true;
+}
+
+// Client thread: switches every sensor between 4 Hz and 15 Hz
+void odrClient() {
+  for (uint8_t round = 0; round < 10; round++) {
+    sths34pf80_odr_t odr =
+        round & 1 ? STHS34PF80_ODR_4_HZ : STHS34PF80_ODR_15_HZ;
+    for (uint8_t i = 0; i < SENSORS; i++) {
+      if (!gateway.setOutputDataRate(ids[i], odr)) {
+        Serial.println("setOutputDataRate failed");
+      }
+    }
+    delay(RUN_MS / 10);
+  }
+}
+
+// Client thread: applies a profile and reads ambient through the workers
+void profileClient() {
+  sths34pf80_profile_t profile = {STHS34PF80_ODR_8_HZ,
+                                  STHS34PF80_AVG_TMOS_32,
+                                  STHS34PF80_AVG_T_8,
+                                  STHS34PF80_INT_DRDY,
+                                  0x07,
+                                  false};
+  for (uint8_t round = 0; round < 10; round++) {
+    uint8_t i = round % SENSORS;
+    float ambient = 0;
+    if (!gateway.applyProfile(ids[i], profile) ||
+        !gateway.call(ids[i], readAmbient, &ambient)) {
+      Serial.println("Profile client call failed");
+    }
+    delay(RUN_MS / 10);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("STHS34PF80 gateway (simulated sensors)");
+
+  int buses[2] = {gateway.addBus(), gateway.addBus()};
+  for (uint8_t i = 0; i < SENSORS; i++) {
+    if (!sensors[i].begin(sims[i].device())) {
+      Serial.println("Simulated sensor failed to start");
+      while (1) delay(10);
+    }
+    ids[i] = gateway.addSensor(buses[i % 2], &sensors[i]);
+  }
+
+  if (!gateway.start()) {
+    Serial.println("Gateway failed to start");
+    while (1) delay(10);
+  }
+
+  std::thread odr_thread(odrClient);
+  std::thread profile_thread(profileClient);
+
+  for (uint32_t t = 0; t < RUN_MS; t += REPORT_MS) {
+    delay(REPORT_MS);
+    Serial.print("Samples:");
+    for (uint8_t i = 0; i < SENSORS; i++) {
+      sths34pf80_snapshot_t snapshot;
+      Serial.print(" ");
+      if (gateway.latest(ids[i], &snapshot)) {
+        Serial.print(snapshot.count);
+      } else {
+        Serial.print("-");
+      }
+    }
+    Serial.println();
+  }
+
+  odr_thread.join();
+  profile_thread.join();
+  gateway.stop();
+
+  for (uint8_t b = 0; b < 2; b++) {
+    Serial.print("Bus ");
+    Serial.print(b);
+    Serial.print(": ");
+    Serial.print(gateway.busRequests(buses[b]));
+    Serial.print(" requests, ");
+    Serial.print(gateway.busErrors(buses[b]));
+    Serial.println(" errors");
+  }
+
+  // Nothing runs the calls any more, so they are refused instead of hanging
+  Serial.print("After stop(): running ");
+  Serial.print(gateway.running() ? "yes" : "no");
+  Serial.print(", setOutputDataRate ");
+  Serial.println(gateway.setOutputDataRate(ids[0], STHS34PF80_ODR_1_HZ)
+                     ? "accepted"
+                     : "refused");
+}
+
+#else
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("The gateway needs a Linux host");
+}
+
+#endif
+
+void loop() {}
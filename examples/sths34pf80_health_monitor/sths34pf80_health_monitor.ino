@@ -0,0 +1,84 @@
+// Streaming health monitor for the STHS34PF80
+//
+// Checks every sample for a stuck, saturated or noisy object channel, for
+// samples arriving late for the ODR, and for an implausible ambient
+// temperature, and prints the findings whenever they change. The noise
+// estimate is printed every 10 seconds next to the limit for the
+// configured averaging.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Health.h"
+
+Adafruit_STHS34PF80 sths;
+Adafruit_STHS34PF80_Health health;
+
+uint8_t last_status = STHS34PF80_HEALTH_OK;
+uint32_t last_report = 0;
+
+void printStatus(uint8_t status) {
+  if (status == STHS34PF80_HEALTH_OK) {
+    Serial.print(" OK");
+  }
+  if (status & STHS34PF80_HEALTH_STUCK) {
+    Serial.print(" stuck");
+  }
+  if (status & STHS34PF80_HEALTH_SATURATED) {
+    Serial.print(" saturated");
+  }
+  if (status & STHS34PF80_HEALTH_NOISY) {
+    Serial.print(" noisy");
+  }
+  if (status & STHS34PF80_HEALTH_CADENCE) {
+    Serial.print(" late samples");
+  }
+  if (status & STHS34PF80_HEALTH_AMBIENT) {
+    Serial.print(" ambient implausible");
+  }
+  Serial.println();
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 health monitor");
+
+  if (!sths.begin()) {
+    Serial.println("Could not find a valid STHS34PF80 sensor, check wiring!");
+    while (1) delay(10);
+  }
+
+  if (!sths.setOutputDataRate(STHS34PF80_ODR_4_HZ)) {
+    Serial.println("Failed to set ODR");
+    while (1) delay(10);
+  }
+  health.configure(&sths);
+}
+
+void loop() {
+  if (sths.isDataReady()) {
+    sths34pf80_sample_t sample;
+    if (sths.readSample(&sample)) {
+      health.update(sample, millis());
+    }
+  }
+  uint8_t status = health.check(millis());
+
+  if (status != last_status) {
+    Serial.print("Health:");
+    printStatus(status);
+    last_status = status;
+  }
+
+  if (millis() - last_report >= 10000) {
+    last_report = millis();
+    Serial.print("Noise: ");
+    Serial.print(health.noise());
+    Serial.print(" LSB, missed samples: ");
+    Serial.print(health.missedSamples());
+    Serial.print(", seen:");
+    printStatus(health.latched());
+    health.clearLatched();
+  }
+  delay(5);
+}
@@ -0,0 +1,192 @@
+// Detection latency benchmark for the STHS34PF80
+//
+// Runs the real driver against a simulated sensor on a simulated clock
+// and injects step, ramp and walking-person stimuli after a quiet period.
+// For each ODR, AVG_TMOS and presence LPF setting it reports the detection
+// latency percentiles from stimulus start next to the model's step
+// latency for the filters read back from the sensor, the missed
+// detections, the false detections per hour of empty scene and the bus
+// traffic of the polling read path. No sensor is needed.
+//
+// The simulated noise and filter figures are estimates: use the results to
+// compare settings, then confirm the chosen one on hardware.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Model.h"
+#include "Adafruit_STHS34PF80_Sim.h"
+
+#define TRIALS 20         // Stimuli per configuration
+#define QUIET_MS 60000    // Empty scene before each stimulus
+#define STIMULUS_MS 10000 // Stimulus length (ramp rise time 5 s)
+#define RECOVER_MS 30000  // Empty scene after each stimulus, not scored
+#define POLL_MS 5         // isDataReady() polling interval
+#define AMPLITUDE 500     // Peak TOBJECT change in LSB
+
+Adafruit_STHS34PF80_SimClock sim_clock;
+Adafruit_STHS34PF80_Sim sim(&sim_clock);
+Adafruit_STHS34PF80 sths;
+
+const sths34pf80_odr_t odrs[] = {STHS34PF80_ODR_1_HZ, STHS34PF80_ODR_4_HZ,
+                                 STHS34PF80_ODR_8_HZ, STHS34PF80_ODR_15_HZ};
+const char* odr_names[] = {"1", "4", "8", "15"};
+const sths34pf80_avg_tmos_t avgs[] = {
+    STHS34PF80_AVG_TMOS_8, STHS34PF80_AVG_TMOS_32, STHS34PF80_AVG_TMOS_128};
+const char* avg_names[] = {"8", "32", "128"};
+const sths34pf80_lpf_config_t lpfs[] = {STHS34PF80_LPF_ODR_DIV_9,
+                                        STHS34PF80_LPF_ODR_DIV_20,
+                                        STHS34PF80_LPF_ODR_DIV_50};
+const char* lpf_names[] = {"9", "20", "50"};
+const sths34pf80_stimulus_t stimuli[] = {STHS34PF80_STIMULUS_STEP,
+                                         STHS34PF80_STIMULUS_RAMP,
+                                         STHS34PF80_STIMULUS_WALK};
+const char* stimulus_names[] = {"step", "ramp", "walk"};
+
+// Detection decision for one sample; replace to score your own
+// post-processing instead of the sensor's presence flag
+bool detect(const sths34pf80_sample_t& sample) {
+  return sample.flags & STHS34PF80_PRES_FLAG;
+}
+
+uint32_t nowMs() { return (uint32_t)(sim_clock.now() / 1000); }
+
+// Poll the sensor until the given time, returning the time of the first
+// rising detection edge (0 for none) and counting all rising edges
+uint32_t runUntil(uint32_t end_ms, bool* detected, uint32_t* edges) {
+  uint32_t first = 0;
+  sths34pf80_sample_t sample;
+  while ((int32_t)(nowMs() - end_ms) < 0) {
+    sim_clock.advance(POLL_MS * 1000UL);
+    if (!sths.isDataReady() || !sths.readSample(&sample)) {
+      continue;
+    }
+    bool now_detected = detect(sample);
+    if (now_detected && !*detected) {
+      (*edges)++;
+      if (!first) {
+        first = nowMs();
+      }
+    }
+    *detected = now_detected;
+  }
+  return first;
+}
+
+uint32_t percentile(const uint32_t* sorted, uint8_t count, uint8_t pct) {
+  if (!count) {
+    return 0;
+  }
+  return sorted[(count * pct + 99) / 100 - 1];
+}
+
+void runConfig(sths34pf80_stimulus_t stimulus, uint8_t s, uint8_t o,
+               uint8_t a, uint8_t l) {
+  if (!sths.begin(sim.device()) || !sths.setObjAveraging(avgs[a]) ||
+      !sths.setPresenceLowPassFilter(lpfs[l]) ||
+      !sths.setOutputDataRate(odrs[o])) {
+    Serial.println("Configuration failed");
+    return;
+  }
+  // What the sensor actually runs, LPF_P_M and LPF_P included
+  sths34pf80_config_t config;
+  Adafruit_STHS34PF80_Model::readConfig(&sths, &config);
+  float model_ms = 1000 * Adafruit_STHS34PF80_Model::presenceLatencyS(config);
+
+  sim.setSeed(1 + o * 100 + a * 10 + l);
+  randomSeed(s);
+  sim.setStimulus(STHS34PF80_STIMULUS_NONE, 0, 0, 0);
+  sim.resetBusStats();
+
+  uint32_t latencies[TRIALS];
+  uint8_t hits = 0;
+  uint32_t false_edges = 0;
+  uint32_t start_ms = nowMs();
+  bool detected = false;
+
+  for (uint8_t trial = 0; trial < TRIALS; trial++) {
+    // Random onset, so it falls anywhere between two conversions
+    uint32_t onset = nowMs() + QUIET_MS + random(1000);
+    uint32_t edges = 0;
+    runUntil(onset, &detected, &false_edges);
+
+    sim.setStimulus(stimulus, AMPLITUDE, onset,
+                    stimulus == STHS34PF80_STIMULUS_RAMP ? STIMULUS_MS / 2
+                                                         : STIMULUS_MS);
+    uint32_t end = onset + STIMULUS_MS;
+    if (stimulus == STHS34PF80_STIMULUS_WALK) {
+      end += 2 * 1500; // walking in and out
+    }
+    uint32_t hit = runUntil(end, &detected, &edges);
+    if (hit) {
+      latencies[hits++] = hit - onset;
+    }
+
+    sim.setStimulus(STHS34PF80_STIMULUS_NONE, 0, 0, 0);
+    runUntil(nowMs() + RECOVER_MS, &detected, &edges);
+  }
+
+  // Insertion sort, TRIALS is small
+  for (uint8_t i = 1; i < hits; i++) {
+    uint32_t v = latencies[i];
+    uint8_t j = i;
+    for (; j > 0 && latencies[j - 1] > v; j--) {
+      latencies[j] = latencies[j - 1];
+    }
+    latencies[j] = v;
+  }
+
+  sths34pf80_bus_stats_t bus;
+  sim.getBusStats(&bus);
+  float seconds = (nowMs() - start_ms) / 1000.0f;
+  float quiet_hours = TRIALS * (QUIET_MS / 3600000.0f);
+
+  Serial.print(stimulus_names[s]);
+  Serial.print("\t");
+  Serial.print(odr_names[o]);
+  Serial.print("\t");
+  Serial.print(avg_names[a]);
+  Serial.print("\t");
+  Serial.print(lpf_names[l]);
+  Serial.print("\t");
+  Serial.print(percentile(latencies, hits, 50));
+  Serial.print("\t");
+  Serial.print(percentile(latencies, hits, 90));
+  Serial.print("\t");
+  Serial.print(percentile(latencies, hits, 99));
+  Serial.print("\t");
+  Serial.print(model_ms, 0);
+  Serial.print("\t");
+  Serial.print(100.0f * (TRIALS - hits) / TRIALS, 1);
+  Serial.print("\t");
+  Serial.print(false_edges / quiet_hours, 1);
+  Serial.print("\t");
+  Serial.print(bus.bytes / seconds, 1);
+  Serial.print("\t");
+  Serial.println(bus.bits / seconds, 0);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 detection latency benchmark (simulated)");
+  Serial.println("Latency in ms from stimulus start, FP per hour of empty "
+                 "scene, bus per second of polling");
+  Serial.println("stim\tODR Hz\tAVG\tLPF_P\tp50\tp90\tp99\tmodel\t"
+                 "FN %\tFP/h\tbus B/s\tbus bit/s");
+
+  for (uint8_t s = 0; s < 3; s++) {
+    for (uint8_t o = 0; o < 4; o++) {
+      for (uint8_t a = 0; a < 3; a++) {
+        if (odrs[o] > Adafruit_STHS34PF80_Model::maxOdr(avgs[a])) {
+          continue; // not a valid combination
+        }
+        for (uint8_t l = 0; l < 3; l++) {
+          runConfig(stimuli[s], s, o, a, l);
+        }
+      }
+    }
+  }
+  Serial.println("Done");
+}
+
+void loop() {}
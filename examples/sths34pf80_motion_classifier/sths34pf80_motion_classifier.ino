@@ -0,0 +1,50 @@
+// Tell people from fans, curtains and HVAC vents using the TMOTION spectrum
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_MotionClassifier.h"
+
+Adafruit_STHS34PF80 sths;
+Adafruit_STHS34PF80_MotionClassifier classifier;
+
+const char* classNames[] = {"none", "person", "periodic", "slow", "other"};
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("Adafruit STHS34PF80 motion classifier");
+
+  if (!sths.begin()) {
+    Serial.println("Could not find a valid STHS34PF80 sensor, check wiring!");
+    while (1) delay(10);
+  }
+
+  // 30 Hz needs the lowest object averaging
+  sths.setObjAveraging(STHS34PF80_AVG_TMOS_32);
+  sths.setOutputDataRate(STHS34PF80_ODR_30_HZ);
+}
+
+void loop() {
+  if (!sths.isDataReady()) {
+    return;
+  }
+
+  sths34pf80_sample_t sample;
+  if (!sths.readSample(&sample)) {
+    return;
+  }
+
+  if (!classifier.addSample(sample.motion, sample.presence)) {
+    return;
+  }
+
+  // A new window every 8 samples, bin N is N * 30 / 32 Hz
+  Serial.print("Class: ");
+  Serial.print(classNames[classifier.classification()]);
+  Serial.print(" Peak bin: ");
+  Serial.print(classifier.peakBin());
+  Serial.print(" Energy: ");
+  Serial.print(classifier.feature(STHS34PF80_FEAT_ENERGY) / 16.0, 1);
+  Serial.print(" Swing: ");
+  Serial.println(classifier.feature(STHS34PF80_FEAT_PRESENCE_SWING));
+}
@@ -0,0 +1,135 @@
+// Aligning STHS34PF80 sensors with skewed clocks onto one time grid
+//
+// Two simulated sensors run on their own oscillators, one 2% fast at 15 Hz
+// and one 1.5% slow at 4 Hz, and are polled from a host loop with a few
+// milliseconds of jitter. Both see the same linear TOBJECT ramp, so the
+// value Adafruit_STHS34PF80_Resampler interpolates at a grid point tells
+// how far off in time it is. Prints each sensor's nominal and estimated
+// period, its drift and the mean and worst timing error of its grid
+// output; the mean is mostly the delay between a conversion and the poll
+// that reads it, which the host timestamps include. No sensor is needed.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Resampler.h"
+#include "Adafruit_STHS34PF80_Sim.h"
+
+#define RUN_MS 40000      // Simulated run
+#define WARMUP_MS 10000   // Not scored while the estimates converge
+#define RAMP_MS 50000     // Ramp length, past the end of the run
+#define RAMP_LSB 30000    // TOBJECT rise over the ramp
+#define POLL_US 5000      // Host poll interval, plus up to 3 ms jitter
+#define GRID_US 50000     // Output grid period
+#define LATENCY_US 200000 // How long a grid point waits for samples
+
+// A sensor oscillator running off the host clock by a fixed ppm
+class SkewedClock : public Adafruit_STHS34PF80_Clock {
+ public:
+  SkewedClock(Adafruit_STHS34PF80_SimClock* host, int32_t ppm)
+      : _host(host), _ppm(ppm) {}
+  uint32_t getMicros() { return (uint32_t)sensorMicros(_host->now()); }
+  uint32_t getMillis() {
+    return (uint32_t)(sensorMicros(_host->now()) / 1000);
+  }
+  void delayMillis(uint32_t ms) { _host->delayMillis(ms); }
+  uint64_t sensorMicros(uint64_t host_us) {
+    return host_us + (int64_t)host_us * _ppm / 1000000;
+  }
+
+ private:
+  Adafruit_STHS34PF80_SimClock* _host;
+  int32_t _ppm;
+};
+
+const int32_t skew_ppm[2] = {20000, -15000};
+const sths34pf80_odr_t odrs[2] = {STHS34PF80_ODR_15_HZ, STHS34PF80_ODR_4_HZ};
+
+Adafruit_STHS34PF80_SimClock host_clock;
+SkewedClock sensor_clocks[2] = {SkewedClock(&host_clock, skew_ppm[0]),
+                                SkewedClock(&host_clock, skew_ppm[1])};
+Adafruit_STHS34PF80_Sim sims[2] = {
+    Adafruit_STHS34PF80_Sim(&sensor_clocks[0]),
+    Adafruit_STHS34PF80_Sim(&sensor_clocks[1])};
+Adafruit_STHS34PF80 sensors[2];
+Adafruit_STHS34PF80_Resampler<2> resampler(GRID_US, LATENCY_US);
+
+float error_sum_ms[2];
+float error_max_ms[2];
+uint32_t scored[2];
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 resampling of skewed sensor clocks (simulated)");
+
+  for (uint8_t i = 0; i < 2; i++) {
+    sims[i].setNoiseScale(0);
+    sims[i].setStimulus(STHS34PF80_STIMULUS_RAMP, RAMP_LSB, 0, RAMP_MS);
+    sensors[i].setClock(&host_clock);
+    if (!sensors[i].begin(sims[i].device()) ||
+        !sensors[i].setOutputDataRate(odrs[i])) {
+      Serial.println("Simulated sensor failed to start");
+      while (1) delay(10);
+    }
+    resampler.setSensorOdr(i, odrs[i]);
+  }
+
+  randomSeed(1);
+  while (host_clock.now() < RUN_MS * 1000ULL) {
+    host_clock.advance(POLL_US + random(3000));
+    uint32_t now = (uint32_t)host_clock.now();
+
+    for (uint8_t i = 0; i < 2; i++) {
+      sths34pf80_sample_t sample;
+      if (sensors[i].isDataReady() && sensors[i].readSample(&sample)) {
+        resampler.push(i, now, sample);
+      }
+    }
+
+    while (resampler.ready(now)) {
+      uint32_t grid = resampler.gridTime();
+      for (uint8_t i = 0; i < 2; i++) {
+        sths34pf80_sample_t aligned;
+        if (grid < WARMUP_MS * 1000UL ||
+            resampler.sample(i, &aligned) !=
+                STHS34PF80_RESAMPLE_INTERPOLATED) {
+          continue;
+        }
+        // The ramp runs on the sensor's clock: where it stands at the grid
+        // point, and how long the ramp takes to cover the difference
+        float expected = (float)RAMP_LSB *
+                         sensor_clocks[i].sensorMicros(grid) /
+                         (RAMP_MS * 1000.0f);
+        float error_ms =
+            (aligned.object - expected) * RAMP_MS / (float)RAMP_LSB;
+        error_sum_ms[i] += error_ms;
+        if (fabsf(error_ms) > error_max_ms[i]) {
+          error_max_ms[i] = fabsf(error_ms);
+        }
+        scored[i]++;
+      }
+      resampler.advance();
+    }
+  }
+
+  Serial.println("sensor\tskew ppm\tperiod us\testimated\tdrift ppm\t"
+                 "mean error ms\tworst ms");
+  for (uint8_t i = 0; i < 2; i++) {
+    Serial.print(i);
+    Serial.print("\t");
+    Serial.print(skew_ppm[i]);
+    Serial.print("\t\t");
+    Serial.print(
+        (uint32_t)(1000000 / Adafruit_STHS34PF80_Model::odrHz(odrs[i])));
+    Serial.print("\t\t");
+    Serial.print(resampler.periodMicros(i));
+    Serial.print("\t\t");
+    Serial.print(resampler.driftPpm(i));
+    Serial.print("\t\t");
+    Serial.print(scored[i] ? error_sum_ms[i] / scored[i] : 0, 2);
+    Serial.print("\t\t");
+    Serial.println(error_max_ms[i], 2);
+  }
+}
+
+void loop() {}
@@ -0,0 +1,81 @@
+// SENS_DATA sensitivity calibration for the STHS34PF80
+//
+// Run this with the final window or lens fitted. Fill the sensor's field
+// of view with a target of known temperature (a blackbody source, or a
+// matte surface held at REFERENCE_C and checked with a contact
+// thermometer), 5 to about 15 degC away from the ambient temperature:
+// closer is noisy, further saturates the object output. The object signal
+// is averaged, the effective sensitivity is fitted and programmed into
+// SENS_DATA, and a second window checks the result.
+// SENS_DATA is volatile: store the printed value and write it with
+// setSensitivity() after every begin().
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Calibration.h"
+
+#define REFERENCE_C 35.0f      // Reference target temperature
+#define CALIBRATION_SAMPLES 80 // 10 seconds at 8 Hz per window
+
+Adafruit_STHS34PF80 sths;
+Adafruit_STHS34PF80_SensitivityCalibration calibration(&sths);
+
+const char* status_names[] = {
+    "OK",           "timeout",
+    "low contrast", "out of range",
+    "write failed", "residual above tolerance",
+    "saturated, move the reference closer to ambient"};
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("Adafruit STHS34PF80 sensitivity calibration");
+
+  if (!sths.begin()) {
+    Serial.println("Could not find a valid STHS34PF80 sensor, check wiring!");
+    while (1) delay(10);
+  }
+
+  if (!sths.setOutputDataRate(STHS34PF80_ODR_8_HZ)) {
+    Serial.println("Failed to set ODR");
+    while (1) delay(10);
+  }
+
+  Serial.println("Measuring the reference target...");
+  sths34pf80_sens_cal_t result;
+  calibration.run(REFERENCE_C, CALIBRATION_SAMPLES, 30000, &result);
+
+  Serial.print("Ambient: ");
+  Serial.print(result.ambient_c);
+  Serial.print(" C, TOBJECT: ");
+  Serial.print(result.object_lsb, 1);
+  Serial.print(" +/- ");
+  Serial.print(result.noise_lsb, 1);
+  Serial.println(" LSB");
+  Serial.print("Effective sensitivity: ");
+  Serial.print(result.sensitivity, 1);
+  Serial.println(" LSB/C");
+  Serial.print("SENS_DATA: ");
+  Serial.print(result.previous);
+  Serial.print(" -> ");
+  Serial.println(result.sens_data);
+  Serial.print("Object temperature error: ");
+  Serial.print(result.error_c, 2);
+  Serial.print(" C before, ");
+  Serial.print(result.residual_c, 2);
+  Serial.println(" C after");
+  Serial.print("Status: ");
+  Serial.println(status_names[result.status]);
+}
+
+void loop() {
+  if (sths.isDataReady()) {
+    sths34pf80_sample_t sample;
+    sths.readSample(&sample);
+    Serial.print("Object: ");
+    Serial.print(Adafruit_STHS34PF80_SensitivityCalibration::objectTemperature(
+        sample.object, sample.ambient / 100.0f, sths.getSensitivity()));
+    Serial.println(" C");
+  }
+  delay(10);
+}
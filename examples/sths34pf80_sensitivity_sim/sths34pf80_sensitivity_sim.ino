@@ -0,0 +1,98 @@
+// SENS_DATA sensitivity calibration against a simulated STHS34PF80
+//
+// A simulated sensor behind a window that passes 70% of the object signal
+// looks at a 35 degC reference in a 25 degC room. The sketch runs the same
+// calibration as the sensitivity calibration example and checks that the
+// SENS_DATA written to the sensor is the code for the attenuated
+// sensitivity, that the object temperature error is within the tolerance
+// afterwards, and that the verify step does fail once SENS_DATA is set
+// back to the factory trim. No sensor is needed.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Calibration.h"
+#include "Adafruit_STHS34PF80_Model.h"
+#include "Adafruit_STHS34PF80_Sim.h"
+
+#define REFERENCE_C 35.0f      // Reference target temperature
+#define AMBIENT_C 25.0f        // Room and sensor temperature
+#define TRANSMISSION 0.7f      // Window transmission
+#define TRUE_SENS 2000.0f      // Bare part sensitivity, LSB/degC
+#define CALIBRATION_SAMPLES 80 // 10 seconds at 8 Hz per window
+
+Adafruit_STHS34PF80_SimClock sim_clock;
+Adafruit_STHS34PF80_Sim sim(&sim_clock);
+Adafruit_STHS34PF80 sths;
+Adafruit_STHS34PF80_SensitivityCalibration calibration(&sths);
+
+bool failed = false;
+
+void check(bool ok, const char* what) {
+  Serial.print(ok ? "PASS " : "FAIL ");
+  Serial.println(what);
+  failed |= !ok;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 sensitivity calibration check (simulated)");
+
+  sim.setSensitivity(TRUE_SENS);
+  sim.setTransmission(TRANSMISSION);
+  sim.setScene(REFERENCE_C, AMBIENT_C);
+  sths.setClock(&sim_clock);
+  if (!sths.begin(sim.device()) ||
+      !sths.setOutputDataRate(STHS34PF80_ODR_8_HZ)) {
+    Serial.println("Simulated sensor failed to start");
+    while (1) delay(10);
+  }
+
+  sths34pf80_sens_cal_t result;
+  calibration.run(REFERENCE_C, CALIBRATION_SAMPLES, 30000, &result);
+
+  int8_t expected =
+      Adafruit_STHS34PF80_Model::sensData(TRANSMISSION * TRUE_SENS);
+  uint8_t written;
+  sim.readRegisters(STHS34PF80_REG_SENS_DATA, &written, 1);
+
+  Serial.print("Effective sensitivity: ");
+  Serial.print(result.sensitivity, 1);
+  Serial.print(" LSB/C, SENS_DATA ");
+  Serial.print(result.previous);
+  Serial.print(" -> ");
+  Serial.print(result.sens_data);
+  Serial.print(" (expected ");
+  Serial.print(expected);
+  Serial.print(", register holds ");
+  Serial.print((int8_t)written);
+  Serial.println(")");
+  Serial.print("Object temperature error: ");
+  Serial.print(result.error_c, 2);
+  Serial.print(" C before, ");
+  Serial.print(result.residual_c, 2);
+  Serial.println(" C after");
+
+  check(result.status == STHS34PF80_SENS_CAL_OK, "calibration succeeded");
+  check(result.sens_data >= expected - 1 && result.sens_data <= expected + 1,
+        "fitted SENS_DATA matches the window");
+  check((int8_t)written == result.sens_data, "SENS_DATA register written");
+  check(fabsf(result.residual_c) <= STHS34PF80_SENS_CAL_TOLERANCE &&
+            fabsf(result.residual_c) < fabsf(result.error_c) / 10,
+        "residual within the tolerance");
+
+  // A mis-programmed SENS_DATA must not pass the verify step
+  float residual = 0;
+  sths.setSensitivity(result.previous);
+  sths34pf80_sens_cal_status_t status =
+      calibration.verify(REFERENCE_C, CALIBRATION_SAMPLES, 30000, &residual);
+  Serial.print("With the factory trim back: ");
+  Serial.print(residual, 2);
+  Serial.println(" C error");
+  check(status == STHS34PF80_SENS_CAL_RESIDUAL,
+        "verify rejects the factory trim");
+
+  Serial.println(failed ? "FAILED" : "All checks passed");
+}
+
+void loop() {}
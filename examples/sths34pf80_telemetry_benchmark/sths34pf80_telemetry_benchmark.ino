@@ -0,0 +1,102 @@
+// Telemetry frame size benchmark for the STHS34PF80
+//
+// Encodes one minute of synthetic data (drifting temperatures, sensor
+// noise and a person walking past) at every ODR, in frames of up to
+// BATCH samples that must fit a PAYLOAD byte radio packet, and compares
+// the total against hand-packed raw samples. No sensor is needed.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Model.h"
+#include "Adafruit_STHS34PF80_Telemetry.h"
+
+#define BATCH 32      // Samples buffered before a frame is sent
+#define PAYLOAD 222   // Largest radio payload, e.g. LoRaWAN DR5
+#define RAW_SAMPLE 13 // Six int16 values plus one flag byte
+
+const sths34pf80_odr_t rates[] = {
+    STHS34PF80_ODR_0_25_HZ, STHS34PF80_ODR_0_5_HZ, STHS34PF80_ODR_1_HZ,
+    STHS34PF80_ODR_2_HZ,    STHS34PF80_ODR_4_HZ,   STHS34PF80_ODR_8_HZ,
+    STHS34PF80_ODR_15_HZ,   STHS34PF80_ODR_30_HZ};
+
+sths34pf80_sample_t batch[BATCH];
+uint8_t frame[PAYLOAD];
+
+// One sample of the synthetic scene at time t (seconds)
+void makeSample(float t, sths34pf80_sample_t* s) {
+  bool person = t > 20 && t < 35;
+  s->ambient = 2350 + (int16_t)(t * 2) + random(-1, 2);
+  s->object = 1200 + (int16_t)(t * 3) + random(-4, 5) + (person ? 900 : 0);
+  s->obj_comp = 150 + random(-3, 4) + (person ? 850 : 0);
+  s->presence = random(-6, 7) + (person ? 800 : 0);
+  s->motion = random(-10, 11) + ((t > 19 && t < 22) ? 400 : 0);
+  s->temp_shock = random(-2, 3);
+  s->flags = (person ? STHS34PF80_PRES_FLAG : 0) |
+             ((t > 19 && t < 22) ? STHS34PF80_MOT_FLAG : 0);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 telemetry frame size per minute");
+  Serial.println("ODR Hz, samples, raw bytes, frames, frame bytes, % of raw");
+
+  // The hash a sensor in this configuration reports with readConfigHash()
+  sths34pf80_config_t acquisition = {
+      STHS34PF80_ODR_1_HZ,       STHS34PF80_AVG_TMOS_32,
+      STHS34PF80_AVG_T_8,        STHS34PF80_LPF_ODR_DIV_9,
+      STHS34PF80_LPF_ODR_DIV_20, STHS34PF80_LPF_ODR_DIV_50,
+      STHS34PF80_LPF_ODR_DIV_100};
+  sths34pf80_device_config_t config;
+  memset(&config, 0, sizeof(config));
+  config.acquisition = acquisition;
+
+  for (uint8_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+    float hz = Adafruit_STHS34PF80_Model::odrHz(rates[r]);
+    uint16_t total = (uint16_t)(60 * hz);
+    uint32_t period_ms = (uint32_t)(1000 / hz);
+
+    config.acquisition.odr = rates[r];
+    sths34pf80_frame_info_t info;
+    info.channels = STHS34PF80_TELEMETRY_ALL;
+    info.config_hash = Adafruit_STHS34PF80::configHash(config);
+    info.period_ms = period_ms;
+
+    randomSeed(1);
+    uint16_t produced = 0;
+    uint16_t buffered = 0;
+    uint32_t frames = 0;
+    uint32_t bytes = 0;
+    while (produced < total || buffered) {
+      while (buffered < BATCH && produced < total) {
+        makeSample(produced / hz, &batch[buffered++]);
+        produced++;
+      }
+
+      // Send as many buffered samples as fit in one packet
+      info.timestamp_ms = (uint32_t)(produced - buffered) * period_ms;
+      uint16_t n =
+          Adafruit_STHS34PF80_Telemetry::fit(batch, buffered, info, PAYLOAD);
+      bytes += Adafruit_STHS34PF80_Telemetry::encode(batch, n, info, frame,
+                                                     PAYLOAD);
+      frames++;
+      memmove(batch, batch + n, (buffered - n) * sizeof(batch[0]));
+      buffered -= n;
+    }
+
+    uint32_t raw = (uint32_t)total * RAW_SAMPLE;
+    Serial.print(hz, 2);
+    Serial.print(", ");
+    Serial.print(total);
+    Serial.print(", ");
+    Serial.print(raw);
+    Serial.print(", ");
+    Serial.print(frames);
+    Serial.print(", ");
+    Serial.print(bytes);
+    Serial.print(", ");
+    Serial.println(100.0 * bytes / raw, 1);
+  }
+}
+
+void loop() {}
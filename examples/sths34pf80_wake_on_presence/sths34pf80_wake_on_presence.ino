@@ -0,0 +1,112 @@
+// Wake-on-presence demo for the STHS34PF80
+//
+// The sensor idles in a low-power watch profile with a latched presence
+// interrupt on INT. Once someone walks in, the coordinator switches to the
+// fast active profile and reports how long it took to get the first sample.
+// Replace the idle loop with your board's sleep call to save power.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_WakeCoordinator.h"
+
+#define INT_PIN 2            // Wire the breakout INT pin here
+#define ACTIVE_TIME_MS 10000 // Stay awake this long after the last presence
+
+Adafruit_STHS34PF80 sths;
+Adafruit_STHS34PF80_WakeCoordinator coordinator(&sths);
+
+volatile bool woke = false;
+volatile uint32_t wake_micros = 0;
+uint32_t last_presence = 0;
+bool latency_reported = false;
+
+void onIntPin() {
+  // While active, INT carries DRDY; only a presence edge counts as a wake
+  if (coordinator.state() != STHS34PF80_WAKE_WATCHING) {
+    return;
+  }
+  woke = true;
+  wake_micros = micros();
+}
+
+// Enter watch mode and drop wake-ups seen before it, keeping one that
+// arrived meanwhile: the latched INT would not give another edge
+bool watch() {
+  if (!coordinator.enterWatchMode()) {
+    return false;
+  }
+  noInterrupts();
+  woke = false;
+  interrupts();
+  if (digitalRead(INT_PIN) == HIGH) {
+    noInterrupts();
+    woke = true;
+    wake_micros = micros();
+    interrupts();
+  }
+  return true;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("Adafruit STHS34PF80 wake-on-presence demo");
+
+  if (!sths.begin()) {
+    Serial.println("Could not find a valid STHS34PF80 sensor, check wiring!");
+    while (1) delay(10);
+  }
+
+  // Keep INT at its power-on setting, active high push-pull: the latched
+  // presence interrupt holds it high, so wake on the rising edge
+  if (!sths.setIntPolarity(false) || !sths.setIntOpenDrain(false)) {
+    Serial.println("Failed to configure INT");
+    while (1) delay(10);
+  }
+  pinMode(INT_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(INT_PIN), onIntPin, RISING);
+
+  if (!watch()) {
+    Serial.println("Failed to enter watch mode");
+    while (1) delay(10);
+  }
+  Serial.println("Watching...");
+}
+
+void loop() {
+  if (coordinator.state() == STHS34PF80_WAKE_WATCHING) {
+    if (!woke) {
+      delay(10); // Sleep here on a battery node
+      return;
+    }
+    noInterrupts();
+    woke = false;
+    uint32_t wake_at = wake_micros;
+    interrupts();
+    coordinator.onWake(wake_at);
+    latency_reported = false;
+    last_presence = millis();
+    Serial.println("Woke up!");
+    return;
+  }
+
+  if (coordinator.poll()) {
+    if (!latency_reported) {
+      latency_reported = true;
+      Serial.print("Wake to first sample: ");
+      Serial.print(coordinator.wakeLatencyMicros());
+      Serial.println(" us");
+    }
+
+    Serial.print("Presence: ");
+    Serial.println(sths.readPresence());
+    if (sths.isPresence()) {
+      last_presence = millis();
+    }
+  }
+
+  if (millis() - last_presence > ACTIVE_TIME_MS) {
+    Serial.println("Room empty, back to watch mode");
+    watch();
+  }
+}
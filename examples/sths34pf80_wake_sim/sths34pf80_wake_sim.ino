@@ -0,0 +1,153 @@
+// Wake-on-presence check against a simulated STHS34PF80
+//
+// Runs Adafruit_STHS34PF80_WakeCoordinator against a simulated sensor, its
+// INT line and a simulated clock on which every bus access takes one short
+// I2C transfer. Two people walk in, stay and leave, one after the other.
+// The sketch checks that the INT line wakes the coordinator once per
+// person, that the wake-to-first-sample latency is the profile switch plus
+// one active ODR period (give or take a poll), and that the coordinator
+// returns to watching once the room is empty, with INT released and no
+// stale wake-up. No sensor is needed.
+//
+// The switch itself is not free: leaving the watch profile runs the safe
+// power-down, which waits for the pending watch-mode conversion, so it can
+// take up to one watch period. Every switch also restarts the presence
+// algorithm, which takes whoever is in view as background, so stay awake
+// longer than a visit rather than until the presence flag drops.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_Model.h"
+#include "Adafruit_STHS34PF80_Sim.h"
+#include "Adafruit_STHS34PF80_WakeCoordinator.h"
+
+#define POLL_US 1000          // Host loop step
+#define TRANSFER_US 100       // One register transfer at 400 kHz
+#define WALK_LSB 3000         // TOBJECT rise of the person
+#define STAY_MS 8000          // Time the person stays
+#define FIRST_MS 5000         // First person walks in
+#define SECOND_MS 40000       // Second person walks in
+#define RUN_MS 60000          // Simulated run
+#define ACTIVE_TIME_MS 12000  // Stay awake this long after the last flag
+
+Adafruit_STHS34PF80_SimClock sim_clock;
+Adafruit_STHS34PF80_Sim sim(&sim_clock);
+Adafruit_STHS34PF80 sths;
+Adafruit_STHS34PF80_WakeCoordinator coordinator(&sths);
+
+bool intLine() { return sim.intLine(); }
+
+bool failed = false;
+
+void check(bool ok, const char* what) {
+  Serial.print(ok ? "PASS " : "FAIL ");
+  Serial.println(what);
+  failed |= !ok;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 wake-on-presence check (simulated)");
+
+  sths.setClock(&sim_clock);
+  coordinator.setInterruptLine(intLine);
+  if (!sths.begin(sim.device()) || !coordinator.enterWatchMode()) {
+    Serial.println("Simulated sensor failed to start");
+    while (1) delay(10);
+  }
+  // Every bus access from here on costs one transfer
+  sim_clock.setReadStep(TRANSFER_US);
+
+  uint32_t period_us =
+      1000000.0f / Adafruit_STHS34PF80_Model::odrHz(STHS34PF80_ODR_15_HZ);
+  uint8_t wakes = 0;
+  bool stale_wake = false;
+  uint32_t watch_ms = 0;
+  uint32_t last_presence = 0;
+
+  sim.setStimulus(STHS34PF80_STIMULUS_WALK, WALK_LSB, FIRST_MS, STAY_MS);
+  while (sim_clock.now() < RUN_MS * 1000ULL) {
+    sim_clock.advance(POLL_US);
+    uint32_t now_ms = (uint32_t)(sim_clock.now() / 1000);
+    if (now_ms >= SECOND_MS - 1000 && now_ms < SECOND_MS) {
+      sim.setStimulus(STHS34PF80_STIMULUS_WALK, WALK_LSB, SECOND_MS,
+                      STAY_MS);
+    }
+
+    if (coordinator.state() == STHS34PF80_WAKE_WATCHING) {
+      if (!coordinator.wakePending()) {
+        continue;
+      }
+      // Someone in view is a real wake-up, anything else a stale one
+      uint32_t t = now_ms;
+      if ((t < FIRST_MS || t > FIRST_MS + STAY_MS + 3000) &&
+          (t < SECOND_MS || t > SECOND_MS + STAY_MS + 3000)) {
+        stale_wake = true;
+      }
+
+      sths34pf80_bus_stats_t before, after;
+      sim.getBusStats(&before);
+      uint64_t switch_start = sim_clock.now();
+      if (!coordinator.onWake()) {
+        check(false, "onWake");
+        break;
+      }
+      uint32_t switch_us = (uint32_t)(sim_clock.now() - switch_start);
+      sim.getBusStats(&after);
+      wakes++;
+      last_presence = now_ms;
+
+      Serial.print("Wake ");
+      Serial.print(wakes);
+      Serial.print(" at ");
+      Serial.print(t);
+      Serial.print(" ms, flags 0x");
+      Serial.print(coordinator.wakeFlags(), HEX);
+      Serial.print(", profile switch ");
+      Serial.print(switch_us);
+      Serial.print(" us (");
+      Serial.print(after.transactions - before.transactions);
+      Serial.println(" transfers)");
+
+      // Wait for the first active sample
+      while (!coordinator.poll()) {
+        sim_clock.advance(POLL_US);
+      }
+      uint32_t latency = coordinator.wakeLatencyMicros();
+      Serial.print("  wake to first sample ");
+      Serial.print(latency);
+      Serial.print(" us, expected ");
+      Serial.print(switch_us + period_us);
+      Serial.print(" to ");
+      Serial.print(switch_us + period_us + POLL_US + 2 * TRANSFER_US);
+      Serial.println(" us");
+      check(latency >= switch_us + period_us &&
+                latency <= switch_us + period_us + POLL_US + 2 * TRANSFER_US,
+            "latency is the switch plus one active ODR period");
+      continue;
+    }
+
+    if (coordinator.poll()) {
+      sths34pf80_sample_t sample;
+      if (sths.readSample(&sample) &&
+          (sample.flags & (STHS34PF80_PRES_FLAG | STHS34PF80_MOT_FLAG))) {
+        last_presence = now_ms;
+      }
+    }
+    if (now_ms - last_presence > ACTIVE_TIME_MS) {
+      check(coordinator.enterWatchMode() &&
+                coordinator.state() == STHS34PF80_WAKE_WATCHING,
+            "back to watch mode once the room is empty");
+      check(!sim.intLine(), "INT released on entering watch mode");
+      watch_ms = now_ms;
+    }
+  }
+
+  check(wakes == 2, "one wake-up per person");
+  check(!stale_wake, "no stale wake-up");
+  check(watch_ms > SECOND_MS, "watching at the end of the run");
+  Serial.println(failed ? "FAILED" : "All checks passed");
+}
+
+void loop() {}
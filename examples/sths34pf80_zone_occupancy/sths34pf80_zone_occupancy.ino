@@ -0,0 +1,72 @@
+// Zone occupancy from several STHS34PF80 sensors
+//
+// Four sensors cover two zones: a corridor that sensors 0 and 1 each see
+// half of (split coverage) and a room that sensors 2 and 3 both see all of
+// (double coverage). A scripted person walks down the corridor, from the
+// half sensor 0 sees into the half sensor 1 sees, then into the room and
+// out again. Each second the samples go into
+// Adafruit_STHS34PF80_ZoneAggregator, which prints the zone estimates and
+// the ENTER / LEAVE events: the split corridor counts one person, not
+// half, and the doubly covered room counts one person, not two.
+//
+// The samples are generated here, no sensor is needed; on real sensors
+// feed setSample() from readSample() instead.
+
+#include "Adafruit_STHS34PF80.h"
+#include "Adafruit_STHS34PF80_ZoneAggregator.h"
+
+#define CORRIDOR 0
+#define ROOM 1
+#define PERSON_LSB 1000 // TPRESENCE one person gives (the default level)
+
+Adafruit_STHS34PF80_ZoneAggregator<4, 2> zones;
+
+// Where the person is at each second: 0 nowhere, 1 corridor west half,
+// 2 corridor east half, 3 room
+const uint8_t script[] = {0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 3, 0, 0, 0};
+
+const char* eventNames[] = {"", "ENTER", "LEAVE", "PASS_THROUGH"};
+
+void feed(uint8_t sensor, bool sees_person) {
+  zones.setSample(sensor, sees_person ? PERSON_LSB : 0,
+                  sees_person ? STHS34PF80_PRES_FLAG : 0);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("STHS34PF80 zone occupancy");
+
+  zones.addCoverage(0, CORRIDOR, 128); // west half
+  zones.addCoverage(1, CORRIDOR, 128); // east half
+  zones.addCoverage(2, ROOM, 256);
+  zones.addCoverage(3, ROOM, 256);
+
+  Serial.println("t s\tcorridor\troom");
+  for (uint8_t t = 0; t < sizeof(script); t++) {
+    uint8_t where = script[t];
+    feed(0, where == 1);
+    feed(1, where == 2);
+    feed(2, where == 3);
+    feed(3, where == 3);
+    zones.process(t * 1000UL);
+
+    Serial.print(t);
+    Serial.print("\t");
+    Serial.print(zones.zoneEstimate(CORRIDOR) / 256.0f, 2);
+    Serial.print("\t\t");
+    Serial.println(zones.zoneEstimate(ROOM) / 256.0f, 2);
+
+    sths34pf80_zone_event_t event;
+    while (zones.readEvent(&event)) {
+      Serial.print("  ");
+      Serial.print(eventNames[event.type]);
+      Serial.print(event.zone == CORRIDOR ? " corridor" : " room");
+      Serial.print(", count ");
+      Serial.println(event.count);
+    }
+  }
+}
+
+void loop() {}